@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Heap allocation counting. Built with ARBISIM_ALLOC_TRACKING, the program's global
+// operator new/delete (defined once, by ARBISIM_DEFINE_COUNTING_ALLOCATOR() at global
+// scope in the program's main source) count every allocation per thread and in total;
+// AllocScope reads the calling thread's count around a region. Without the flag the
+// macro expands to nothing and every count reads 0.
+
+namespace arbisim
+{
+    namespace alloc
+    {
+#ifdef ARBISIM_ALLOC_TRACKING
+        constexpr bool TRACKING = true;
+#else
+        constexpr bool TRACKING = false;
+#endif
+
+        struct AllocCounts
+        {
+            uint64_t allocations = 0;
+            uint64_t deallocations = 0;
+            uint64_t bytes = 0;
+        };
+
+        // Constant-initialised and trivially destructible, so safe to touch from operator new
+        inline AllocCounts &thread_counts()
+        {
+            static thread_local AllocCounts counts;
+            return counts;
+        }
+
+        inline std::atomic<uint64_t> total_allocations{0};
+        inline std::atomic<uint64_t> total_bytes{0};
+
+        inline void note_alloc(size_t size)
+        {
+            AllocCounts &counts = thread_counts();
+            counts.allocations++;
+            counts.bytes += size;
+            total_allocations.fetch_add(1, std::memory_order_relaxed);
+            total_bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        inline void note_free()
+        {
+            thread_counts().deallocations++;
+        }
+
+        // Allocations the calling thread makes between construction and the read
+        class AllocScope
+        {
+        private:
+            AllocCounts start_;
+
+        public:
+            AllocScope() : start_(thread_counts()) {}
+
+            uint64_t allocations() const { return thread_counts().allocations - start_.allocations; }
+            uint64_t bytes() const { return thread_counts().bytes - start_.bytes; }
+        };
+
+        inline void *aligned_allocate(size_t size, size_t alignment)
+        {
+#ifdef _MSC_VER
+            return _aligned_malloc(size ? size : 1, alignment);
+#else
+            size_t rounded = (size + alignment - 1) / alignment * alignment;
+            return std::aligned_alloc(alignment, rounded ? rounded : alignment);
+#endif
+        }
+
+        inline void aligned_free(void *p)
+        {
+#ifdef _MSC_VER
+            _aligned_free(p);
+#else
+            // Only ever reached from the replacement aligned operator delete, whose memory came from aligned_alloc
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+            std::free(p);
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+        }
+    } // namespace alloc
+
+} // namespace arbisim
+
+#ifdef ARBISIM_ALLOC_TRACKING
+#define ARBISIM_DEFINE_COUNTING_ALLOCATOR()                                                         \
+    void *operator new(std::size_t size)                                                            \
+    {                                                                                               \
+        arbisim::alloc::note_alloc(size);                                                           \
+        if (void *p = std::malloc(size ? size : 1))                                                 \
+            return p;                                                                               \
+        throw std::bad_alloc();                                                                     \
+    }                                                                                               \
+    void *operator new[](std::size_t size) { return ::operator new(size); }                         \
+    void *operator new(std::size_t size, std::align_val_t align)                                    \
+    {                                                                                               \
+        arbisim::alloc::note_alloc(size);                                                           \
+        if (void *p = arbisim::alloc::aligned_allocate(size, static_cast<std::size_t>(align)))      \
+            return p;                                                                               \
+        throw std::bad_alloc();                                                                     \
+    }                                                                                               \
+    void *operator new[](std::size_t size, std::align_val_t align) { return ::operator new(size, align); } \
+    void operator delete(void *p) noexcept                                                          \
+    {                                                                                               \
+        if (!p)                                                                                     \
+            return;                                                                                 \
+        arbisim::alloc::note_free();                                                                \
+        std::free(p);                                                                               \
+    }                                                                                               \
+    void operator delete[](void *p) noexcept { ::operator delete(p); }                              \
+    void operator delete(void *p, std::size_t) noexcept { ::operator delete(p); }                   \
+    void operator delete[](void *p, std::size_t) noexcept { ::operator delete(p); }                 \
+    void operator delete(void *p, std::align_val_t) noexcept                                        \
+    {                                                                                               \
+        if (!p)                                                                                     \
+            return;                                                                                 \
+        arbisim::alloc::note_free();                                                                \
+        arbisim::alloc::aligned_free(p);                                                            \
+    }                                                                                               \
+    void operator delete[](void *p, std::align_val_t align) noexcept { ::operator delete(p, align); } \
+    void operator delete(void *p, std::size_t, std::align_val_t align) noexcept { ::operator delete(p, align); } \
+    void operator delete[](void *p, std::size_t, std::align_val_t align) noexcept { ::operator delete(p, align); }
+#else
+#define ARBISIM_DEFINE_COUNTING_ALLOCATOR()
+#endif
@@ -5,8 +5,14 @@
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <algorithm>
+#include <cstddef>
+#include "cache_line.h"
+#include "fee_schedule.h"
+#include "simd_levels.h"
+#include "tsc_clock.h"
 
 namespace arbisim
 {
@@ -20,11 +26,10 @@ namespace arbisim
         return std::chrono::high_resolution_clock::now();
     }
 
+    // Epoch ns. Read it once per stage and pass it down rather than re-reading it.
     inline uint64_t timestamp_ns()
     {
-        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                                         std::chrono::high_resolution_clock::now().time_since_epoch())
-                                         .count());
+        return TscClock::instance().now_ns();
     }
 
     // Market data structures
@@ -36,6 +41,7 @@ namespace arbisim
 
         PriceLevel() = default;
         PriceLevel(double p, double q) : price(p), quantity(q), timestamp_ns(arbisim::timestamp_ns()) {}
+        PriceLevel(double p, double q, uint64_t ts) : price(p), quantity(q), timestamp_ns(ts) {}
     };
 
     struct MarketUpdate
@@ -54,122 +60,161 @@ namespace arbisim
         double quantity;
         uint64_t timestamp_ns;
         uint64_t sequence_id;
+        uint64_t trace_id = 0;    // PipelineTracer id, set on entry to the engine (0 = untraced)
+        uint64_t enqueued_ns = 0; // Traced updates only: when the engine queued it
 
         MarketUpdate() = default;
         MarketUpdate(Type t, const std::string &sym, const std::string &exch,
                      double p, double q, uint64_t seq = 0)
             : type(t), symbol(sym), exchange(exch), price(p), quantity(q),
               timestamp_ns(arbisim::timestamp_ns()), sequence_id(seq) {}
+        // Explicit stamp, so updates produced together share one clock read
+        MarketUpdate(Type t, const std::string &sym, const std::string &exch,
+                     double p, double q, uint64_t seq, uint64_t ts)
+            : type(t), symbol(sym), exchange(exch), price(p), quantity(q),
+              timestamp_ns(ts), sequence_id(seq) {}
     };
 
     // Lock-free order book (simplified for speed)
     class FastOrderBook
     {
-    private:
+    public:
         static constexpr size_t MAX_LEVELS = 10;
+        // Level arrays are padded to whole 4-wide vectors, so kernels can work past depth
+        static constexpr size_t PADDED_LEVELS = (MAX_LEVELS + 3) / 4 * 4;
 
-        struct BookSide
+    private:
+        // Each side starts its own cache line, with the count and stamp beside the best
+        // price so a BBO read costs one line per side; a write to one side never
+        // invalidates the other side or the names. Levels are stored as parallel arrays,
+        // best first, so the level search streams prices alone (see simd_levels.h).
+        struct alignas(CACHE_LINE_SIZE) BookSide
         {
-            std::array<PriceLevel, MAX_LEVELS> levels;
             std::atomic<size_t> count{0};
             mutable std::atomic<uint64_t> last_update_ns{0};
+            alignas(32) std::array<double, PADDED_LEVELS> price{};
+            std::array<double, PADDED_LEVELS> quantity{};
+            std::array<double, PADDED_LEVELS> cum_qty{}; // cum_qty[i] = quantity at levels [0, i]
+            std::array<uint64_t, PADDED_LEVELS> timestamp_ns{};
         };
+        static_assert(offsetof(BookSide, price) + sizeof(double) <= CACHE_LINE_SIZE,
+                      "count, stamp and best price must share the side's first line");
+        static_assert(sizeof(BookSide) % CACHE_LINE_SIZE == 0, "a side must not share its last line");
 
-        BookSide bids_;
-        BookSide asks_;
+        // Read-only after construction, compared by every book lookup; on the book's
+        // first line, which no update writes
         std::string symbol_;
         std::string exchange_;
+        BookSide bids_;
+        BookSide asks_;
 
-    public:
-        explicit FastOrderBook(const std::string &symbol, const std::string &exchange)
-            : symbol_(symbol), exchange_(exchange) {}
-
-        // Update bid side (thread-safe for single writer)
-        void update_bid(double price, double quantity)
+        // Insert, modify or (quantity <= 0) delete a level; bids sort highest first, asks
+        // lowest first. ts_ns stamps the touched level and the side. Kernels is one of the
+        // simd:: kernel sets.
+        template <bool Bids, typename Kernels>
+        static ARBISIM_ALWAYS_INLINE void update_side(BookSide &side, double price, double quantity, uint64_t ts_ns)
         {
-            auto &bids = bids_;
-            size_t count = bids.count.load();
+            size_t count = side.count.load();
+            size_t i = Kernels::template find_level<Bids>(side.price.data(), count, price);
 
-            // Find insertion point or update existing
-            for (size_t i = 0; i < count; ++i)
+            if (i < count && side.price[i] == price)
             {
-                if (bids.levels[i].price == price)
+                if (quantity <= 0.0)
                 {
-                    // Update existing level
-                    bids.levels[i].quantity = quantity;
-                    bids.levels[i].timestamp_ns = arbisim::timestamp_ns();
-                    bids.last_update_ns.store(arbisim::timestamp_ns());
-                    return;
+                    // Delete level, shift others up
+                    Kernels::template erase<PADDED_LEVELS>(side.price.data(), i, count);
+                    Kernels::template erase<PADDED_LEVELS>(side.quantity.data(), i, count);
+                    Kernels::template erase<PADDED_LEVELS>(side.timestamp_ns.data(), i, count);
+                    side.count.store(count - 1);
+                    Kernels::template prefix_sum<PADDED_LEVELS>(side.quantity.data(), side.cum_qty.data(), i, count - 1);
                 }
-                else if (bids.levels[i].price < price)
+                else
                 {
-                    // Insert here, shift others down
-                    for (size_t j = std::min(count, MAX_LEVELS - 1); j > i; --j)
-                    {
-                        bids.levels[j] = bids.levels[j - 1];
-                    }
-                    bids.levels[i] = PriceLevel(price, quantity);
-                    if (count < MAX_LEVELS)
-                    {
-                        bids.count.store(count + 1);
-                    }
-                    bids.last_update_ns.store(arbisim::timestamp_ns());
-                    return;
+                    // Update existing level; depth re-accumulates from here down
+                    Kernels::template replace<PADDED_LEVELS>(side.quantity.data(), i, quantity);
+                    Kernels::template replace<PADDED_LEVELS>(side.timestamp_ns.data(), i, ts_ns);
+                    Kernels::template prefix_sum<PADDED_LEVELS>(side.quantity.data(), side.cum_qty.data(), i, count);
                 }
+                side.last_update_ns.store(ts_ns);
+                return;
             }
 
-            // Append at end if there's space
+            // Deleting a level we do not hold, or worse than every level of a full side
+            if (quantity <= 0.0 || i >= MAX_LEVELS)
+                return;
+
+            // Insert at i, shifting the rest down; a full side drops its worst level
+            size_t end = std::min(count, MAX_LEVELS - 1);
+            Kernels::template insert<PADDED_LEVELS>(side.price.data(), i, end, price);
+            Kernels::template insert<PADDED_LEVELS>(side.quantity.data(), i, end, quantity);
+            Kernels::template insert<PADDED_LEVELS>(side.timestamp_ns.data(), i, end, ts_ns);
             if (count < MAX_LEVELS)
             {
-                bids.levels[count] = PriceLevel(price, quantity);
-                bids.count.store(count + 1);
-                bids.last_update_ns.store(arbisim::timestamp_ns());
+                count += 1;
+                side.count.store(count);
             }
+            Kernels::template prefix_sum<PADDED_LEVELS>(side.quantity.data(), side.cum_qty.data(), i, count);
+            side.last_update_ns.store(ts_ns);
         }
 
-        // Update ask side (thread-safe for single writer)
-        void update_ask(double price, double quantity)
+#ifdef ARBISIM_HAVE_X86_SIMD
+        // Compiled for AVX2 as a whole and flattened, so the AVX2 kernels inline into it
+        template <bool Bids>
+        ARBISIM_TARGET_AVX2 ARBISIM_FLATTEN static void update_side_avx2(BookSide &side, double price, double quantity, uint64_t ts_ns)
         {
-            auto &asks = asks_;
-            size_t count = asks.count.load();
+            update_side<Bids, simd::Avx2Kernels>(side, price, quantity, ts_ns);
+        }
+#endif
 
-            // Find insertion point or update existing
-            for (size_t i = 0; i < count; ++i)
+        // One dispatch per update on the widest kernels the CPU supports; a side shorter
+        // than one vector gains nothing from them and takes the scalar path
+        template <bool Bids>
+        static void apply(BookSide &side, double price, double quantity, uint64_t ts_ns)
+        {
+#ifdef ARBISIM_HAVE_X86_SIMD
+            switch (side.count.load(std::memory_order_relaxed) < 4 ? simd::Level::SCALAR : simd::active_level())
             {
-                if (asks.levels[i].price == price)
-                {
-                    // Update existing level
-                    asks.levels[i].quantity = quantity;
-                    asks.levels[i].timestamp_ns = arbisim::timestamp_ns();
-                    asks.last_update_ns.store(arbisim::timestamp_ns());
-                    return;
-                }
-                else if (asks.levels[i].price > price)
-                {
-                    // Insert here, shift others up
-                    for (size_t j = std::min(count, MAX_LEVELS - 1); j > i; --j)
-                    {
-                        asks.levels[j] = asks.levels[j - 1];
-                    }
-                    asks.levels[i] = PriceLevel(price, quantity);
-                    if (count < MAX_LEVELS)
-                    {
-                        asks.count.store(count + 1);
-                    }
-                    asks.last_update_ns.store(arbisim::timestamp_ns());
-                    return;
-                }
+            case simd::Level::AVX2:
+                return update_side_avx2<Bids>(side, price, quantity, ts_ns);
+            case simd::Level::SSE2:
+                return update_side<Bids, simd::Sse2Kernels>(side, price, quantity, ts_ns);
+            default:
+                break;
             }
+#endif
+            update_side<Bids, simd::ScalarKernels>(side, price, quantity, ts_ns);
+        }
 
-            // Append at end if there's space
-            if (count < MAX_LEVELS)
-            {
-                asks.levels[count] = PriceLevel(price, quantity);
-                asks.count.store(count + 1);
-                asks.last_update_ns.store(arbisim::timestamp_ns());
-            }
+    public:
+        explicit FastOrderBook(const std::string &symbol, const std::string &exchange)
+            : symbol_(symbol), exchange_(exchange) {}
+
+        // Update bid side (thread-safe for single writer), stamped ts_ns
+        void update_bid(double price, double quantity, uint64_t ts_ns)
+        {
+            apply<true>(bids_, price, quantity, ts_ns);
+        }
+
+        // Update ask side (thread-safe for single writer), stamped ts_ns
+        void update_ask(double price, double quantity, uint64_t ts_ns)
+        {
+            apply<false>(asks_, price, quantity, ts_ns);
         }
 
+        // Stamped now
+        void update_bid(double price, double quantity) { update_bid(price, quantity, arbisim::timestamp_ns()); }
+        void update_ask(double price, double quantity) { update_ask(price, quantity, arbisim::timestamp_ns()); }
+
+        // Depth access (best level first)
+        size_t bid_depth() const { return bids_.count.load(); }
+        size_t ask_depth() const { return asks_.count.load(); }
+        PriceLevel bid_level(size_t i) const { return PriceLevel(bids_.price[i], bids_.quantity[i], bids_.timestamp_ns[i]); }
+        PriceLevel ask_level(size_t i) const { return PriceLevel(asks_.price[i], asks_.quantity[i], asks_.timestamp_ns[i]); }
+        double bid_price(size_t i) const { return bids_.price[i]; }
+        double ask_price(size_t i) const { return asks_.price[i]; }
+        double bid_cum_qty(size_t i) const { return bids_.cum_qty[i]; }
+        double ask_cum_qty(size_t i) const { return asks_.cum_qty[i]; }
+
         // Get best bid/ask (lock-free read)
         std::pair<double, double> get_best_bid_ask() const
         {
@@ -177,11 +222,11 @@ namespace arbisim
 
             if (bids_.count.load() > 0)
             {
-                best_bid = bids_.levels[0].price;
+                best_bid = bids_.price[0];
             }
             if (asks_.count.load() > 0)
             {
-                best_ask = asks_.levels[0].price;
+                best_ask = asks_.price[0];
             }
 
             return {best_bid, best_ask};
@@ -201,10 +246,28 @@ namespace arbisim
             return (ask > 0 && bid > 0) ? (ask + bid) / 2.0 : 0.0;
         }
 
+        // Stamp of the newest change to either side (0 before the first)
+        uint64_t last_update_ns() const
+        {
+            return std::max(bids_.last_update_ns.load(std::memory_order_relaxed),
+                            asks_.last_update_ns.load(std::memory_order_relaxed));
+        }
+
         const std::string &symbol() const { return symbol_; }
         const std::string &exchange() const { return exchange_; }
     };
 
+    static_assert(alignof(FastOrderBook) == CACHE_LINE_SIZE, "books must not share lines with their neighbours");
+
+    // Lifecycle of one (symbol, buy venue, sell venue) cross. Values are written to the
+    // CSV log, keep them stable.
+    enum class OpportunityEvent
+    {
+        OPEN = 0,   // Cross appeared
+        UPDATE = 1, // Still open, price or size moved materially
+        CLOSE = 2   // Cross gone; prices are the last ones seen while open
+    };
+
     // Arbitrage opportunity detector
     struct ArbitrageOpportunity
     {
@@ -215,99 +278,398 @@ namespace arbisim
         double sell_price;
         double profit_bps; // basis points
         uint64_t detected_at_ns;
-        uint64_t latency_ns; // time from market update to detection
+        uint64_t latency_ns;         // time from market update to detection
+        double buy_fee_bps = 10.0;   // taker fee on the buy leg
+        double sell_fee_bps = 10.0;  // taker fee on the sell leg
+        double net_profit_bps = 0.0; // after both legs' fees
+
+        // Depth-aware sizing: largest quantity whose every unit still clears fees and
+        // min profit, and the average fill price on each leg at that quantity
+        double max_quantity = 0.0;
+        double buy_vwap = 0.0;
+        double sell_vwap = 0.0;
+
+        OpportunityEvent event = OpportunityEvent::OPEN;
+        uint64_t opened_at_ns = 0; // When the cross first appeared
+        uint64_t duration_ns = 0;  // Time open so far (CLOSE: total lifetime)
+        uint64_t trace_id = 0;     // Trace of the update whose detection pass emitted it
 
         ArbitrageOpportunity() = default;
         ArbitrageOpportunity(const std::string &sym, const std::string &buy_exch,
                              const std::string &sell_exch, double buy_px, double sell_px,
-                             uint64_t update_time_ns)
+                             uint64_t update_time_ns, double buy_fee = 10.0, double sell_fee = 10.0,
+                             uint64_t detected_ns = 0) // 0 = now
             : symbol(sym), buy_exchange(buy_exch), sell_exchange(sell_exch),
-              buy_price(buy_px), sell_price(sell_px), detected_at_ns(arbisim::timestamp_ns()),
-              latency_ns(detected_at_ns - update_time_ns)
+              buy_price(buy_px), sell_price(sell_px),
+              detected_at_ns(detected_ns ? detected_ns : arbisim::timestamp_ns()),
+              latency_ns(detected_at_ns - update_time_ns), buy_fee_bps(buy_fee), sell_fee_bps(sell_fee)
         {
 
             profit_bps = ((sell_price - buy_price) / buy_price) * 10000.0;
+            net_profit_bps = ((sell_price * (1.0 - sell_fee_bps / 10000.0) -
+                               buy_price * (1.0 + buy_fee_bps / 10000.0)) /
+                              buy_price) *
+                             10000.0;
         }
     };
 
+    // Opportunity lifetimes, from crosses that have closed
+    struct LifecycleStats
+    {
+        uint64_t opened = 0;
+        uint64_t updated = 0;
+        uint64_t closed = 0;
+        uint64_t coalesced = 0; // Repeat detections of an open cross that emitted nothing
+        uint64_t open_now = 0;
+        uint64_t avg_lifetime_ns = 0;
+        uint64_t half_life_ns = 0; // Median lifetime: half of all crosses close sooner
+        uint64_t max_lifetime_ns = 0;
+    };
+
     class ArbitrageDetector
     {
     private:
-        std::unordered_map<std::string, std::unordered_map<std::string, std::unique_ptr<FastOrderBook>>> books_;
-        double min_profit_bps_ = 5.0; // Minimum 0.5 bps profit
+        // Last emitted state of one directed venue pair
+        struct CrossState
+        {
+            bool open = false;
+            uint64_t opened_ns = 0;
+            double buy_price = 0.0;
+            double sell_price = 0.0;
+            double max_quantity = 0.0;
+            double buy_fee_bps = 0.0;
+            double sell_fee_bps = 0.0;
+            double buy_vwap = 0.0;
+            double sell_vwap = 0.0;
+        };
+
+        // All venues quoting one symbol, plus the per-pair entry thresholds
+        struct SymbolBooks
+        {
+            std::vector<std::unique_ptr<FastOrderBook>> books;
+            std::vector<double> taker_bps; // per venue
+            // min_ratio[buy * n + sell]: the sell venue's bid must be at least
+            // ask * min_ratio for the cross to clear both taker fees plus min_profit_bps_
+            std::vector<double> min_ratio;
+            std::vector<CrossState> crosses; // [buy * n + sell]
+            std::mutex mutex;                // Serialises lifecycle transitions across feed threads
+        };
+
+        static constexpr size_t LIFETIME_SAMPLES = 4096;
+
+        std::unordered_map<std::string, SymbolBooks> books_;
+        FeeSchedule fee_schedule_;
+        double min_profit_bps_ = 5.0; // Minimum net profit after fees
+
+        // An open cross is re-emitted only when a leg price moves this much or the
+        // executable size changes by this fraction
+        double update_price_bps_ = 1.0;
+        double update_size_fraction_ = 0.25;
+
+        mutable std::mutex stats_mutex_;
+        LifecycleStats stats_;
+        uint64_t total_lifetime_ns_ = 0;
+        std::vector<uint64_t> lifetimes_; // Ring of recent lifetimes for the half-life
+        size_t lifetime_next_ = 0;
+
+        bool material_change(const CrossState &state, const ArbitrageOpportunity &opp) const
+        {
+            double buy_move = std::abs(opp.buy_price - state.buy_price) / state.buy_price * 10000.0;
+            double sell_move = std::abs(opp.sell_price - state.sell_price) / state.sell_price * 10000.0;
+            double size_base = std::max(state.max_quantity, 1e-9);
+            return buy_move >= update_price_bps_ || sell_move >= update_price_bps_ ||
+                   std::abs(opp.max_quantity - state.max_quantity) / size_base >= update_size_fraction_;
+        }
+
+        void remember(CrossState &state, const ArbitrageOpportunity &opp)
+        {
+            state.buy_price = opp.buy_price;
+            state.sell_price = opp.sell_price;
+            state.max_quantity = opp.max_quantity;
+            state.buy_fee_bps = opp.buy_fee_bps;
+            state.sell_fee_bps = opp.sell_fee_bps;
+            state.buy_vwap = opp.buy_vwap;
+            state.sell_vwap = opp.sell_vwap;
+        }
+
+        void record_events(uint64_t opened, uint64_t updated, uint64_t coalesced,
+                           const std::vector<ArbitrageOpportunity> &events)
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.opened += opened;
+            stats_.updated += updated;
+            stats_.coalesced += coalesced;
+            for (const auto &event : events)
+            {
+                if (event.event != OpportunityEvent::CLOSE)
+                    continue;
+
+                stats_.closed++;
+                total_lifetime_ns_ += event.duration_ns;
+                stats_.max_lifetime_ns = std::max(stats_.max_lifetime_ns, event.duration_ns);
+                if (lifetimes_.size() < LIFETIME_SAMPLES)
+                {
+                    if (lifetimes_.capacity() == 0)
+                        lifetimes_.reserve(LIFETIME_SAMPLES); // Once, not a regrowth every doubling
+                    lifetimes_.push_back(event.duration_ns);
+                }
+                else
+                {
+                    lifetimes_[lifetime_next_] = event.duration_ns;
+                    lifetime_next_ = (lifetime_next_ + 1) % LIFETIME_SAMPLES;
+                }
+            }
+            stats_.open_now = stats_.opened - stats_.closed;
+        }
+
+        void rebuild_thresholds(SymbolBooks &sym)
+        {
+            size_t n = sym.books.size();
+            sym.taker_bps.resize(n);
+            sym.min_ratio.assign(n * n, 0.0);
+            sym.crosses.assign(n * n, CrossState{});
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                sym.taker_bps[i] = fee_schedule_.taker_bps(sym.books[i]->exchange());
+            }
+            for (size_t buy = 0; buy < n; ++buy)
+            {
+                for (size_t sell = 0; sell < n; ++sell)
+                {
+                    double buy_cost = 1.0 + (sym.taker_bps[buy] + min_profit_bps_) / 10000.0;
+                    double sell_proceeds = 1.0 - sym.taker_bps[sell] / 10000.0;
+                    sym.min_ratio[buy * n + sell] = buy_cost / sell_proceeds;
+                }
+            }
+        }
+
+        // Walk the buy venue's asks against the sell venue's bids while the marginal
+        // cross still clears min_ratio. Cumulative depth makes each step a comparison
+        // of running totals rather than a per-level quantity bookkeeping.
+        static void size_cross(const FastOrderBook &buy_book, const FastOrderBook &sell_book,
+                               double min_ratio, ArbitrageOpportunity &opp)
+        {
+            size_t ask_levels = buy_book.ask_depth();
+            size_t bid_levels = sell_book.bid_depth();
+            size_t a = 0, b = 0;
+            double filled = 0.0, buy_notional = 0.0, sell_notional = 0.0;
+
+            while (a < ask_levels && b < bid_levels)
+            {
+                double ask_px = buy_book.ask_price(a);
+                double bid_px = sell_book.bid_price(b);
+                if (bid_px < ask_px * min_ratio)
+                    break;
+
+                double next = std::min(buy_book.ask_cum_qty(a), sell_book.bid_cum_qty(b));
+                double step = next - filled;
+                buy_notional += step * ask_px;
+                sell_notional += step * bid_px;
+                filled = next;
+
+                if (buy_book.ask_cum_qty(a) <= filled)
+                    ++a;
+                if (sell_book.bid_cum_qty(b) <= filled)
+                    ++b;
+            }
+
+            opp.max_quantity = filled;
+            if (filled > 0.0)
+            {
+                opp.buy_vwap = buy_notional / filled;
+                opp.sell_vwap = sell_notional / filled;
+            }
+        }
+
+        void rebuild_all_thresholds()
+        {
+            for (auto &[symbol, sym] : books_)
+            {
+                rebuild_thresholds(sym);
+            }
+        }
 
     public:
+        // Books and fees should be configured before feeds start; thresholds are rebuilt in place
         void add_orderbook(const std::string &symbol, const std::string &exchange)
         {
-            books_[symbol][exchange] = std::make_unique<FastOrderBook>(symbol, exchange);
+            auto &sym = books_[symbol];
+            for (auto &book : sym.books)
+            {
+                if (book->exchange() == exchange)
+                {
+                    book = std::make_unique<FastOrderBook>(symbol, exchange);
+                    return;
+                }
+            }
+            sym.books.push_back(std::make_unique<FastOrderBook>(symbol, exchange));
+            rebuild_thresholds(sym);
         }
 
         void set_min_profit_bps(double bps)
         {
             min_profit_bps_ = bps;
+            rebuild_all_thresholds();
+        }
+
+        void set_fee_schedule(const FeeSchedule &schedule)
+        {
+            fee_schedule_ = schedule;
+            rebuild_all_thresholds();
         }
 
+        const FeeSchedule &fee_schedule() const { return fee_schedule_; }
+
         FastOrderBook *get_orderbook(const std::string &symbol, const std::string &exchange)
         {
             auto sym_it = books_.find(symbol);
             if (sym_it != books_.end())
             {
-                auto exch_it = sym_it->second.find(exchange);
-                if (exch_it != sym_it->second.end())
+                for (auto &book : sym_it->second.books)
                 {
-                    return exch_it->second.get();
+                    if (book->exchange() == exchange)
+                    {
+                        return book.get();
+                    }
                 }
             }
             return nullptr;
         }
 
-        // Check for arbitrage opportunities across all exchanges for a symbol
+        void set_update_thresholds(double price_bps, double size_fraction)
+        {
+            update_price_bps_ = price_bps;
+            update_size_fraction_ = size_fraction;
+        }
+
+        LifecycleStats lifecycle_stats() const
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            LifecycleStats stats = stats_;
+            if (stats.closed > 0)
+            {
+                stats.avg_lifetime_ns = total_lifetime_ns_ / stats.closed;
+            }
+            if (!lifetimes_.empty())
+            {
+                std::vector<uint64_t> sorted = lifetimes_;
+                std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+                stats.half_life_ns = sorted[sorted.size() / 2];
+            }
+            return stats;
+        }
+
+        // Check every venue pair of a symbol for crosses that clear both legs' taker fees,
+        // and return lifecycle events rather than raw detections: OPEN when a cross
+        // appears, UPDATE when an open cross moves materially, CLOSE when it disappears.
+        // A cross that persists unchanged across updates produces nothing.
         std::vector<ArbitrageOpportunity> check_arbitrage(const std::string &symbol,
                                                           uint64_t update_time_ns)
         {
-            std::vector<ArbitrageOpportunity> opportunities;
+            std::vector<ArbitrageOpportunity> events;
+            check_arbitrage(symbol, update_time_ns, events);
+            return events;
+        }
+
+        // Same, into a caller-owned vector (cleared first) whose capacity is reused across
+        // passes, so a steady-state pass allocates nothing
+        void check_arbitrage(const std::string &symbol, uint64_t update_time_ns,
+                             std::vector<ArbitrageOpportunity> &events)
+        {
+            events.clear();
 
             auto sym_it = books_.find(symbol);
-            if (sym_it == books_.end() || sym_it->second.size() < 2)
+            if (sym_it == books_.end() || sym_it->second.books.size() < 2)
             {
-                return opportunities;
+                return;
             }
 
-            // Compare all pairs of exchanges
-            auto &exchanges = sym_it->second;
-            for (auto it1 = exchanges.begin(); it1 != exchanges.end(); ++it1)
+            auto &sym = sym_it->second;
+            const size_t n = sym.books.size();
+            uint64_t opened = 0, updated = 0, coalesced = 0;
+
+            // One detection time per pass, read only once something is emitted
+            uint64_t detected_ns = 0;
+            auto detection_time = [&]()
             {
-                for (auto it2 = std::next(it1); it2 != exchanges.end(); ++it2)
-                {
+                if (detected_ns == 0)
+                    detected_ns = timestamp_ns();
+                return detected_ns;
+            };
 
-                    auto [bid1, ask1] = it1->second->get_best_bid_ask();
-                    auto [bid2, ask2] = it2->second->get_best_bid_ask();
+            {
+                std::lock_guard<std::mutex> lock(sym.mutex);
 
-                    // Check if we can buy on exchange 1 and sell on exchange 2
-                    if (ask1 > 0 && bid2 > 0 && bid2 > ask1)
+                auto evaluate = [&](size_t buy, size_t sell, double ask, double bid)
+                {
+                    CrossState &state = sym.crosses[buy * n + sell];
+                    bool crossed = ask > 0 && bid > 0 && bid >= ask * sym.min_ratio[buy * n + sell];
+
+                    if (crossed)
                     {
-                        double profit_bps = ((bid2 - ask1) / ask1) * 10000.0;
-                        if (profit_bps >= min_profit_bps_)
+                        ArbitrageOpportunity opp(symbol, sym.books[buy]->exchange(), sym.books[sell]->exchange(),
+                                                 ask, bid, update_time_ns, sym.taker_bps[buy], sym.taker_bps[sell],
+                                                 detection_time());
+                        size_cross(*sym.books[buy], *sym.books[sell], sym.min_ratio[buy * n + sell], opp);
+
+                        if (!state.open)
+                        {
+                            state.open = true;
+                            state.opened_ns = opp.detected_at_ns;
+                            opp.event = OpportunityEvent::OPEN;
+                            ++opened;
+                        }
+                        else if (material_change(state, opp))
+                        {
+                            opp.event = OpportunityEvent::UPDATE;
+                            ++updated;
+                        }
+                        else
                         {
-                            opportunities.emplace_back(symbol, it1->first, it2->first,
-                                                       ask1, bid2, update_time_ns);
+                            ++coalesced;
+                            return;
                         }
+
+                        opp.opened_at_ns = state.opened_ns;
+                        opp.duration_ns = opp.detected_at_ns - state.opened_ns;
+                        remember(state, opp);
+                        events.push_back(std::move(opp));
+                    }
+                    else if (state.open)
+                    {
+                        ArbitrageOpportunity opp(symbol, sym.books[buy]->exchange(), sym.books[sell]->exchange(),
+                                                 state.buy_price, state.sell_price, update_time_ns,
+                                                 state.buy_fee_bps, state.sell_fee_bps, detection_time());
+                        opp.event = OpportunityEvent::CLOSE;
+                        opp.max_quantity = state.max_quantity;
+                        opp.buy_vwap = state.buy_vwap;
+                        opp.sell_vwap = state.sell_vwap;
+                        opp.opened_at_ns = state.opened_ns;
+                        opp.duration_ns = opp.detected_at_ns - state.opened_ns;
+                        state.open = false;
+                        events.push_back(std::move(opp));
                     }
+                };
+
+                // Compare all pairs of exchanges, both directions
+                for (size_t i = 0; i < n; ++i)
+                {
+                    auto [bid1, ask1] = sym.books[i]->get_best_bid_ask();
 
-                    // Check if we can buy on exchange 2 and sell on exchange 1
-                    if (ask2 > 0 && bid1 > 0 && bid1 > ask2)
+                    for (size_t j = i + 1; j < n; ++j)
                     {
-                        double profit_bps = ((bid1 - ask2) / ask2) * 10000.0;
-                        if (profit_bps >= min_profit_bps_)
-                        {
-                            opportunities.emplace_back(symbol, it2->first, it1->first,
-                                                       ask2, bid1, update_time_ns);
-                        }
+                        auto [bid2, ask2] = sym.books[j]->get_best_bid_ask();
+                        evaluate(i, j, ask1, bid2);
+                        evaluate(j, i, ask2, bid1);
                     }
                 }
             }
 
-            return opportunities;
+            if (opened || updated || coalesced || !events.empty())
+            {
+                record_events(opened, updated, coalesced, events);
+            }
         }
     };
 
@@ -0,0 +1,403 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "arbisim_core.h"
+#include "cache_line.h"
+#include "pipeline_trace.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace arbisim
+{
+
+    // One opportunity log row as a fixed-size record: what the hot path hands over
+    // instead of formatting text itself
+    struct OpportunityRecord
+    {
+        uint64_t detected_at_ns = 0;
+        uint64_t latency_ns = 0;
+        uint64_t duration_ns = 0;
+        double buy_price = 0.0;
+        double sell_price = 0.0;
+        double profit_bps = 0.0;
+        double net_profit_bps = 0.0;
+        char symbol[16] = {};
+        char buy_exchange[16] = {};
+        char sell_exchange[16] = {};
+        int8_t decision = 0; // RiskDecision, or -1 for a CLOSE event
+        uint8_t event = 0;   // OpportunityEvent
+        uint64_t trace_id = 0; // Not logged; lets the writer trace its stage
+
+        OpportunityRecord() = default;
+        OpportunityRecord(const ArbitrageOpportunity &opp, double net_bps, int decision_code)
+            : detected_at_ns(opp.detected_at_ns), latency_ns(opp.latency_ns), duration_ns(opp.duration_ns),
+              buy_price(opp.buy_price), sell_price(opp.sell_price), profit_bps(opp.profit_bps),
+              net_profit_bps(net_bps), decision(static_cast<int8_t>(decision_code)),
+              event(static_cast<uint8_t>(opp.event)), trace_id(opp.trace_id)
+        {
+            copy_name(symbol, opp.symbol);
+            copy_name(buy_exchange, opp.buy_exchange);
+            copy_name(sell_exchange, opp.sell_exchange);
+        }
+
+        static void copy_name(char (&dst)[16], const std::string &src)
+        {
+            size_t len = std::min(src.size(), sizeof(dst) - 1);
+            std::memcpy(dst, src.data(), len);
+            dst[len] = '\0';
+        }
+    };
+
+    // Row formatting shared by the async writer and the columnar log converter
+    namespace csv
+    {
+        inline char *put_str(char *p, const char *s)
+        {
+            size_t len = std::strlen(s);
+            std::memcpy(p, s, len);
+            return p + len;
+        }
+
+        inline char *put_fixed(char *p, char *end, double value, int precision)
+        {
+            return std::to_chars(p, end, value, std::chars_format::fixed, precision).ptr;
+        }
+
+        // Writes one row plus newline; needs at most 256 bytes
+        inline char *format_opportunity_csv(const OpportunityRecord &r, char *p, char *end)
+        {
+            p = std::to_chars(p, end, r.detected_at_ns).ptr;
+            *p++ = ',';
+            p = put_str(p, r.symbol);
+            *p++ = ',';
+            p = put_str(p, r.buy_exchange);
+            *p++ = ',';
+            p = put_str(p, r.sell_exchange);
+            *p++ = ',';
+            p = put_fixed(p, end, r.buy_price, 2);
+            *p++ = ',';
+            p = put_fixed(p, end, r.sell_price, 2);
+            *p++ = ',';
+            p = put_fixed(p, end, r.profit_bps, 1);
+            *p++ = ',';
+            p = put_fixed(p, end, r.net_profit_bps, 1);
+            *p++ = ',';
+            p = std::to_chars(p, end, r.latency_ns).ptr;
+            *p++ = ',';
+            p = std::to_chars(p, end, static_cast<int>(r.decision)).ptr;
+            *p++ = ',';
+            p = std::to_chars(p, end, static_cast<int>(r.event)).ptr;
+            *p++ = ',';
+            p = std::to_chars(p, end, r.duration_ns).ptr;
+            *p++ = '\n';
+            return p;
+        }
+    } // namespace csv
+
+    // Header matching csv::format_opportunity_csv
+    inline constexpr const char *OPPORTUNITY_CSV_HEADER =
+        "timestamp,symbol,buy_exchange,sell_exchange,buy_price,sell_price,profit_bps,net_profit_bps,latency_ns,decision,event,duration_ns\n";
+
+    enum class LogDurability
+    {
+        BUFFERED,    // Batches reach the OS at every flush interval; no fsync
+        GROUP_COMMIT // Additionally fsync at most once per fsync interval
+    };
+
+    struct AsyncLogConfig
+    {
+        std::string path = "arbitrage_opportunities.csv";
+        size_t max_file_bytes = 64 * 1024 * 1024; // Rotate when the live file reaches this size (0 = never)
+        uint64_t rotate_interval_sec = 0;         // Rotate after this long (0 = never)
+        uint64_t flush_interval_ms = 50;
+        LogDurability durability = LogDurability::BUFFERED;
+        uint64_t fsync_interval_ms = 1000;
+        size_t queue_capacity = 16384; // Records beyond this are dropped, never waited for
+    };
+
+    // Background CSV writer for the opportunity log. Producers append fixed-size records
+    // under a short lock; the writer thread swaps the whole batch out, formats it with
+    // to_chars into one block and writes it with a single call per block. Rotated files
+    // are renamed <stem>.<n><ext>; the live file always keeps the configured path so a
+    // tailing reader just has to notice it shrank.
+    class AsyncLogWriter
+    {
+    public:
+        struct Stats
+        {
+            uint64_t enqueued = 0;
+            uint64_t written = 0;
+            uint64_t dropped = 0;
+            uint64_t batches = 0;
+            uint64_t bytes = 0;
+            uint64_t rotations = 0;
+            uint64_t fsyncs = 0;
+        };
+
+    private:
+        static constexpr size_t BLOCK_BYTES = 256 * 1024;
+        static constexpr size_t MAX_ROW_BYTES = 256;
+
+        AsyncLogConfig config_;
+
+        // Producer side: everything log() touches, behind the queue lock
+        alignas(CACHE_LINE_SIZE) std::mutex queue_mutex_;
+        std::condition_variable queue_cv_;
+        std::vector<OpportunityRecord> pending_;
+        bool stopping_ = false;
+        std::atomic<uint64_t> enqueued_{0};
+        std::atomic<uint64_t> dropped_{0};
+
+        // Writer thread side, on lines producers never write
+        alignas(CACHE_LINE_SIZE) std::thread writer_thread_;
+        std::FILE *file_ = nullptr;
+        size_t file_bytes_ = 0;
+        uint64_t file_opened_ns_ = 0;
+        uint64_t last_fsync_ns_ = 0;
+        uint64_t rotation_index_ = 0;
+        std::vector<char> block_;
+        std::function<void(const std::vector<OpportunityRecord> &)> batch_sink_;
+        PipelineTracer *tracer_ = nullptr;
+
+        std::atomic<uint64_t> written_{0};
+        std::atomic<uint64_t> batches_{0};
+        std::atomic<uint64_t> bytes_{0};
+        std::atomic<uint64_t> rotations_{0};
+        std::atomic<uint64_t> fsyncs_{0};
+
+        bool open_live_file()
+        {
+            file_ = std::fopen(config_.path.c_str(), "wb");
+            if (!file_)
+                return false;
+            std::fputs(OPPORTUNITY_CSV_HEADER, file_);
+            std::fflush(file_);
+            file_bytes_ = std::strlen(OPPORTUNITY_CSV_HEADER);
+            file_opened_ns_ = timestamp_ns();
+            return true;
+        }
+
+        std::string rotated_name(uint64_t index) const
+        {
+            const std::string &path = config_.path;
+            size_t dot = path.find_last_of('.');
+            size_t slash = path.find_last_of("/\\");
+            if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+                return path + "." + std::to_string(index);
+            return path.substr(0, dot) + "." + std::to_string(index) + path.substr(dot);
+        }
+
+        void sync_file()
+        {
+            std::fflush(file_);
+#ifdef _WIN32
+            _commit(_fileno(file_));
+#else
+            ::fsync(fileno(file_));
+#endif
+            fsyncs_.fetch_add(1, std::memory_order_relaxed);
+            last_fsync_ns_ = timestamp_ns();
+        }
+
+        void rotate_if_needed()
+        {
+            bool by_size = config_.max_file_bytes > 0 && file_bytes_ >= config_.max_file_bytes;
+            bool by_time = config_.rotate_interval_sec > 0 &&
+                           timestamp_ns() - file_opened_ns_ >= config_.rotate_interval_sec * 1000000000ULL;
+            if (!by_size && !by_time)
+                return;
+
+            if (config_.durability == LogDurability::GROUP_COMMIT)
+                sync_file();
+            std::fclose(file_);
+            file_ = nullptr;
+            std::rename(config_.path.c_str(), rotated_name(++rotation_index_).c_str());
+            rotations_.fetch_add(1, std::memory_order_relaxed);
+            open_live_file();
+        }
+
+        void write_batch(const std::vector<OpportunityRecord> &batch)
+        {
+            char *begin = block_.data();
+            char *end = begin + block_.size();
+            char *p = begin;
+
+            auto emit = [&]()
+            {
+                size_t len = static_cast<size_t>(p - begin);
+                if (len == 0 || !file_)
+                    return;
+                std::fwrite(begin, 1, len, file_);
+                file_bytes_ += len;
+                bytes_.fetch_add(len, std::memory_order_relaxed);
+                p = begin;
+            };
+
+            for (const auto &record : batch)
+            {
+                if (end - p < static_cast<std::ptrdiff_t>(MAX_ROW_BYTES))
+                {
+                    emit();
+                    if (file_)
+                        rotate_if_needed();
+                }
+                p = csv::format_opportunity_csv(record, p, end);
+            }
+            emit();
+
+            if (!file_)
+                return;
+            std::fflush(file_); // One syscall per batch instead of per row
+            written_.fetch_add(batch.size(), std::memory_order_relaxed);
+            batches_.fetch_add(1, std::memory_order_relaxed);
+
+            if (config_.durability == LogDurability::GROUP_COMMIT &&
+                timestamp_ns() - last_fsync_ns_ >= config_.fsync_interval_ms * 1000000ULL)
+            {
+                sync_file();
+            }
+            rotate_if_needed();
+        }
+
+        void writer_loop()
+        {
+            std::vector<OpportunityRecord> batch;
+            batch.reserve(config_.queue_capacity);
+            bool named = false;
+
+            while (true)
+            {
+                bool stopping;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex_);
+                    queue_cv_.wait_for(lock, std::chrono::milliseconds(config_.flush_interval_ms), [this]()
+                                       { return stopping_; });
+                    batch.swap(pending_);
+                    stopping = stopping_;
+                }
+
+                if (!batch.empty())
+                {
+                    uint64_t write_start = tracer_ && tracer_->enabled() ? timestamp_ns() : 0;
+                    write_batch(batch);
+                    if (write_start)
+                    {
+                        if (!named)
+                            tracer_->name_thread("log writer");
+                        named = true;
+                        uint64_t write_end = timestamp_ns();
+                        for (const auto &record : batch)
+                            tracer_->record(TraceStage::LOG_WRITE, record.trace_id, write_start, write_end);
+                    }
+                    if (batch_sink_)
+                        batch_sink_(batch);
+                    batch.clear();
+                }
+                if (stopping)
+                    return;
+            }
+        }
+
+    public:
+        AsyncLogWriter() = default;
+        ~AsyncLogWriter() { stop(); }
+
+        AsyncLogWriter(const AsyncLogWriter &) = delete;
+        AsyncLogWriter &operator=(const AsyncLogWriter &) = delete;
+
+        // Also hand every written batch to sink, on the writer thread (set before start)
+        void set_batch_sink(std::function<void(const std::vector<OpportunityRecord> &)> sink)
+        {
+            batch_sink_ = std::move(sink);
+        }
+
+        // Record a LOG_WRITE span for every traced row (set before start)
+        void set_tracer(PipelineTracer *tracer)
+        {
+            tracer_ = tracer;
+        }
+
+        bool start(const AsyncLogConfig &config)
+        {
+            if (writer_thread_.joinable())
+                return false;
+
+            config_ = config;
+            config_.flush_interval_ms = std::max<uint64_t>(1, config_.flush_interval_ms);
+            if (!open_live_file())
+                return false;
+
+            block_.resize(BLOCK_BYTES);
+            pending_.reserve(config_.queue_capacity);
+            last_fsync_ns_ = timestamp_ns();
+            stopping_ = false;
+            writer_thread_ = std::thread([this]()
+                                         { writer_loop(); });
+            return true;
+        }
+
+        // Hot path: copy the record into the pending batch; never blocks on I/O
+        bool log(const OpportunityRecord &record)
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            if (stopping_ || pending_.size() >= config_.queue_capacity)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            pending_.push_back(record);
+            enqueued_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Write out everything queued, sync if in group-commit mode, close the file
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                if (stopping_ || !writer_thread_.joinable())
+                    return;
+                stopping_ = true;
+            }
+            queue_cv_.notify_all();
+            writer_thread_.join();
+
+            if (file_)
+            {
+                if (config_.durability == LogDurability::GROUP_COMMIT)
+                    sync_file();
+                std::fclose(file_);
+                file_ = nullptr;
+            }
+        }
+
+        Stats get_stats() const
+        {
+            Stats stats;
+            stats.enqueued = enqueued_.load();
+            stats.written = written_.load();
+            stats.dropped = dropped_.load();
+            stats.batches = batches_.load();
+            stats.bytes = bytes_.load();
+            stats.rotations = rotations_.load();
+            stats.fsyncs = fsyncs_.load();
+            return stats;
+        }
+    };
+
+} // namespace arbisim
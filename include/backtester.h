@@ -0,0 +1,342 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "arbisim_core.h"
+#include "execution_simulator.h"
+#include "fee_schedule.h"
+#include "risk_management.h"
+#include "thread_pool.h"
+
+namespace arbisim
+{
+
+    // Market data capture format, one update per line:
+    //   timestamp_ns,exchange,symbol,side,price,quantity     (side: B = bid, A = ask)
+    // Written by the engine with --capture and replayed by the backtester. Only the
+    // market thread records, and close() runs after it has joined, so there is no lock.
+    class MarketDataRecorder
+    {
+    private:
+        std::ofstream out_;
+
+    public:
+        bool open(const std::string &path)
+        {
+            out_.open(path);
+            if (!out_.is_open())
+                return false;
+            out_ << "timestamp_ns,exchange,symbol,side,price,quantity\n";
+            return true;
+        }
+
+        bool is_open() const { return out_.is_open(); }
+
+        void record(const MarketUpdate &update)
+        {
+            if (update.type == MarketUpdate::TRADE)
+                return;
+
+            char line[160];
+            int len = std::snprintf(line, sizeof(line), "%llu,%s,%s,%c,%.2f,%.6f\n",
+                                    static_cast<unsigned long long>(update.timestamp_ns),
+                                    update.exchange.c_str(), update.symbol.c_str(),
+                                    update.type == MarketUpdate::BID_UPDATE ? 'B' : 'A',
+                                    update.price, update.quantity);
+            if (len <= 0)
+                return;
+
+            out_.write(line, std::min<int>(len, sizeof(line) - 1));
+        }
+
+        void close()
+        {
+            if (out_.is_open())
+                out_.close();
+        }
+    };
+
+    // Load a capture written by MarketDataRecorder, in file order. Malformed lines are skipped.
+    inline bool load_market_data(const std::string &path, std::vector<MarketUpdate> &updates)
+    {
+        std::ifstream in(path);
+        if (!in.is_open())
+            return false;
+
+        std::string line;
+        std::getline(in, line); // Header
+        while (std::getline(in, line))
+        {
+            std::istringstream fields(line);
+            std::string ts, exchange, symbol, side, price, qty;
+            if (!std::getline(fields, ts, ',') || !std::getline(fields, exchange, ',') ||
+                !std::getline(fields, symbol, ',') || !std::getline(fields, side, ',') ||
+                !std::getline(fields, price, ',') || !std::getline(fields, qty, ','))
+            {
+                continue;
+            }
+
+            MarketUpdate update;
+            update.type = (side == "B") ? MarketUpdate::BID_UPDATE : MarketUpdate::ASK_UPDATE;
+            update.exchange = exchange;
+            update.symbol = symbol;
+            update.price = std::strtod(price.c_str(), nullptr);
+            update.quantity = std::strtod(qty.c_str(), nullptr);
+            update.timestamp_ns = std::strtoull(ts.c_str(), nullptr, 10);
+            update.sequence_id = updates.size();
+            updates.push_back(update);
+        }
+        return true;
+    }
+
+    // Deterministic stand-in for a capture, drawn from the same distributions as the
+    // simulated feeds in multi_exchange_feeds.h and merged in time order. Unlike the live
+    // simulators, each new quote first deletes the venue's previous one (quantity 0), as a
+    // real L2 feed would, so crosses close when the quotes move.
+    inline std::vector<MarketUpdate> generate_synthetic_market_data(size_t quotes_per_venue, uint64_t seed)
+    {
+        struct VenueProfile
+        {
+            const char *exchange;
+            double volatility, spread_mean, spread_sd, quantity;
+            int min_delay_ms, max_delay_ms;
+        };
+        static const VenueProfile venues[] = {
+            {"binance", 0.0010, 0.3, 0.1, 150.0, 35, 45},
+            {"coinbase", 0.0012, 0.8, 0.2, 120.0, 50, 70},
+            {"kraken", 0.0015, 1.2, 0.4, 80.0, 70, 150},
+            {"bybit", 0.0020, 0.5, 0.3, 200.0, 45, 65}};
+
+        std::vector<MarketUpdate> updates;
+        updates.reserve(quotes_per_venue * 4 * 4);
+        std::mt19937_64 gen(seed);
+
+        for (const auto &venue : venues)
+        {
+            std::normal_distribution<> price_dist(50000.0, 50000.0 * venue.volatility);
+            std::normal_distribution<> spread_dist(venue.spread_mean, venue.spread_sd);
+            std::uniform_int_distribution<> delay_ms(venue.min_delay_ms, venue.max_delay_ms);
+
+            uint64_t ts = 0;
+            double prev_bid = 0.0, prev_ask = 0.0;
+            for (size_t i = 0; i < quotes_per_venue; ++i)
+            {
+                ts += static_cast<uint64_t>(delay_ms(gen)) * 1000000ULL;
+                double mid = price_dist(gen);
+                double half_spread = std::abs(spread_dist(gen)) / 2.0;
+
+                MarketUpdate bid;
+                bid.type = MarketUpdate::BID_UPDATE;
+                bid.symbol = "BTCUSDT";
+                bid.exchange = venue.exchange;
+                bid.price = mid - half_spread;
+                bid.quantity = venue.quantity;
+                bid.timestamp_ns = ts;
+
+                MarketUpdate ask = bid;
+                ask.type = MarketUpdate::ASK_UPDATE;
+                ask.price = mid + half_spread;
+
+                if (prev_bid > 0.0)
+                {
+                    MarketUpdate cancel_bid = bid;
+                    cancel_bid.price = prev_bid;
+                    cancel_bid.quantity = 0.0;
+                    MarketUpdate cancel_ask = ask;
+                    cancel_ask.price = prev_ask;
+                    cancel_ask.quantity = 0.0;
+                    updates.push_back(cancel_bid);
+                    updates.push_back(cancel_ask);
+                }
+                updates.push_back(bid);
+                updates.push_back(ask);
+                prev_bid = bid.price;
+                prev_ask = ask.price;
+            }
+        }
+
+        std::stable_sort(updates.begin(), updates.end(), [](const MarketUpdate &a, const MarketUpdate &b)
+                         { return a.timestamp_ns < b.timestamp_ns; });
+        for (size_t i = 0; i < updates.size(); ++i)
+        {
+            updates[i].sequence_id = i;
+        }
+        return updates;
+    }
+
+    // One grid point of a parameter sweep
+    struct BacktestConfig
+    {
+        double min_profit_bps = 5.0;  // Detector entry threshold (net of fees)
+        RiskLimits limits;            // Risk layer limits
+        double fee_volume_30d = 1e6;  // Picks the fee tier on every venue
+        VenueExecutionModel execution; // Order path on every venue
+    };
+
+    struct BacktestResult
+    {
+        BacktestConfig config;
+        uint64_t updates = 0;
+        uint64_t opportunities = 0;
+        uint64_t trades = 0;     // Executions that matched any quantity
+        uint64_t executions = 0; // Approved opportunities sent to the execution simulator
+        double take_rate = 0.0;
+        double total_pnl = 0.0; // Net of fees, including leg-risk unwinds
+        double leg_risk_pnl = 0.0;
+        double win_rate = 0.0; // Share of executions with positive realized P&L, unwind included
+        uint64_t avg_latency_ns = 0; // Book update + detection + risk, per market update
+        uint64_t p99_latency_ns = 0;
+        uint64_t wall_ns = 0;
+    };
+
+    // Replays one market data capture through an independent detector, risk manager and
+    // execution simulator per grid point. Grid points run in parallel on the pool; each
+    // one owns its books and risk state, so the only shared data is the read-only update
+    // stream. Books are stamped with capture time and approved trades are sent through
+    // ExecutionSimulator on that clock, so they fill against the book as it stands when
+    // the orders arrive: partial fills and leg-risk unwinds count against the P&L.
+    template <typename RiskManagerT = RiskManager>
+    class Backtester
+    {
+    private:
+        WorkStealingPool &pool_;
+        FeeSchedule base_fees_ = FeeSchedule::defaults();
+
+        BacktestResult run_one(const std::vector<MarketUpdate> &updates,
+                               const std::vector<std::string> &venues,
+                               const std::vector<std::string> &symbols,
+                               const BacktestConfig &config) const
+        {
+            uint64_t wall_start = timestamp_ns();
+            BacktestResult result;
+            result.config = config;
+
+            ArbitrageDetector detector;
+            for (const auto &symbol : symbols)
+            {
+                for (const auto &venue : venues)
+                {
+                    detector.add_orderbook(symbol, venue);
+                }
+            }
+            FeeSchedule fees = base_fees_;
+            fees.set_volume_30d_all(config.fee_volume_30d);
+            detector.set_fee_schedule(fees);
+            detector.set_min_profit_bps(config.min_profit_bps);
+
+            RiskManagerT risk;
+            risk.set_risk_limits(config.limits);
+
+            // Fills are booked at the prices achieved, as the engine does
+            ExecutionSimulator sim(detector);
+            sim.set_default_venue_model(config.execution);
+            uint64_t wins = 0;
+            sim.set_report_callback([&](const ExecutionReport &report)
+                                    {
+                if (report.matched_qty > 0.0) {
+                    ArbitrageOpportunity filled = report.opportunity;
+                    filled.buy_price = report.buy_vwap;
+                    filled.sell_price = report.sell_vwap;
+                    risk.execute_trade(filled, report.matched_qty);
+                }
+                if (report.unwind_qty > 0.0)
+                    risk.record_realized_pnl(report.unwind_pnl);
+                result.executions++;
+                wins += report.realized_pnl > 0.0; });
+
+            std::vector<uint64_t> latencies;
+            latencies.reserve(updates.size());
+            uint64_t total_latency = 0;
+
+            for (const auto &update : updates)
+            {
+                // Latency is measured on the replay's wall clock; everything else runs on capture time
+                uint64_t start = timestamp_ns();
+
+                // Orders that reached their venue before this update fill against the current books
+                sim.process_until(update.timestamp_ns);
+
+                auto *book = detector.get_orderbook(update.symbol, update.exchange);
+                if (!book)
+                    continue;
+                if (update.type == MarketUpdate::BID_UPDATE)
+                    book->update_bid(update.price, update.quantity, update.timestamp_ns);
+                else if (update.type == MarketUpdate::ASK_UPDATE)
+                    book->update_ask(update.price, update.quantity, update.timestamp_ns);
+
+                auto opportunities = detector.check_arbitrage(update.symbol, update.timestamp_ns);
+                opportunities.erase(std::remove_if(opportunities.begin(), opportunities.end(),
+                                                   [](const ArbitrageOpportunity &opp)
+                                                   { return opp.event == OpportunityEvent::CLOSE; }),
+                                    opportunities.end());
+                if (!opportunities.empty())
+                {
+                    // No wall-clock budget: a replay must allocate the same way on every run
+                    auto assessments = risk.assess_batch(opportunities, UINT64_MAX);
+                    for (size_t i = 0; i < opportunities.size(); ++i)
+                    {
+                        if (assessments[i].decision == RiskDecision::APPROVED)
+                            sim.submit(opportunities[i], assessments[i].recommended_size, update.timestamp_ns);
+                    }
+                    result.opportunities += opportunities.size();
+                }
+
+                uint64_t latency = timestamp_ns() - start;
+                latencies.push_back(latency);
+                total_latency += latency;
+                result.updates++;
+            }
+            sim.process_until(UINT64_MAX); // Orders still in flight at the end of the capture
+
+            auto report = risk.generate_report();
+            result.trades = report.total_trades;
+            result.take_rate = report.take_rate;
+            result.total_pnl = report.total_pnl;
+            result.leg_risk_pnl = sim.get_stats().leg_risk_pnl;
+            result.win_rate = result.executions > 0 ? static_cast<double>(wins) / result.executions : 0.0;
+
+            if (!latencies.empty())
+            {
+                result.avg_latency_ns = total_latency / latencies.size();
+                size_t p99 = std::min(latencies.size() - 1, latencies.size() * 99 / 100);
+                std::nth_element(latencies.begin(), latencies.begin() + p99, latencies.end());
+                result.p99_latency_ns = latencies[p99];
+            }
+            result.wall_ns = timestamp_ns() - wall_start;
+            return result;
+        }
+
+    public:
+        explicit Backtester(WorkStealingPool &pool) : pool_(pool) {}
+
+        // Fee tables to sweep volume tiers over (defaults to the published schedules)
+        void set_fee_schedule(const FeeSchedule &fees) { base_fees_ = fees; }
+
+        // Results come back in grid order
+        std::vector<BacktestResult> run(const std::vector<MarketUpdate> &updates,
+                                        const std::vector<BacktestConfig> &grid) const
+        {
+            std::vector<std::string> venues, symbols;
+            for (const auto &update : updates)
+            {
+                if (std::find(venues.begin(), venues.end(), update.exchange) == venues.end())
+                    venues.push_back(update.exchange);
+                if (std::find(symbols.begin(), symbols.end(), update.symbol) == symbols.end())
+                    symbols.push_back(update.symbol);
+            }
+
+            std::vector<BacktestResult> results(grid.size());
+            pool_.parallel_for(grid.size(), 1, [&](size_t begin, size_t end)
+                               {
+                for (size_t i = begin; i < end; ++i) {
+                    results[i] = run_one(updates, venues, symbols, grid[i]);
+                } });
+            return results;
+        }
+    };
+
+} // namespace arbisim
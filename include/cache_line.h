@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+namespace arbisim
+{
+
+    // Alignment that keeps data one thread writes off the cache lines other threads read
+    // or write. 64 bytes on x86-64 and most ARM cores; a fixed constant rather than
+    // std::hardware_destructive_interference_size, which older standard libraries lack
+    // and whose value can change with compiler flags.
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+} // namespace arbisim
@@ -0,0 +1,819 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "async_log_writer.h"
+
+namespace arbisim
+{
+
+    // Compact binary columnar log (.arbcol).
+    //
+    //   file   := header block*
+    //   header := "ARBCOL\0\0" u32 version u32 schema_id
+    //   block  := u32 body_bytes body footer
+    //   body   := column*            (schema order; each column is u32 bytes + payload)
+    //   footer := u32 'BEND' u32 rows u64 first_ts u64 last_ts u32 fnv1a(body)
+    //
+    // Column encodings: timestamps as zigzag varint deltas; venue and symbol names
+    // dictionary-encoded per block; prices as fixed-point cents, delta-encoded; bps as
+    // fixed-point tenths; counters as varints. Blocks are self-contained, and the length
+    // prefixes let a reader skip blocks (by footer time range) or columns it doesn't need.
+    namespace columnar
+    {
+        static constexpr char MAGIC[8] = {'A', 'R', 'B', 'C', 'O', 'L', 0, 0};
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t FOOTER_MAGIC = 0x444E4542; // "BEND"
+        static constexpr size_t FOOTER_BYTES = 28;
+
+        inline void put_u32(std::string &out, uint32_t v)
+        {
+            char b[4];
+            std::memcpy(b, &v, 4);
+            out.append(b, 4);
+        }
+
+        inline void put_u64(std::string &out, uint64_t v)
+        {
+            char b[8];
+            std::memcpy(b, &v, 8);
+            out.append(b, 8);
+        }
+
+        inline void put_varint(std::string &out, uint64_t v)
+        {
+            while (v >= 0x80)
+            {
+                out.push_back(static_cast<char>(v | 0x80));
+                v >>= 7;
+            }
+            out.push_back(static_cast<char>(v));
+        }
+
+        inline uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+        inline int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+        inline int64_t to_fixed(double v, int decimals)
+        {
+            static const double scale[] = {1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0};
+            return static_cast<int64_t>(std::llround(v * scale[decimals]));
+        }
+
+        inline double from_fixed(int64_t v, int decimals)
+        {
+            static const double scale[] = {1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0};
+            return static_cast<double>(v) / scale[decimals];
+        }
+
+        inline uint32_t fnv1a(const char *data, size_t len)
+        {
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i < len; ++i)
+            {
+                hash ^= static_cast<uint8_t>(data[i]);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        // Builds one block body, column by column
+        class BlockEncoder
+        {
+        private:
+            std::string body_;
+            std::string col_;
+            std::vector<std::string> dict_;
+
+            void end_column()
+            {
+                put_u32(body_, static_cast<uint32_t>(col_.size()));
+                body_ += col_;
+                col_.clear();
+            }
+
+        public:
+            void reset() { body_.clear(); }
+            const std::string &body() const { return body_; }
+
+            template <typename Get>
+            void delta_u64(size_t rows, Get get)
+            {
+                int64_t prev = 0;
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    int64_t v = static_cast<int64_t>(get(i));
+                    put_varint(col_, zigzag(v - prev));
+                    prev = v;
+                }
+                end_column();
+            }
+
+            template <typename Get>
+            void fixed_delta(size_t rows, int decimals, Get get)
+            {
+                int64_t prev = 0;
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    int64_t v = to_fixed(get(i), decimals);
+                    put_varint(col_, zigzag(v - prev));
+                    prev = v;
+                }
+                end_column();
+            }
+
+            template <typename Get>
+            void fixed(size_t rows, int decimals, Get get)
+            {
+                for (size_t i = 0; i < rows; ++i)
+                    put_varint(col_, zigzag(to_fixed(get(i), decimals)));
+                end_column();
+            }
+
+            template <typename Get>
+            void varint(size_t rows, Get get)
+            {
+                for (size_t i = 0; i < rows; ++i)
+                    put_varint(col_, get(i));
+                end_column();
+            }
+
+            template <typename Get>
+            void int8(size_t rows, Get get)
+            {
+                for (size_t i = 0; i < rows; ++i)
+                    col_.push_back(static_cast<char>(get(i)));
+                end_column();
+            }
+
+            // get(i) returns a NUL-terminated name; entries are stored once per block
+            template <typename Get>
+            void dict(size_t rows, Get get)
+            {
+                dict_.clear();
+                std::string ids;
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    const char *name = get(i);
+                    size_t id = 0;
+                    while (id < dict_.size() && dict_[id] != name)
+                        ++id;
+                    if (id == dict_.size())
+                        dict_.emplace_back(name);
+                    put_varint(ids, id);
+                }
+
+                put_varint(col_, dict_.size());
+                for (const auto &entry : dict_)
+                {
+                    put_varint(col_, entry.size());
+                    col_ += entry;
+                }
+                col_ += ids;
+                end_column();
+            }
+        };
+
+        // Reads the columns of one block body in schema order. Every method returns false
+        // on malformed input instead of reading past the block.
+        class BlockDecoder
+        {
+        private:
+            const char *p_;
+            const char *end_;
+            const char *col_end_ = nullptr;
+
+            bool get_varint(uint64_t &v)
+            {
+                v = 0;
+                for (int shift = 0; shift < 64 && p_ < col_end_; shift += 7)
+                {
+                    uint8_t byte = static_cast<uint8_t>(*p_++);
+                    v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if (!(byte & 0x80))
+                        return true;
+                }
+                return false;
+            }
+
+            bool begin_column()
+            {
+                if (end_ - p_ < 4)
+                    return false;
+                uint32_t len;
+                std::memcpy(&len, p_, 4);
+                p_ += 4;
+                if (static_cast<size_t>(end_ - p_) < len)
+                    return false;
+                col_end_ = p_ + len;
+                return true;
+            }
+
+            bool end_column()
+            {
+                p_ = col_end_;
+                return true;
+            }
+
+        public:
+            BlockDecoder(const char *data, size_t len) : p_(data), end_(data + len) {}
+
+            bool skip_column() { return begin_column() && end_column(); }
+
+            template <typename Set>
+            bool delta_u64(size_t rows, Set set)
+            {
+                if (!begin_column())
+                    return false;
+                int64_t prev = 0;
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    uint64_t z;
+                    if (!get_varint(z))
+                        return false;
+                    prev += unzigzag(z);
+                    set(i, static_cast<uint64_t>(prev));
+                }
+                return end_column();
+            }
+
+            template <typename Set>
+            bool fixed_delta(size_t rows, int decimals, Set set)
+            {
+                if (!begin_column())
+                    return false;
+                int64_t prev = 0;
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    uint64_t z;
+                    if (!get_varint(z))
+                        return false;
+                    prev += unzigzag(z);
+                    set(i, from_fixed(prev, decimals));
+                }
+                return end_column();
+            }
+
+            template <typename Set>
+            bool fixed(size_t rows, int decimals, Set set)
+            {
+                if (!begin_column())
+                    return false;
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    uint64_t z;
+                    if (!get_varint(z))
+                        return false;
+                    set(i, from_fixed(unzigzag(z), decimals));
+                }
+                return end_column();
+            }
+
+            template <typename Set>
+            bool varint(size_t rows, Set set)
+            {
+                if (!begin_column())
+                    return false;
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    uint64_t v;
+                    if (!get_varint(v))
+                        return false;
+                    set(i, v);
+                }
+                return end_column();
+            }
+
+            template <typename Set>
+            bool int8(size_t rows, Set set)
+            {
+                if (!begin_column() || static_cast<size_t>(col_end_ - p_) < rows)
+                    return false;
+                for (size_t i = 0; i < rows; ++i)
+                    set(i, static_cast<int8_t>(p_[i]));
+                return end_column();
+            }
+
+            // set(i, name, length); name points into the block and is not NUL-terminated
+            template <typename Set>
+            bool dict(size_t rows, Set set)
+            {
+                if (!begin_column())
+                    return false;
+                uint64_t count;
+                if (!get_varint(count) || count > 65536)
+                    return false;
+
+                std::vector<std::pair<const char *, size_t>> entries(count);
+                for (auto &entry : entries)
+                {
+                    uint64_t len;
+                    if (!get_varint(len) || static_cast<uint64_t>(col_end_ - p_) < len)
+                        return false;
+                    entry = {p_, static_cast<size_t>(len)};
+                    p_ += len;
+                }
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    uint64_t id;
+                    if (!get_varint(id) || id >= count)
+                        return false;
+                    set(i, entries[id].first, entries[id].second);
+                }
+                return end_column();
+            }
+        };
+
+        inline void copy_name(char (&dst)[16], const char *src, size_t len)
+        {
+            len = std::min(len, sizeof(dst) - 1);
+            std::memcpy(dst, src, len);
+            dst[len] = '\0';
+        }
+    } // namespace columnar
+
+    // Matched fill as archived by the engine
+    struct TradeRecord
+    {
+        uint64_t timestamp_ns = 0;
+        uint64_t trade_id = 0;
+        double quantity = 0.0;
+        double buy_price = 0.0;
+        double sell_price = 0.0;
+        double fees = 0.0;
+        double net_pnl = 0.0;
+        char symbol[16] = {};
+        char buy_exchange[16] = {};
+        char sell_exchange[16] = {};
+    };
+
+    // Column layout of the opportunity log
+    struct OpportunityColumns
+    {
+        using Record = OpportunityRecord;
+        static constexpr uint32_t schema_id = 1;
+        static constexpr const char *csv_header = OPPORTUNITY_CSV_HEADER;
+
+        static uint64_t timestamp(const Record &r) { return r.detected_at_ns; }
+
+        static void encode(const std::vector<Record> &r, columnar::BlockEncoder &enc)
+        {
+            size_t n = r.size();
+            enc.delta_u64(n, [&](size_t i)
+                          { return r[i].detected_at_ns; });
+            enc.dict(n, [&](size_t i)
+                     { return r[i].symbol; });
+            enc.dict(n, [&](size_t i)
+                     { return r[i].buy_exchange; });
+            enc.dict(n, [&](size_t i)
+                     { return r[i].sell_exchange; });
+            enc.fixed_delta(n, 2, [&](size_t i)
+                            { return r[i].buy_price; });
+            enc.fixed_delta(n, 2, [&](size_t i)
+                            { return r[i].sell_price; });
+            enc.fixed(n, 1, [&](size_t i)
+                      { return r[i].profit_bps; });
+            enc.fixed(n, 1, [&](size_t i)
+                      { return r[i].net_profit_bps; });
+            enc.varint(n, [&](size_t i)
+                       { return r[i].latency_ns; });
+            enc.int8(n, [&](size_t i)
+                     { return r[i].decision; });
+            enc.int8(n, [&](size_t i)
+                     { return static_cast<int8_t>(r[i].event); });
+            enc.varint(n, [&](size_t i)
+                       { return r[i].duration_ns; });
+        }
+
+        static bool decode(columnar::BlockDecoder &dec, std::vector<Record> &r)
+        {
+            size_t n = r.size();
+            return dec.delta_u64(n, [&](size_t i, uint64_t v)
+                                 { r[i].detected_at_ns = v; }) &&
+                   dec.dict(n, [&](size_t i, const char *s, size_t len)
+                            { columnar::copy_name(r[i].symbol, s, len); }) &&
+                   dec.dict(n, [&](size_t i, const char *s, size_t len)
+                            { columnar::copy_name(r[i].buy_exchange, s, len); }) &&
+                   dec.dict(n, [&](size_t i, const char *s, size_t len)
+                            { columnar::copy_name(r[i].sell_exchange, s, len); }) &&
+                   dec.fixed_delta(n, 2, [&](size_t i, double v)
+                                   { r[i].buy_price = v; }) &&
+                   dec.fixed_delta(n, 2, [&](size_t i, double v)
+                                   { r[i].sell_price = v; }) &&
+                   dec.fixed(n, 1, [&](size_t i, double v)
+                             { r[i].profit_bps = v; }) &&
+                   dec.fixed(n, 1, [&](size_t i, double v)
+                             { r[i].net_profit_bps = v; }) &&
+                   dec.varint(n, [&](size_t i, uint64_t v)
+                              { r[i].latency_ns = v; }) &&
+                   dec.int8(n, [&](size_t i, int8_t v)
+                            { r[i].decision = v; }) &&
+                   dec.int8(n, [&](size_t i, int8_t v)
+                            { r[i].event = static_cast<uint8_t>(v); }) &&
+                   dec.varint(n, [&](size_t i, uint64_t v)
+                              { r[i].duration_ns = v; });
+        }
+
+        static char *format_csv(const Record &r, char *p, char *end)
+        {
+            return csv::format_opportunity_csv(r, p, end);
+        }
+    };
+
+    // Column layout of the trade log
+    struct TradeColumns
+    {
+        using Record = TradeRecord;
+        static constexpr uint32_t schema_id = 2;
+        static constexpr const char *csv_header =
+            "timestamp,trade_id,symbol,buy_exchange,sell_exchange,quantity,buy_price,sell_price,fees,net_pnl\n";
+
+        static uint64_t timestamp(const Record &r) { return r.timestamp_ns; }
+
+        static void encode(const std::vector<Record> &r, columnar::BlockEncoder &enc)
+        {
+            size_t n = r.size();
+            enc.delta_u64(n, [&](size_t i)
+                          { return r[i].timestamp_ns; });
+            enc.delta_u64(n, [&](size_t i)
+                          { return r[i].trade_id; });
+            enc.dict(n, [&](size_t i)
+                     { return r[i].symbol; });
+            enc.dict(n, [&](size_t i)
+                     { return r[i].buy_exchange; });
+            enc.dict(n, [&](size_t i)
+                     { return r[i].sell_exchange; });
+            enc.fixed(n, 6, [&](size_t i)
+                      { return r[i].quantity; });
+            enc.fixed_delta(n, 2, [&](size_t i)
+                            { return r[i].buy_price; });
+            enc.fixed_delta(n, 2, [&](size_t i)
+                            { return r[i].sell_price; });
+            enc.fixed(n, 4, [&](size_t i)
+                      { return r[i].fees; });
+            enc.fixed(n, 4, [&](size_t i)
+                      { return r[i].net_pnl; });
+        }
+
+        static bool decode(columnar::BlockDecoder &dec, std::vector<Record> &r)
+        {
+            size_t n = r.size();
+            return dec.delta_u64(n, [&](size_t i, uint64_t v)
+                                 { r[i].timestamp_ns = v; }) &&
+                   dec.delta_u64(n, [&](size_t i, uint64_t v)
+                                 { r[i].trade_id = v; }) &&
+                   dec.dict(n, [&](size_t i, const char *s, size_t len)
+                            { columnar::copy_name(r[i].symbol, s, len); }) &&
+                   dec.dict(n, [&](size_t i, const char *s, size_t len)
+                            { columnar::copy_name(r[i].buy_exchange, s, len); }) &&
+                   dec.dict(n, [&](size_t i, const char *s, size_t len)
+                            { columnar::copy_name(r[i].sell_exchange, s, len); }) &&
+                   dec.fixed(n, 6, [&](size_t i, double v)
+                             { r[i].quantity = v; }) &&
+                   dec.fixed_delta(n, 2, [&](size_t i, double v)
+                                   { r[i].buy_price = v; }) &&
+                   dec.fixed_delta(n, 2, [&](size_t i, double v)
+                                   { r[i].sell_price = v; }) &&
+                   dec.fixed(n, 4, [&](size_t i, double v)
+                             { r[i].fees = v; }) &&
+                   dec.fixed(n, 4, [&](size_t i, double v)
+                             { r[i].net_pnl = v; });
+        }
+
+        static char *format_csv(const Record &r, char *p, char *end)
+        {
+            p = std::to_chars(p, end, r.timestamp_ns).ptr;
+            *p++ = ',';
+            p = std::to_chars(p, end, r.trade_id).ptr;
+            *p++ = ',';
+            p = csv::put_str(p, r.symbol);
+            *p++ = ',';
+            p = csv::put_str(p, r.buy_exchange);
+            *p++ = ',';
+            p = csv::put_str(p, r.sell_exchange);
+            *p++ = ',';
+            p = csv::put_fixed(p, end, r.quantity, 6);
+            *p++ = ',';
+            p = csv::put_fixed(p, end, r.buy_price, 2);
+            *p++ = ',';
+            p = csv::put_fixed(p, end, r.sell_price, 2);
+            *p++ = ',';
+            p = csv::put_fixed(p, end, r.fees, 4);
+            *p++ = ',';
+            p = csv::put_fixed(p, end, r.net_pnl, 4);
+            *p++ = '\n';
+            return p;
+        }
+    };
+
+    // Appends records and writes a block every rows_per_block rows (and on flush/close).
+    // Thread-safe; the block encode and write happen on whichever thread fills the block.
+    template <typename Columns>
+    class ColumnarLogWriter
+    {
+    public:
+        using Record = typename Columns::Record;
+
+        struct Stats
+        {
+            uint64_t rows = 0;
+            uint64_t blocks = 0;
+            uint64_t bytes = 0;
+        };
+
+    private:
+        std::mutex mutex_;
+        std::FILE *file_ = nullptr;
+        size_t rows_per_block_;
+        std::vector<Record> rows_;
+        columnar::BlockEncoder encoder_;
+        std::string block_;
+        Stats stats_;
+
+        void write_block()
+        {
+            if (rows_.empty() || !file_)
+                return;
+
+            encoder_.reset();
+            Columns::encode(rows_, encoder_);
+            const std::string &body = encoder_.body();
+
+            block_.clear();
+            columnar::put_u32(block_, static_cast<uint32_t>(body.size()));
+            block_ += body;
+            columnar::put_u32(block_, columnar::FOOTER_MAGIC);
+            columnar::put_u32(block_, static_cast<uint32_t>(rows_.size()));
+            columnar::put_u64(block_, Columns::timestamp(rows_.front()));
+            columnar::put_u64(block_, Columns::timestamp(rows_.back()));
+            columnar::put_u32(block_, columnar::fnv1a(body.data(), body.size()));
+
+            std::fwrite(block_.data(), 1, block_.size(), file_);
+            std::fflush(file_);
+            stats_.rows += rows_.size();
+            stats_.blocks++;
+            stats_.bytes += block_.size();
+            rows_.clear();
+        }
+
+    public:
+        explicit ColumnarLogWriter(size_t rows_per_block = 4096)
+            : rows_per_block_(std::max<size_t>(1, rows_per_block))
+        {
+            rows_.reserve(rows_per_block_);
+        }
+
+        ~ColumnarLogWriter() { close(); }
+
+        ColumnarLogWriter(const ColumnarLogWriter &) = delete;
+        ColumnarLogWriter &operator=(const ColumnarLogWriter &) = delete;
+
+        bool open(const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            file_ = std::fopen(path.c_str(), "wb");
+            if (!file_)
+                return false;
+
+            std::string header(columnar::MAGIC, sizeof(columnar::MAGIC));
+            columnar::put_u32(header, columnar::VERSION);
+            columnar::put_u32(header, Columns::schema_id);
+            std::fwrite(header.data(), 1, header.size(), file_);
+            stats_.bytes += header.size();
+            return true;
+        }
+
+        bool is_open()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return file_ != nullptr;
+        }
+
+        void append(const Record &record)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!file_)
+                return;
+            rows_.push_back(record);
+            if (rows_.size() >= rows_per_block_)
+                write_block();
+        }
+
+        template <typename It>
+        void append(It first, It last)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!file_)
+                return;
+            for (; first != last; ++first)
+            {
+                rows_.push_back(*first);
+                if (rows_.size() >= rows_per_block_)
+                    write_block();
+            }
+        }
+
+        // Write the partial block now (smaller blocks, but nothing left only in memory)
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            write_block();
+        }
+
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            write_block();
+            if (file_)
+            {
+                std::fclose(file_);
+                file_ = nullptr;
+            }
+        }
+
+        Stats get_stats()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return stats_;
+        }
+    };
+
+    // Schema id of an .arbcol file, or 0 if it is not one
+    inline uint32_t columnar_schema_id(const std::string &path)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return 0;
+        char header[16];
+        bool ok = std::fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                  std::memcmp(header, columnar::MAGIC, sizeof(columnar::MAGIC)) == 0;
+        std::fclose(file);
+        if (!ok)
+            return 0;
+        uint32_t schema;
+        std::memcpy(&schema, header + 12, 4);
+        return schema;
+    }
+
+    // Sequential block reader. A truncated or corrupt trailing block (e.g. after a crash)
+    // ends the stream; everything before it is still returned.
+    template <typename Columns>
+    class ColumnarLogReader
+    {
+    public:
+        using Record = typename Columns::Record;
+
+        struct BlockInfo
+        {
+            uint32_t rows = 0;
+            uint64_t first_ts = 0;
+            uint64_t last_ts = 0;
+        };
+
+    private:
+        std::FILE *file_ = nullptr;
+        std::string body_;
+        bool corrupt_ = false;
+
+        bool read_block_header(uint32_t &body_bytes)
+        {
+            char b[4];
+            if (std::fread(b, 1, 4, file_) != 4)
+                return false;
+            std::memcpy(&body_bytes, b, 4);
+            return true;
+        }
+
+    public:
+        ColumnarLogReader() = default;
+        ~ColumnarLogReader() { close(); }
+
+        ColumnarLogReader(const ColumnarLogReader &) = delete;
+        ColumnarLogReader &operator=(const ColumnarLogReader &) = delete;
+
+        bool open(const std::string &path)
+        {
+            close();
+            if (columnar_schema_id(path) != Columns::schema_id)
+                return false;
+            file_ = std::fopen(path.c_str(), "rb");
+            if (!file_)
+                return false;
+            std::fseek(file_, 16, SEEK_SET);
+            corrupt_ = false;
+            return true;
+        }
+
+        void close()
+        {
+            if (file_)
+            {
+                std::fclose(file_);
+                file_ = nullptr;
+            }
+        }
+
+        // True if reading stopped at a damaged block rather than a clean end of file
+        bool corrupt() const { return corrupt_; }
+
+        // Raw body of the next block, for readers that decode only some columns
+        bool next_raw_block(const char *&body, size_t &body_bytes, BlockInfo &info)
+        {
+            uint32_t len;
+            if (!file_ || !read_block_header(len))
+                return false;
+
+            body_.resize(len + columnar::FOOTER_BYTES);
+            if (std::fread(&body_[0], 1, body_.size(), file_) != body_.size())
+            {
+                corrupt_ = true;
+                return false;
+            }
+
+            const char *footer = body_.data() + len;
+            uint32_t magic, checksum;
+            std::memcpy(&magic, footer, 4);
+            std::memcpy(&info.rows, footer + 4, 4);
+            std::memcpy(&info.first_ts, footer + 8, 8);
+            std::memcpy(&info.last_ts, footer + 16, 8);
+            std::memcpy(&checksum, footer + 24, 4);
+            if (magic != columnar::FOOTER_MAGIC || checksum != columnar::fnv1a(body_.data(), len))
+            {
+                corrupt_ = true;
+                return false;
+            }
+
+            body = body_.data();
+            body_bytes = len;
+            return true;
+        }
+
+        // Decode the next block into out (replacing its contents). Blocks whose footer
+        // time range misses [from_ns, to_ns] are skipped without decoding.
+        bool next_block(std::vector<Record> &out, BlockInfo *info = nullptr,
+                        uint64_t from_ns = 0, uint64_t to_ns = UINT64_MAX)
+        {
+            const char *body;
+            size_t body_bytes;
+            BlockInfo block;
+            while (next_raw_block(body, body_bytes, block))
+            {
+                if (block.last_ts < from_ns || block.first_ts > to_ns)
+                    continue;
+
+                out.assign(block.rows, Record{});
+                columnar::BlockDecoder decoder(body, body_bytes);
+                if (!Columns::decode(decoder, out))
+                {
+                    corrupt_ = true;
+                    return false;
+                }
+                if (info)
+                    *info = block;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    // Convert a whole .arbcol file to CSV; returns the number of rows written or -1
+    template <typename Columns>
+    long long columnar_to_csv(const std::string &in_path, std::FILE *out)
+    {
+        ColumnarLogReader<Columns> reader;
+        if (!reader.open(in_path))
+            return -1;
+
+        std::fputs(Columns::csv_header, out);
+        std::vector<typename Columns::Record> rows;
+        std::vector<char> buffer(256 * 1024);
+        long long total = 0;
+
+        while (reader.next_block(rows))
+        {
+            char *p = buffer.data();
+            char *end = buffer.data() + buffer.size();
+            for (const auto &row : rows)
+            {
+                if (end - p < 256)
+                {
+                    std::fwrite(buffer.data(), 1, p - buffer.data(), out);
+                    p = buffer.data();
+                }
+                p = Columns::format_csv(row, p, end);
+            }
+            std::fwrite(buffer.data(), 1, p - buffer.data(), out);
+            total += static_cast<long long>(rows.size());
+        }
+        if (reader.corrupt())
+            std::fprintf(stderr, "warning: %s ends in a damaged block, stopped after %lld rows\n",
+                         in_path.c_str(), total);
+        return total;
+    }
+
+} // namespace arbisim
@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "arbisim_core.h"
+
+namespace arbisim
+{
+
+    // Hand-off from the feed threads to the market thread. Feeds append; the market
+    // thread swaps out everything pending in one go, applies every delta in arrival
+    // order, and runs detection once per touched symbol instead of once per update.
+    // Nothing is dropped: only the detection work on intermediate book states is saved.
+    class ConflatingUpdateQueue
+    {
+    public:
+        struct Stats
+        {
+            uint64_t pushed = 0;
+            uint64_t drained = 0;
+            uint64_t drain_cycles = 0;
+            size_t max_batch = 0;
+        };
+
+    private:
+        mutable std::mutex mutex_;
+        std::condition_variable ready_cv_;
+        std::vector<MarketUpdate> pending_;
+        bool closed_ = false;
+        Stats stats_;
+
+    public:
+        explicit ConflatingUpdateQueue(size_t reserve = 1024)
+        {
+            pending_.reserve(reserve);
+        }
+
+        // trace_id and enqueued_ns are stamped on the queued copy (see PipelineTracer)
+        void push(const MarketUpdate &update, uint64_t trace_id = 0, uint64_t enqueued_ns = 0)
+        {
+            bool was_empty;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (closed_)
+                    return;
+                was_empty = pending_.empty();
+                pending_.push_back(update);
+                pending_.back().trace_id = trace_id;
+                pending_.back().enqueued_ns = enqueued_ns;
+                stats_.pushed++;
+            }
+            // The market thread only sleeps on an empty queue
+            if (was_empty)
+                ready_cv_.notify_one();
+        }
+
+        // Swap every pending update into out (cleared first). Blocks up to timeout for
+        // the first update; returns false once closed and empty.
+        bool drain(std::vector<MarketUpdate> &out, std::chrono::milliseconds timeout)
+        {
+            out.clear();
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_cv_.wait_for(lock, timeout, [this]()
+                               { return closed_ || !pending_.empty(); });
+
+            if (pending_.empty())
+                return !closed_;
+
+            out.swap(pending_);
+            stats_.drained += out.size();
+            stats_.drain_cycles++;
+            stats_.max_batch = std::max(stats_.max_batch, out.size());
+            return true;
+        }
+
+        // Refuse further pushes and wake the market thread; pending updates still drain
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+            }
+            ready_cv_.notify_all();
+        }
+
+        Stats get_stats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return stats_;
+        }
+    };
+
+} // namespace arbisim
@@ -0,0 +1,240 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "async_log_writer.h"
+#include "latency_histogram.h"
+
+namespace arbisim
+{
+
+    // OHLC of one quantity over an interval
+    struct OhlcBar
+    {
+        double open = 0.0;
+        double high = 0.0;
+        double low = 0.0;
+        double close = 0.0;
+        uint32_t samples = 0;
+
+        void add(double value)
+        {
+            if (samples == 0)
+                open = high = low = value;
+            high = std::max(high, value);
+            low = std::min(low, value);
+            close = value;
+            samples++;
+        }
+
+        // Append a later bar (open stays ours, close becomes theirs)
+        void merge(const OhlcBar &later)
+        {
+            if (later.samples == 0)
+                return;
+            if (samples == 0)
+            {
+                *this = later;
+                return;
+            }
+            high = std::max(high, later.high);
+            low = std::min(low, later.low);
+            close = later.close;
+            samples += later.samples;
+        }
+
+        // A quiet interval repeats the last level so charts stay continuous
+        void carry(double last)
+        {
+            open = high = low = close = last;
+            samples = 0;
+        }
+    };
+
+    // Everything the dashboard shows for one interval
+    struct DashboardBar
+    {
+        static constexpr size_t MAX_PAIRS = 32;
+
+        struct PairCount
+        {
+            char pair[48] = {}; // "BTCUSDT binance>kraken"
+            uint32_t count = 0;
+            uint32_t approved = 0;
+        };
+
+        uint64_t start_ns = 0;
+        OhlcBar spread_bps; // Best cross-venue spread: max bid vs min ask, in bps of mid
+        uint64_t opportunities = 0; // OPEN and UPDATE events
+        uint64_t closed = 0;
+        uint64_t approved = 0;
+        LatencyHistogram latency_ns;
+        size_t pair_count = 0;
+        std::array<PairCount, MAX_PAIRS> pairs;
+
+        void reset(uint64_t start)
+        {
+            start_ns = start;
+            opportunities = closed = approved = 0;
+            latency_ns.reset();
+            pair_count = 0;
+        }
+    };
+
+    // Per-interval aggregates for the dashboard at a few fixed resolutions, plus a
+    // sampled event stream (best opportunity per pair per sample interval). Owned by the
+    // dashboard server thread; every input is O(1) per resolution and every output is
+    // one bar per interval, however many events went in.
+    class DashboardAggregator
+    {
+    public:
+        struct Resolution
+        {
+            const char *name;
+            uint64_t interval_ns;
+        };
+
+        static constexpr size_t RESOLUTIONS = 3;
+        static constexpr std::array<Resolution, RESOLUTIONS> resolutions = {{{"100ms", 100000000ULL},
+                                                                             {"1s", 1000000000ULL},
+                                                                             {"1m", 60000000000ULL}}};
+
+        // Resolution index by name, or -1
+        static int resolution_index(const char *name, size_t len)
+        {
+            for (size_t i = 0; i < RESOLUTIONS; ++i)
+                if (std::strlen(resolutions[i].name) == len && std::memcmp(resolutions[i].name, name, len) == 0)
+                    return static_cast<int>(i);
+            return -1;
+        }
+
+    private:
+        std::array<DashboardBar, RESOLUTIONS> bars_;
+        double last_spread_ = 0.0;
+        bool started_ = false;
+
+        // Sampled stream: the highest-profit event per pair since the last sample
+        uint64_t next_sample_ns_ = 0;
+        std::vector<OpportunityRecord> samples_;
+
+        static void pair_key(const OpportunityRecord &r, char (&out)[48])
+        {
+            std::snprintf(out, sizeof(out), "%s %s>%s", r.symbol, r.buy_exchange, r.sell_exchange);
+        }
+
+        static bool same_pair(const OpportunityRecord &a, const OpportunityRecord &b)
+        {
+            return std::strcmp(a.buy_exchange, b.buy_exchange) == 0 &&
+                   std::strcmp(a.sell_exchange, b.sell_exchange) == 0 &&
+                   std::strcmp(a.symbol, b.symbol) == 0;
+        }
+
+        void start(uint64_t now_ns)
+        {
+            for (size_t i = 0; i < RESOLUTIONS; ++i)
+                bars_[i].reset(now_ns - now_ns % resolutions[i].interval_ns);
+            next_sample_ns_ = bars_[0].start_ns + resolutions[0].interval_ns;
+            started_ = true;
+        }
+
+    public:
+        // Events are timed by when the server sees them (at most one poll interval late)
+        void add_opportunity(const OpportunityRecord &r, uint64_t now_ns)
+        {
+            if (!started_)
+                start(now_ns);
+
+            bool close = r.decision < 0;
+            char key[48];
+            pair_key(r, key);
+            for (auto &bar : bars_)
+            {
+                if (close)
+                {
+                    bar.closed++;
+                    continue;
+                }
+                bar.opportunities++;
+                bar.approved += r.decision == 0;
+                bar.latency_ns.record(r.latency_ns);
+
+                DashboardBar::PairCount *slot = nullptr;
+                for (size_t p = 0; p < bar.pair_count; ++p)
+                    if (std::strcmp(bar.pairs[p].pair, key) == 0)
+                        slot = &bar.pairs[p];
+                if (!slot && bar.pair_count < DashboardBar::MAX_PAIRS)
+                {
+                    slot = &bar.pairs[bar.pair_count++];
+                    std::memcpy(slot->pair, key, sizeof(key));
+                    slot->count = slot->approved = 0;
+                }
+                if (slot)
+                {
+                    slot->count++;
+                    slot->approved += r.decision == 0;
+                }
+            }
+
+            if (close)
+                return;
+            for (auto &sample : samples_)
+            {
+                if (same_pair(sample, r))
+                {
+                    if (r.profit_bps >= sample.profit_bps)
+                        sample = r;
+                    return;
+                }
+            }
+            samples_.push_back(r);
+        }
+
+        void add_spread(const OhlcBar &spread, uint64_t now_ns)
+        {
+            if (spread.samples == 0)
+                return;
+            if (!started_)
+                start(now_ns);
+            for (auto &bar : bars_)
+                bar.spread_bps.merge(spread);
+            last_spread_ = spread.close;
+        }
+
+        // Close every bar whose interval has ended: on_bar(resolution, bar) for each,
+        // oldest resolution first. A gap of several intervals yields one bar.
+        template <typename OnBar>
+        void advance(uint64_t now_ns, OnBar on_bar)
+        {
+            if (!started_)
+                start(now_ns);
+            for (size_t i = 0; i < RESOLUTIONS; ++i)
+            {
+                DashboardBar &bar = bars_[i];
+                uint64_t interval = resolutions[i].interval_ns;
+                if (now_ns < bar.start_ns + interval)
+                    continue;
+                if (bar.spread_bps.samples == 0)
+                    bar.spread_bps.carry(last_spread_);
+                on_bar(i, bar);
+                bar.reset(now_ns - now_ns % interval);
+                bar.spread_bps.carry(last_spread_);
+            }
+        }
+
+        // Hand out the sampled events once per sample interval (the finest resolution)
+        template <typename OnSample>
+        void take_samples(uint64_t now_ns, OnSample on_sample)
+        {
+            if (now_ns < next_sample_ns_)
+                return;
+            next_sample_ns_ = now_ns - now_ns % resolutions[0].interval_ns + resolutions[0].interval_ns;
+            for (const auto &sample : samples_)
+                on_sample(sample);
+            samples_.clear();
+        }
+    };
+
+} // namespace arbisim
@@ -0,0 +1,976 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "async_log_writer.h"
+#include "dashboard_aggregator.h"
+#include "net_socket.h"
+
+namespace arbisim
+{
+
+    // WebSocket (RFC 6455) pieces the dashboard server needs: the handshake
+    // accept key and unmasked server-to-client frame headers
+    namespace websocket
+    {
+        inline std::array<uint8_t, 20> sha1(const std::string &message)
+        {
+            uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+            auto rotl = [](uint32_t v, int n)
+            { return (v << n) | (v >> (32 - n)); };
+
+            std::string data = message;
+            uint64_t bit_len = static_cast<uint64_t>(message.size()) * 8;
+            data += static_cast<char>(0x80);
+            while (data.size() % 64 != 56)
+                data += '\0';
+            for (int i = 7; i >= 0; --i)
+                data += static_cast<char>((bit_len >> (i * 8)) & 0xFF);
+
+            for (size_t chunk = 0; chunk < data.size(); chunk += 64)
+            {
+                uint32_t w[80];
+                for (int i = 0; i < 16; ++i)
+                {
+                    const auto *p = reinterpret_cast<const uint8_t *>(data.data() + chunk + i * 4);
+                    w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+                }
+                for (int i = 16; i < 80; ++i)
+                    w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+                uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                for (int i = 0; i < 80; ++i)
+                {
+                    uint32_t f, k;
+                    if (i < 20)
+                        f = (b & c) | (~b & d), k = 0x5A827999;
+                    else if (i < 40)
+                        f = b ^ c ^ d, k = 0x6ED9EBA1;
+                    else if (i < 60)
+                        f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+                    else
+                        f = b ^ c ^ d, k = 0xCA62C1D6;
+                    uint32_t t = rotl(a, 5) + f + e + k + w[i];
+                    e = d;
+                    d = c;
+                    c = rotl(b, 30);
+                    b = a;
+                    a = t;
+                }
+                h[0] += a;
+                h[1] += b;
+                h[2] += c;
+                h[3] += d;
+                h[4] += e;
+            }
+
+            std::array<uint8_t, 20> digest;
+            for (int i = 0; i < 20; ++i)
+                digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - (i % 4) * 8));
+            return digest;
+        }
+
+        inline std::string base64(const uint8_t *data, size_t len)
+        {
+            static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::string out;
+            for (size_t i = 0; i < len; i += 3)
+            {
+                uint32_t v = uint32_t(data[i]) << 16;
+                if (i + 1 < len)
+                    v |= uint32_t(data[i + 1]) << 8;
+                if (i + 2 < len)
+                    v |= data[i + 2];
+                out += table[(v >> 18) & 63];
+                out += table[(v >> 12) & 63];
+                out += i + 1 < len ? table[(v >> 6) & 63] : '=';
+                out += i + 2 < len ? table[v & 63] : '=';
+            }
+            return out;
+        }
+
+        inline std::string accept_key(const std::string &client_key)
+        {
+            auto digest = sha1(client_key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+            return base64(digest.data(), digest.size());
+        }
+
+        enum Opcode : uint8_t
+        {
+            TEXT = 0x1,
+            CLOSE = 0x8,
+            PING = 0x9,
+            PONG = 0xA
+        };
+
+        // Final frame, no mask (server to client)
+        inline void append_frame(std::string &out, Opcode opcode, const char *payload, size_t len)
+        {
+            out += static_cast<char>(0x80 | opcode);
+            if (len < 126)
+            {
+                out += static_cast<char>(len);
+            }
+            else if (len <= 0xFFFF)
+            {
+                out += static_cast<char>(126);
+                out += static_cast<char>((len >> 8) & 0xFF);
+                out += static_cast<char>(len & 0xFF);
+            }
+            else
+            {
+                out += static_cast<char>(127);
+                for (int i = 7; i >= 0; --i)
+                    out += static_cast<char>((static_cast<uint64_t>(len) >> (i * 8)) & 0xFF);
+            }
+            out.append(payload, len);
+        }
+    } // namespace websocket
+
+    // Dashboard-facing events. Opportunities go through the ring in order; prices are
+    // conflated to the latest value per venue; metrics are pulled when due.
+    struct DashboardMetrics
+    {
+        uint64_t total_opportunities = 0;
+        double avg_latency_us = 0.0;
+        double daily_pnl = 0.0;
+        double win_rate_pct = 0.0;
+    };
+
+    // Compact JSON in the message shapes dashboard.html already understands
+    namespace dashboard_json
+    {
+        inline char *put_key(char *p, const char *key)
+        {
+            *p++ = '"';
+            p = csv::put_str(p, key);
+            *p++ = '"';
+            *p++ = ':';
+            return p;
+        }
+
+        inline char *put_string(char *p, const char *key, const char *value)
+        {
+            p = put_key(p, key);
+            *p++ = '"';
+            p = csv::put_str(p, value);
+            *p++ = '"';
+            return p;
+        }
+
+        // Writes one message; needs at most 512 bytes
+        inline char *opportunity(const OpportunityRecord &r, char *p, char *end)
+        {
+            static const char *events[] = {"open", "update", "close"};
+            bool close = r.decision < 0;
+            p = csv::put_str(p, close ? "{\"type\":\"opportunity_close\",\"opportunity\":{"
+                                      : "{\"type\":\"opportunity\",\"opportunity\":{");
+            p = put_string(p, "symbol", r.symbol);
+            *p++ = ',';
+            p = put_string(p, "buy_exchange", r.buy_exchange);
+            *p++ = ',';
+            p = put_string(p, "sell_exchange", r.sell_exchange);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "buy_price"), end, r.buy_price, 2);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "sell_price"), end, r.sell_price, 2);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "profit_bps"), end, r.profit_bps, 1);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "net_profit_bps"), end, r.net_profit_bps, 1);
+            *p++ = ',';
+            p = std::to_chars(put_key(p, "latency_ns"), end, r.latency_ns).ptr;
+            *p++ = ',';
+            p = csv::put_str(put_key(p, "approved"), r.decision == 0 ? "true" : "false");
+            *p++ = ',';
+            p = std::to_chars(put_key(p, "decision"), end, static_cast<int>(r.decision)).ptr;
+            *p++ = ',';
+            p = std::to_chars(put_key(p, "detected_at_ns"), end, r.detected_at_ns).ptr;
+            *p++ = ',';
+            p = put_string(p, "event", events[std::min<uint8_t>(r.event, 2)]);
+            *p++ = ',';
+            p = std::to_chars(put_key(p, "duration_ns"), end, r.duration_ns).ptr;
+            *p++ = '}';
+            *p++ = '}';
+            return p;
+        }
+
+        inline char *price_update(const char *exchange, double price, char *p, char *end)
+        {
+            p = csv::put_str(p, "{\"type\":\"price_update\",");
+            p = put_string(p, "exchange", exchange);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "price"), end, price, 2);
+            *p++ = '}';
+            return p;
+        }
+
+        inline char *metrics(const DashboardMetrics &m, char *p, char *end)
+        {
+            p = csv::put_str(p, "{\"type\":\"metrics\",\"metrics\":{");
+            p = std::to_chars(put_key(p, "total_opportunities"), end, m.total_opportunities).ptr;
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "avg_latency"), end, m.avg_latency_us, 1);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "daily_pnl"), end, m.daily_pnl, 2);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "win_rate"), end, m.win_rate_pct, 1);
+            *p++ = '}';
+            *p++ = '}';
+            return p;
+        }
+
+        // Writes one bar; needs at most 4096 bytes (32 pairs)
+        inline char *bar(const char *resolution, const DashboardBar &b, char *p, char *end)
+        {
+            p = csv::put_str(p, "{\"type\":\"bar\",");
+            p = put_string(p, "resolution", resolution);
+            *p++ = ',';
+            p = std::to_chars(put_key(p, "start_ns"), end, b.start_ns).ptr;
+            p = csv::put_str(p, ",\"spread_bps\":{");
+            p = csv::put_fixed(put_key(p, "open"), end, b.spread_bps.open, 2);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "high"), end, b.spread_bps.high, 2);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "low"), end, b.spread_bps.low, 2);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "close"), end, b.spread_bps.close, 2);
+            p = csv::put_str(p, "},");
+            p = std::to_chars(put_key(p, "opportunities"), end, b.opportunities).ptr;
+            *p++ = ',';
+            p = std::to_chars(put_key(p, "closed"), end, b.closed).ptr;
+            *p++ = ',';
+            p = std::to_chars(put_key(p, "approved"), end, b.approved).ptr;
+            *p++ = ',';
+            double rate = b.opportunities ? static_cast<double>(b.approved) / b.opportunities : 0.0;
+            p = csv::put_fixed(put_key(p, "approval_rate"), end, rate, 3);
+            p = csv::put_str(p, ",\"latency_us\":{");
+            p = csv::put_fixed(put_key(p, "p50"), end, b.latency_ns.percentile(0.50) / 1000.0, 1);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "p99"), end, b.latency_ns.percentile(0.99) / 1000.0, 1);
+            *p++ = ',';
+            p = csv::put_fixed(put_key(p, "max"), end, b.latency_ns.max() / 1000.0, 1);
+            p = csv::put_str(p, "},\"pairs\":[");
+            for (size_t i = 0; i < b.pair_count; ++i)
+            {
+                if (i > 0)
+                    *p++ = ',';
+                *p++ = '{';
+                p = put_string(p, "pair", b.pairs[i].pair);
+                *p++ = ',';
+                p = std::to_chars(put_key(p, "count"), end, b.pairs[i].count).ptr;
+                *p++ = ',';
+                p = std::to_chars(put_key(p, "approved"), end, b.pairs[i].approved).ptr;
+                *p++ = '}';
+            }
+            *p++ = ']';
+            *p++ = '}';
+            return p;
+        }
+    } // namespace dashboard_json
+
+    // Fixed-size ring of opportunity records. Producers overwrite the oldest slot and
+    // never wait; a reader that falls a full lap behind skips ahead and counts the loss.
+    class DashboardEventRing
+    {
+    private:
+        mutable std::mutex mutex_;
+        std::vector<OpportunityRecord> slots_;
+        uint64_t head_ = 0; // Sequence number of the next write
+
+    public:
+        explicit DashboardEventRing(size_t capacity = 4096)
+            : slots_(std::max<size_t>(1, capacity)) {}
+
+        void push(const OpportunityRecord &record)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slots_[head_ % slots_.size()] = record;
+            head_++;
+        }
+
+        // Append everything after cursor to out and advance cursor; returns events lost
+        uint64_t read(uint64_t &cursor, std::vector<OpportunityRecord> &out) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            uint64_t lost = 0;
+            if (head_ - cursor > slots_.size())
+            {
+                lost = head_ - slots_.size() - cursor;
+                cursor = head_ - slots_.size();
+            }
+            for (; cursor < head_; ++cursor)
+                out.push_back(slots_[cursor % slots_.size()]);
+            return lost;
+        }
+
+        void reset(size_t capacity)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slots_.assign(std::max<size_t>(1, capacity), OpportunityRecord());
+            head_ = 0;
+        }
+
+        uint64_t head() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return head_;
+        }
+    };
+
+    struct DashboardServerConfig
+    {
+        std::string host = "127.0.0.1"; // Loopback only: the stream is unauthenticated
+        uint16_t port = 8080;           // What dashboard.html connects to (0 = any free port)
+        size_t ring_capacity = 4096;
+        int poll_interval_ms = 5;        // Upper bound on publish-to-send delay
+        uint64_t price_interval_ms = 250;
+        uint64_t metrics_interval_ms = 1000;
+        size_t max_clients = 16;
+        size_t max_client_backlog = 4 * 1024 * 1024; // Disconnect clients this far behind
+    };
+
+    // Which opportunity events a client receives: every one, the best per pair per 100ms,
+    // or none (bars only)
+    enum class DashboardEvents : uint8_t
+    {
+        ALL,
+        SAMPLED,
+        NONE
+    };
+
+    // WebSocket push server for the dashboard, on its own thread. Engine threads publish
+    // into an in-memory ring; each poll cycle the server encodes new events once and
+    // appends the frames to every connected client's send buffer, so a slow browser
+    // costs memory up to its backlog limit and never stalls the engine.
+    //
+    // Clients may send {"type":"subscribe","events":"all|sampled|none","bars":["100ms","1s","1m"]}.
+    // Bars and sampled events are encoded once per interval whatever the event rate, so a
+    // client that skips the raw stream costs the same during a burst as when idle. New
+    // clients get all events and no bars, as before.
+    class DashboardServer
+    {
+    public:
+        struct Stats
+        {
+            uint64_t published = 0;
+            uint64_t sent_messages = 0;
+            uint64_t sent_bytes = 0;
+            uint64_t lost = 0; // Overwritten in the ring before the server read them
+            uint64_t clients_accepted = 0;
+            uint64_t clients_dropped = 0; // Disconnected for exceeding the backlog limit
+            size_t clients_connected = 0;
+            uint64_t bars = 0; // Bars closed, all resolutions
+        };
+
+    private:
+        struct Client
+        {
+            net::socket_t socket;
+            bool upgraded = false;
+            bool closing = false;
+            std::string in;
+            std::string out;
+            size_t out_offset = 0;
+            DashboardEvents events = DashboardEvents::ALL;
+            unsigned bar_mask = 0; // Bit i = DashboardAggregator::resolutions[i]
+        };
+
+        struct VenuePrice
+        {
+            char exchange[16] = {};
+            double price = 0.0;
+            bool dirty = false;
+        };
+
+        DashboardServerConfig config_;
+        DashboardEventRing ring_;
+        net::socket_t listener_ = net::INVALID_SOCKET_VALUE;
+        uint16_t port_ = 0;
+        std::thread thread_;
+        std::atomic<bool> running_{false};
+
+        std::mutex price_mutex_;
+        std::array<VenuePrice, 16> prices_;
+        OhlcBar spread_; // Since the last poll cycle, also under price_mutex_
+
+        std::function<DashboardMetrics()> metrics_source_;
+
+        // Server thread only
+        std::vector<Client> clients_;
+        uint64_t cursor_ = 0;
+        std::vector<OpportunityRecord> pending_;
+        DashboardAggregator aggregator_;
+
+        // This cycle's frames, one buffer per kind of subscription
+        struct Broadcast
+        {
+            std::string common; // Prices and metrics: everyone
+            std::string events_all;
+            std::string events_sampled;
+            std::array<std::string, DashboardAggregator::RESOLUTIONS> bars;
+            size_t common_messages = 0;
+            size_t all_messages = 0;
+            size_t sampled_messages = 0;
+
+            void clear()
+            {
+                common.clear();
+                events_all.clear();
+                events_sampled.clear();
+                for (auto &b : bars)
+                    b.clear();
+                common_messages = all_messages = sampled_messages = 0;
+            }
+        };
+        Broadcast broadcast_;
+
+        std::atomic<uint64_t> sent_messages_{0};
+        std::atomic<uint64_t> sent_bytes_{0};
+        std::atomic<uint64_t> lost_{0};
+        std::atomic<uint64_t> clients_accepted_{0};
+        std::atomic<uint64_t> clients_dropped_{0};
+        std::atomic<size_t> clients_connected_{0};
+        std::atomic<uint64_t> bars_{0};
+
+        void append_message(std::string &out, const char *begin, const char *end)
+        {
+            websocket::append_frame(out, websocket::TEXT, begin, static_cast<size_t>(end - begin));
+        }
+
+        bool handshake(Client &client)
+        {
+            size_t header_end = client.in.find("\r\n\r\n");
+            if (header_end == std::string::npos)
+                return client.in.size() < 8192; // Keep waiting, unless it is not HTTP at all
+
+            // Header names are case-insensitive
+            std::string headers = client.in.substr(0, header_end);
+            std::string lower = headers;
+            std::transform(lower.begin(), lower.end(), lower.begin(), [](char c)
+                           { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+            size_t key_pos = lower.find("sec-websocket-key:");
+            if (key_pos == std::string::npos)
+            {
+                client.out = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                client.closing = true;
+                return true;
+            }
+            size_t value_begin = headers.find_first_not_of(' ', key_pos + 18);
+            size_t value_end = headers.find("\r\n", value_begin);
+            std::string key = headers.substr(value_begin, value_end == std::string::npos ? std::string::npos : value_end - value_begin);
+            while (!key.empty() && key.back() == ' ')
+                key.pop_back();
+
+            client.out = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                         "Sec-WebSocket-Accept: " +
+                         websocket::accept_key(key) + "\r\n\r\n";
+            client.in.erase(0, header_end + 4);
+            client.upgraded = true;
+
+            // Greeting and the latest price per venue so the page fills in immediately
+            static const char hello[] = "{\"type\":\"test\",\"message\":\"Connected to ArbiSim engine\"}";
+            append_message(client.out, hello, hello + sizeof(hello) - 1);
+            char buffer[256];
+            std::lock_guard<std::mutex> lock(price_mutex_);
+            for (const auto &venue : prices_)
+            {
+                if (venue.exchange[0] == '\0')
+                    break;
+                char *end = dashboard_json::price_update(venue.exchange, venue.price, buffer, buffer + sizeof(buffer));
+                append_message(client.out, buffer, end);
+            }
+            return true;
+        }
+
+        // Subscription request; anything unrecognised leaves the client as it was
+        void subscribe(Client &client, const std::string &message)
+        {
+            if (message.find("\"subscribe\"") == std::string::npos)
+                return;
+
+            size_t events = message.find("\"events\"");
+            if (events != std::string::npos)
+            {
+                size_t value = message.find('"', message.find(':', events));
+                if (value != std::string::npos)
+                {
+                    if (message.compare(value, 5, "\"all\"") == 0)
+                        client.events = DashboardEvents::ALL;
+                    else if (message.compare(value, 9, "\"sampled\"") == 0)
+                        client.events = DashboardEvents::SAMPLED;
+                    else if (message.compare(value, 6, "\"none\"") == 0)
+                        client.events = DashboardEvents::NONE;
+                }
+            }
+
+            size_t bars = message.find("\"bars\"");
+            if (bars != std::string::npos)
+            {
+                size_t open = message.find('[', bars);
+                size_t close = message.find(']', open);
+                if (open != std::string::npos && close != std::string::npos)
+                {
+                    client.bar_mask = 0;
+                    for (size_t q = message.find('"', open); q < close; q = message.find('"', q))
+                    {
+                        size_t name_end = message.find('"', q + 1);
+                        if (name_end == std::string::npos || name_end > close)
+                            break;
+                        int index = DashboardAggregator::resolution_index(message.data() + q + 1, name_end - q - 1);
+                        if (index >= 0)
+                            client.bar_mask |= 1u << index;
+                        q = name_end + 1;
+                    }
+                }
+            }
+
+            // Echo what is now in effect
+            static const char *modes[] = {"all", "sampled", "none"};
+            std::string ack = "{\"type\":\"subscribed\",\"events\":\"";
+            ack += modes[static_cast<int>(client.events)];
+            ack += "\",\"bars\":[";
+            for (size_t i = 0; i < DashboardAggregator::RESOLUTIONS; ++i)
+            {
+                if (!(client.bar_mask & (1u << i)))
+                    continue;
+                if (ack.back() != '[')
+                    ack += ',';
+                ack += '"';
+                ack += DashboardAggregator::resolutions[i].name;
+                ack += '"';
+            }
+            ack += "]}";
+            append_message(client.out, ack.data(), ack.data() + ack.size());
+        }
+
+        // Client frames are masked. Close and ping need an answer; text frames carry
+        // subscription requests.
+        void read_frames(Client &client)
+        {
+            while (client.in.size() >= 2)
+            {
+                const auto *p = reinterpret_cast<const uint8_t *>(client.in.data());
+                uint8_t opcode = p[0] & 0x0F;
+                bool masked = (p[1] & 0x80) != 0;
+                uint64_t len = p[1] & 0x7F;
+                size_t header = 2;
+                if (len == 126)
+                {
+                    if (client.in.size() < 4)
+                        return;
+                    len = (uint64_t(p[2]) << 8) | p[3];
+                    header = 4;
+                }
+                else if (len == 127)
+                {
+                    if (client.in.size() < 10)
+                        return;
+                    len = 0;
+                    for (int i = 0; i < 8; ++i)
+                        len = (len << 8) | p[2 + i];
+                    header = 10;
+                }
+                if (len > 65536)
+                {
+                    client.closing = true; // Nothing legitimate is that big
+                    return;
+                }
+                size_t mask_at = header;
+                if (masked)
+                    header += 4;
+                if (client.in.size() < header + len)
+                    return;
+
+                std::string payload = client.in.substr(header, len);
+                if (masked)
+                {
+                    for (size_t i = 0; i < payload.size(); ++i)
+                        payload[i] = static_cast<char>(payload[i] ^ p[mask_at + i % 4]);
+                }
+                client.in.erase(0, header + len);
+
+                if (opcode == websocket::CLOSE)
+                {
+                    websocket::append_frame(client.out, websocket::CLOSE, payload.data(), std::min<size_t>(payload.size(), 2));
+                    client.closing = true;
+                    return;
+                }
+                if (opcode == websocket::PING)
+                    websocket::append_frame(client.out, websocket::PONG, payload.data(), payload.size());
+                else if (opcode == websocket::TEXT)
+                    subscribe(client, payload);
+            }
+        }
+
+        // Returns false if the connection is gone
+        bool flush(Client &client)
+        {
+            while (client.out_offset < client.out.size())
+            {
+                long n = net::send_some(client.socket, client.out.data() + client.out_offset,
+                                        client.out.size() - client.out_offset);
+                if (n < 0)
+                    return false;
+                if (n == 0)
+                    break;
+                client.out_offset += static_cast<size_t>(n);
+                sent_bytes_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            }
+            if (client.out_offset == client.out.size())
+            {
+                client.out.clear();
+                client.out_offset = 0;
+                return !client.closing;
+            }
+            // Compact once the sent prefix dominates
+            if (client.out_offset > client.out.size() / 2)
+            {
+                client.out.erase(0, client.out_offset);
+                client.out_offset = 0;
+            }
+            return true;
+        }
+
+        void accept_clients()
+        {
+            while (true)
+            {
+                net::socket_t s = net::accept_client(listener_);
+                if (s == net::INVALID_SOCKET_VALUE)
+                    return;
+                if (clients_.size() >= config_.max_clients)
+                {
+                    net::close_socket(s);
+                    continue;
+                }
+                Client client;
+                client.socket = s;
+                clients_.push_back(std::move(client));
+                clients_accepted_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Encode everything new once per kind of subscription, then hand the same bytes
+        // to every client that asked for them
+        void collect_broadcast(uint64_t now_ns, uint64_t &next_price_ns, uint64_t &next_metrics_ns)
+        {
+            broadcast_.clear();
+            pending_.clear();
+            uint64_t lost = ring_.read(cursor_, pending_);
+            if (lost > 0)
+                lost_.fetch_add(lost, std::memory_order_relaxed);
+
+            // Only encode what somebody will receive
+            bool want_all = false, want_sampled = false;
+            unsigned want_bars = 0;
+            for (const auto &client : clients_)
+            {
+                if (!client.upgraded || client.closing)
+                    continue;
+                want_all |= client.events == DashboardEvents::ALL;
+                want_sampled |= client.events == DashboardEvents::SAMPLED;
+                want_bars |= client.bar_mask;
+            }
+
+            char buffer[4096];
+            for (const auto &record : pending_)
+            {
+                aggregator_.add_opportunity(record, now_ns);
+                if (!want_all)
+                    continue;
+                append_message(broadcast_.events_all, buffer, dashboard_json::opportunity(record, buffer, buffer + sizeof(buffer)));
+                broadcast_.all_messages++;
+            }
+
+            OhlcBar spread;
+            {
+                std::lock_guard<std::mutex> lock(price_mutex_);
+                spread = spread_;
+                spread_ = OhlcBar();
+            }
+            aggregator_.add_spread(spread, now_ns);
+
+            aggregator_.take_samples(now_ns, [&](const OpportunityRecord &record)
+                                     {
+                if (!want_sampled)
+                    return;
+                append_message(broadcast_.events_sampled, buffer, dashboard_json::opportunity(record, buffer, buffer + sizeof(buffer)));
+                broadcast_.sampled_messages++; });
+
+            aggregator_.advance(now_ns, [&](size_t resolution, const DashboardBar &bar)
+                                {
+                bars_.fetch_add(1, std::memory_order_relaxed);
+                if (!(want_bars & (1u << resolution)))
+                    return;
+                const char *name = DashboardAggregator::resolutions[resolution].name;
+                append_message(broadcast_.bars[resolution], buffer, dashboard_json::bar(name, bar, buffer, buffer + sizeof(buffer))); });
+
+            if (now_ns >= next_price_ns)
+            {
+                next_price_ns = now_ns + config_.price_interval_ms * 1000000ULL;
+                std::lock_guard<std::mutex> lock(price_mutex_);
+                for (auto &venue : prices_)
+                {
+                    if (venue.exchange[0] == '\0')
+                        break;
+                    if (!venue.dirty)
+                        continue;
+                    venue.dirty = false;
+                    append_message(broadcast_.common, buffer,
+                                   dashboard_json::price_update(venue.exchange, venue.price, buffer, buffer + sizeof(buffer)));
+                    broadcast_.common_messages++;
+                }
+            }
+
+            if (metrics_source_ && now_ns >= next_metrics_ns)
+            {
+                next_metrics_ns = now_ns + config_.metrics_interval_ms * 1000000ULL;
+                append_message(broadcast_.common, buffer, dashboard_json::metrics(metrics_source_(), buffer, buffer + sizeof(buffer)));
+                broadcast_.common_messages++;
+            }
+        }
+
+        // Append this cycle's frames to one client's buffer; false if that would put it
+        // over the backlog limit
+        bool deliver(Client &client)
+        {
+            const std::string *parts[2 + DashboardAggregator::RESOLUTIONS];
+            size_t count = 0;
+            size_t messages = broadcast_.common_messages;
+            parts[count++] = &broadcast_.common;
+            if (client.events == DashboardEvents::ALL)
+            {
+                parts[count++] = &broadcast_.events_all;
+                messages += broadcast_.all_messages;
+            }
+            else if (client.events == DashboardEvents::SAMPLED)
+            {
+                parts[count++] = &broadcast_.events_sampled;
+                messages += broadcast_.sampled_messages;
+            }
+            for (size_t i = 0; i < DashboardAggregator::RESOLUTIONS; ++i)
+            {
+                if ((client.bar_mask & (1u << i)) && !broadcast_.bars[i].empty())
+                {
+                    parts[count++] = &broadcast_.bars[i];
+                    messages++;
+                }
+            }
+
+            size_t bytes = 0;
+            for (size_t i = 0; i < count; ++i)
+                bytes += parts[i]->size();
+            if (bytes == 0)
+                return true;
+            if (client.out.size() - client.out_offset + bytes > config_.max_client_backlog)
+                return false;
+            for (size_t i = 0; i < count; ++i)
+                client.out += *parts[i];
+            sent_messages_.fetch_add(messages, std::memory_order_relaxed);
+            return true;
+        }
+
+        void serve()
+        {
+            std::vector<net::PollFd> fds;
+            std::vector<char> buffer(16384);
+            uint64_t next_price_ns = 0, next_metrics_ns = 0;
+
+            while (running_.load(std::memory_order_relaxed))
+            {
+                fds.clear();
+                net::PollFd listen_fd{};
+                listen_fd.fd = listener_;
+                listen_fd.events = POLLIN;
+                fds.push_back(listen_fd);
+                for (const auto &client : clients_)
+                {
+                    net::PollFd fd{};
+                    fd.fd = client.socket;
+                    fd.events = POLLIN;
+                    if (client.out_offset < client.out.size())
+                        fd.events |= POLLOUT;
+                    fds.push_back(fd);
+                }
+
+                net::poll_sockets(fds.data(), fds.size(), config_.poll_interval_ms);
+
+                if (fds[0].revents & POLLIN)
+                    accept_clients();
+
+                // Reads and handshakes (clients accepted just now are polled next cycle)
+                for (size_t i = 1; i < fds.size(); ++i)
+                {
+                    Client &client = clients_[i - 1];
+                    if (!(fds[i].revents & (POLLIN | POLLERR | POLLHUP)))
+                        continue;
+                    long n;
+                    while ((n = net::recv_some(client.socket, buffer.data(), buffer.size())) > 0)
+                        client.in.append(buffer.data(), static_cast<size_t>(n));
+                    if (n < 0)
+                        client.closing = true, client.out.clear(), client.out_offset = 0;
+                    else if (!client.upgraded && !handshake(client))
+                        client.closing = true;
+                    else if (client.upgraded)
+                        read_frames(client);
+                }
+
+                collect_broadcast(timestamp_ns(), next_price_ns, next_metrics_ns);
+
+                for (auto &client : clients_)
+                {
+                    if (!client.upgraded || client.closing || deliver(client))
+                        continue;
+                    client.closing = true;
+                    client.out.clear();
+                    client.out_offset = 0;
+                    clients_dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                // Send; drop connections that are gone or have finished closing
+                for (size_t i = 0; i < clients_.size();)
+                {
+                    if (!flush(clients_[i]))
+                    {
+                        net::close_socket(clients_[i].socket);
+                        clients_[i] = std::move(clients_.back());
+                        clients_.pop_back();
+                        continue;
+                    }
+                    ++i;
+                }
+                clients_connected_.store(clients_.size(), std::memory_order_relaxed);
+            }
+
+            // Say goodbye properly, best effort
+            for (auto &client : clients_)
+            {
+                if (client.upgraded)
+                {
+                    static const char going_away[] = {0x03, static_cast<char>(0xE9)}; // 1001
+                    websocket::append_frame(client.out, websocket::CLOSE, going_away, 2);
+                    flush(client);
+                }
+                net::close_socket(client.socket);
+            }
+            clients_.clear();
+            clients_connected_.store(0);
+        }
+
+    public:
+        DashboardServer() = default;
+        ~DashboardServer() { stop(); }
+
+        DashboardServer(const DashboardServer &) = delete;
+        DashboardServer &operator=(const DashboardServer &) = delete;
+
+        // Called on the server thread every metrics interval (set before start)
+        void set_metrics_source(std::function<DashboardMetrics()> source)
+        {
+            metrics_source_ = std::move(source);
+        }
+
+        // Bind and start serving; false if the port is taken (e.g. by test-server.js)
+        bool start(const DashboardServerConfig &config = DashboardServerConfig())
+        {
+            if (running_.load())
+                return false;
+            config_ = config;
+            ring_.reset(config_.ring_capacity);
+            cursor_ = 0;
+            aggregator_ = DashboardAggregator();
+            spread_ = OhlcBar();
+
+            if (!net::startup())
+                return false;
+            listener_ = net::listen_tcp(config_.host.c_str(), config_.port);
+            if (listener_ == net::INVALID_SOCKET_VALUE)
+            {
+                net::cleanup();
+                return false;
+            }
+            port_ = net::local_port(listener_);
+
+            running_.store(true);
+            thread_ = std::thread([this]()
+                                  { serve(); });
+            return true;
+        }
+
+        void stop()
+        {
+            if (!running_.exchange(false))
+                return;
+            if (thread_.joinable())
+                thread_.join();
+            net::close_socket(listener_);
+            listener_ = net::INVALID_SOCKET_VALUE;
+            net::cleanup();
+        }
+
+        bool running() const { return running_.load(); }
+        uint16_t port() const { return port_; }
+
+        // Hot path: copy into the ring; the server thread formats and sends
+        void publish(const OpportunityRecord &record)
+        {
+            if (running_.load(std::memory_order_relaxed))
+                ring_.push(record);
+        }
+
+        // Latest mid per venue; sent at most once per price interval
+        void publish_price(const std::string &exchange, double price)
+        {
+            if (!running_.load(std::memory_order_relaxed) || price <= 0.0)
+                return;
+            std::lock_guard<std::mutex> lock(price_mutex_);
+            for (auto &venue : prices_)
+            {
+                if (venue.exchange[0] == '\0')
+                    OpportunityRecord::copy_name(venue.exchange, exchange);
+                else if (exchange != venue.exchange)
+                    continue;
+                venue.price = price;
+                venue.dirty = true;
+                return;
+            }
+        }
+
+        // Best cross-venue spread in bps, folded into the bars' OHLC
+        void publish_spread(double spread_bps)
+        {
+            if (!running_.load(std::memory_order_relaxed))
+                return;
+            std::lock_guard<std::mutex> lock(price_mutex_);
+            spread_.add(spread_bps);
+        }
+
+        // Lock-free subset of get_stats(), for scrapes
+        uint64_t lost() const { return lost_.load(std::memory_order_relaxed); }
+
+        Stats get_stats() const
+        {
+            Stats stats;
+            stats.published = ring_.head();
+            stats.sent_messages = sent_messages_.load();
+            stats.sent_bytes = sent_bytes_.load();
+            stats.lost = lost_.load();
+            stats.clients_accepted = clients_accepted_.load();
+            stats.clients_dropped = clients_dropped_.load();
+            stats.clients_connected = clients_connected_.load();
+            stats.bars = bars_.load();
+            return stats;
+        }
+    };
+
+} // namespace arbisim
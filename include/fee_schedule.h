@@ -0,0 +1,106 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+namespace arbisim
+{
+
+    // One volume tier of an exchange fee table
+    struct FeeTier
+    {
+        double min_volume_30d = 0.0; // Trailing 30-day volume ($) needed for this tier
+        double maker_bps = 10.0;
+        double taker_bps = 10.0;
+    };
+
+    // Per-exchange maker/taker fee tables with volume tiers. The current tier of each
+    // exchange follows the 30-day volume we report for it.
+    class FeeSchedule
+    {
+    private:
+        std::unordered_map<std::string, std::vector<FeeTier>> tiers_;
+        std::unordered_map<std::string, double> volume_30d_;
+        FeeTier default_tier_; // Used for exchanges with no table: 0.1% per side
+
+    public:
+        void set_tiers(const std::string &exchange, std::vector<FeeTier> tiers)
+        {
+            std::sort(tiers.begin(), tiers.end(), [](const FeeTier &a, const FeeTier &b)
+                      { return a.min_volume_30d < b.min_volume_30d; });
+            tiers_[exchange] = std::move(tiers);
+        }
+
+        void set_default_tier(const FeeTier &tier) { default_tier_ = tier; }
+
+        void set_volume_30d(const std::string &exchange, double volume)
+        {
+            volume_30d_[exchange] = volume;
+        }
+
+        void set_volume_30d_all(double volume)
+        {
+            for (const auto &[exchange, tiers] : tiers_)
+            {
+                volume_30d_[exchange] = volume;
+            }
+        }
+
+        double volume_30d(const std::string &exchange) const
+        {
+            auto it = volume_30d_.find(exchange);
+            return it != volume_30d_.end() ? it->second : 0.0;
+        }
+
+        // Highest tier whose volume requirement we meet
+        const FeeTier &current_tier(const std::string &exchange) const
+        {
+            auto it = tiers_.find(exchange);
+            if (it == tiers_.end() || it->second.empty())
+            {
+                return default_tier_;
+            }
+
+            double volume = volume_30d(exchange);
+            const FeeTier *tier = &it->second.front();
+            for (const auto &candidate : it->second)
+            {
+                if (candidate.min_volume_30d <= volume)
+                    tier = &candidate;
+            }
+            return *tier;
+        }
+
+        double taker_bps(const std::string &exchange) const { return current_tier(exchange).taker_bps; }
+        double maker_bps(const std::string &exchange) const { return current_tier(exchange).maker_bps; }
+
+        // Published spot schedules (rounded) for the simulated venues
+        static FeeSchedule defaults()
+        {
+            FeeSchedule schedule;
+            schedule.set_tiers("binance", {{0.0, 10.0, 10.0},
+                                           {1000000.0, 9.0, 10.0},
+                                           {5000000.0, 8.0, 10.0},
+                                           {20000000.0, 4.2, 6.0}});
+            schedule.set_tiers("coinbase", {{0.0, 40.0, 60.0},
+                                            {10000.0, 25.0, 40.0},
+                                            {50000.0, 15.0, 25.0},
+                                            {100000.0, 10.0, 20.0},
+                                            {1000000.0, 8.0, 18.0},
+                                            {15000000.0, 6.0, 16.0}});
+            schedule.set_tiers("kraken", {{0.0, 25.0, 40.0},
+                                          {10000.0, 20.0, 35.0},
+                                          {50000.0, 14.0, 24.0},
+                                          {100000.0, 12.0, 22.0},
+                                          {250000.0, 10.0, 20.0},
+                                          {500000.0, 8.0, 18.0},
+                                          {1000000.0, 6.0, 16.0}});
+            schedule.set_tiers("bybit", {{0.0, 10.0, 10.0},
+                                         {1000000.0, 6.75, 8.0},
+                                         {2500000.0, 6.0, 7.75}});
+            return schedule;
+        }
+    };
+
+} // namespace arbisim
@@ -0,0 +1,223 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace arbisim
+{
+
+    // Log-linear bucket layout shared by the histograms below, in the style of
+    // HdrHistogram: values below 64 get their own bucket, every power of two above is
+    // split into 64 equal buckets, so any recorded value is known to within 1/64 (1.6%).
+    // Covers 0 to 2^34 ns (~17 s); anything longer lands in the top bucket.
+    namespace latency_buckets
+    {
+        static constexpr int SUB_BITS = 6;
+        static constexpr uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;
+        static constexpr int MAX_MSB = 33;
+        static constexpr size_t COUNT = static_cast<size_t>(MAX_MSB - SUB_BITS + 2) << SUB_BITS;
+
+        inline int msb(uint64_t v)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, v);
+            return static_cast<int>(index);
+#else
+            return 63 - __builtin_clzll(v);
+#endif
+        }
+
+        inline size_t index_of(uint64_t v)
+        {
+            if (v < SUB_COUNT)
+                return static_cast<size_t>(v);
+            int top = std::min(msb(v), MAX_MSB);
+            if (top == MAX_MSB && (v >> MAX_MSB) > 1)
+                return COUNT - 1;
+            int shift = top - SUB_BITS;
+            return (static_cast<size_t>(shift + 1) << SUB_BITS) + static_cast<size_t>((v >> shift) - SUB_COUNT);
+        }
+
+        inline uint64_t lowest_of(size_t index)
+        {
+            if (index < SUB_COUNT)
+                return index;
+            int shift = static_cast<int>(index >> SUB_BITS) - 1;
+            return (SUB_COUNT + (index & (SUB_COUNT - 1))) << shift;
+        }
+
+        // Largest value that maps to the same bucket
+        inline uint64_t highest_of(size_t index)
+        {
+            if (index < SUB_COUNT)
+                return index;
+            int shift = static_cast<int>(index >> SUB_BITS) - 1;
+            return lowest_of(index) + (uint64_t(1) << shift) - 1;
+        }
+    } // namespace latency_buckets
+
+    // Single-owner latency histogram (ns). Cheap to record into, merge and reset;
+    // percentiles report the highest value equivalent to the bucket they fall in,
+    // capped at the exact maximum.
+    class LatencyHistogram
+    {
+    private:
+        std::array<uint64_t, latency_buckets::COUNT> counts_{};
+        uint64_t total_ = 0;
+        uint64_t sum_ = 0;
+        uint64_t min_ = UINT64_MAX;
+        uint64_t max_ = 0;
+
+        friend class ConcurrentLatencyHistogram;
+
+    public:
+        void record(uint64_t value_ns)
+        {
+            counts_[latency_buckets::index_of(value_ns)]++;
+            total_++;
+            sum_ += value_ns;
+            min_ = std::min(min_, value_ns);
+            max_ = std::max(max_, value_ns);
+        }
+
+        void merge(const LatencyHistogram &other)
+        {
+            for (size_t i = 0; i < counts_.size(); ++i)
+                counts_[i] += other.counts_[i];
+            total_ += other.total_;
+            sum_ += other.sum_;
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+        }
+
+        void reset()
+        {
+            counts_.fill(0);
+            total_ = 0;
+            sum_ = 0;
+            min_ = UINT64_MAX;
+            max_ = 0;
+        }
+
+        uint64_t count() const { return total_; }
+        uint64_t min() const { return total_ > 0 ? min_ : 0; }
+        uint64_t max() const { return max_; }
+        uint64_t mean() const { return total_ > 0 ? sum_ / total_ : 0; }
+        uint64_t sum() const { return sum_; }
+
+        // Values recorded at or below value_ns, to bucket resolution: a bucket counts once
+        // everything it can hold is within the bound
+        uint64_t count_at_or_below(uint64_t value_ns) const
+        {
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts_.size() && latency_buckets::highest_of(i) <= value_ns; ++i)
+                seen += counts_[i];
+            return seen;
+        }
+
+        // q in [0, 1]
+        uint64_t percentile(double q) const
+        {
+            if (total_ == 0)
+                return 0;
+            uint64_t rank = std::min<uint64_t>(total_ - 1, static_cast<uint64_t>(q * total_));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts_.size(); ++i)
+            {
+                seen += counts_[i];
+                if (seen > rank)
+                    return std::min(latency_buckets::highest_of(i), max_);
+            }
+            return max_;
+        }
+
+        // Non-empty buckets as "lower_us upper_us count cumulative%", one per line
+        void print_buckets(std::ostream &out) const
+        {
+            out << std::setw(14) << "from_us" << std::setw(14) << "to_us" << std::setw(12) << "count"
+                << std::setw(10) << "cum%" << "\n";
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts_.size(); ++i)
+            {
+                if (counts_[i] == 0)
+                    continue;
+                seen += counts_[i];
+                out << std::fixed << std::setprecision(3)
+                    << std::setw(14) << latency_buckets::lowest_of(i) / 1000.0
+                    << std::setw(14) << latency_buckets::highest_of(i) / 1000.0
+                    << std::setw(12) << counts_[i]
+                    << std::setw(10) << std::setprecision(4) << (100.0 * seen / total_) << "\n";
+            }
+        }
+    };
+
+    // Same buckets with relaxed atomic counters, for recording from any thread while a
+    // reader takes snapshots. drain_into() moves the counts out, which gives per-interval
+    // views without stopping the writers: a racing record lands in this interval or the next.
+    class ConcurrentLatencyHistogram
+    {
+    private:
+        std::array<std::atomic<uint64_t>, latency_buckets::COUNT> counts_{};
+        std::atomic<uint64_t> sum_{0};
+        std::atomic<uint64_t> min_{UINT64_MAX};
+        std::atomic<uint64_t> max_{0};
+
+    public:
+        void record(uint64_t value_ns)
+        {
+            counts_[latency_buckets::index_of(value_ns)].fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value_ns, std::memory_order_relaxed);
+
+            // Only new extremes pay for a CAS
+            uint64_t current = min_.load(std::memory_order_relaxed);
+            while (value_ns < current && !min_.compare_exchange_weak(current, value_ns, std::memory_order_relaxed))
+            {
+            }
+            current = max_.load(std::memory_order_relaxed);
+            while (value_ns > current && !max_.compare_exchange_weak(current, value_ns, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        // Add the current counts to out, leaving them in place
+        void snapshot_into(LatencyHistogram &out) const
+        {
+            uint64_t total = 0;
+            for (size_t i = 0; i < counts_.size(); ++i)
+            {
+                uint64_t n = counts_[i].load(std::memory_order_relaxed);
+                out.counts_[i] += n;
+                total += n;
+            }
+            out.total_ += total;
+            out.sum_ += sum_.load(std::memory_order_relaxed);
+            out.min_ = std::min(out.min_, min_.load(std::memory_order_relaxed));
+            out.max_ = std::max(out.max_, max_.load(std::memory_order_relaxed));
+        }
+
+        // Move the counts to out and start a new interval
+        void drain_into(LatencyHistogram &out)
+        {
+            uint64_t total = 0;
+            for (size_t i = 0; i < counts_.size(); ++i)
+            {
+                uint64_t n = counts_[i].exchange(0, std::memory_order_relaxed);
+                out.counts_[i] += n;
+                total += n;
+            }
+            out.total_ += total;
+            out.sum_ += sum_.exchange(0, std::memory_order_relaxed);
+            out.min_ = std::min(out.min_, min_.exchange(UINT64_MAX, std::memory_order_relaxed));
+            out.max_ = std::max(out.max_, max_.exchange(0, std::memory_order_relaxed));
+        }
+    };
+
+} // namespace arbisim
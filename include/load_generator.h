@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "arbisim_core.h"
+#include "cache_line.h"
+#include "latency_histogram.h"
+
+namespace arbisim
+{
+
+    struct LoadTestConfig
+    {
+        double start_rate = 1000.0;                // Updates/s offered by the first step
+        double rate_factor = 2.0;                  // Each further step offers this much more
+        double max_rate = 10000000.0;              // Stop ramping past this rate
+        uint64_t step_ns = 2000000000ULL;          // How long each step sends for
+        uint64_t drain_timeout_ns = 5000000000ULL; // Wait this long for a step's backlog
+        uint64_t slo_p99_ns = 10000000ULL;         // A step whose p99 exceeds this is saturated...
+        double min_throughput = 0.95;              // ...as is one completing under this share of the offered rate
+    };
+
+    // One rate step. Latencies are from each update's intended send time, so a stall
+    // anywhere (the engine, or the generator falling behind) counts against every update
+    // that should have gone out during it.
+    struct LoadStepResult
+    {
+        double offered_rate = 0.0; // Schedule
+        double send_rate = 0.0;    // What the generator managed
+        double throughput = 0.0;   // Completions per second over the step
+        uint64_t sent = 0;
+        uint64_t completed = 0;
+        bool drained = false; // Every update completed within the drain timeout
+        bool saturated = false;
+        LatencyHistogram latency;     // Intended send to detection done
+        LatencyHistogram opportunity; // Intended send of the triggering update to logged
+        LatencyHistogram send_lag;    // Intended to actual send
+        uint64_t opportunities_dropped = 0;
+    };
+
+    // Open-loop load: the i-th update of a step is due at step start + i / rate and is
+    // stamped with that due time whether or not the generator or the engine keep up, so
+    // a slow consumer cannot slow the schedule down and hide its own queueing (no
+    // coordinated omission). Updates come from a source vector (synthetic or a replayed
+    // capture) cycled in order. Steps ramp the rate geometrically, each waiting for its
+    // backlog to drain, until one saturates. The system under test reports completions
+    // through record_update()/record_opportunity()/record_dropped() from any thread.
+    class OpenLoopLoadGenerator
+    {
+    private:
+        std::vector<MarketUpdate> source_;
+        std::function<void(const MarketUpdate &)> sink_;
+
+        uint64_t next_sequence_ = 0; // Generator thread
+
+        // Written per update by the engine's market thread...
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> completed_{0};
+        std::atomic<uint64_t> last_done_ns_{0};
+        ConcurrentLatencyHistogram latency_;
+
+        // ...and per opportunity by the risk thread, on lines of its own
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> dropped_{0};
+        ConcurrentLatencyHistogram opportunity_;
+
+        static uint64_t elapsed_ns(uint64_t from, uint64_t to) { return to > from ? to - from : 0; }
+
+        // Sleep until due; short gaps are yielded away rather than spun, so the engine
+        // threads keep the core on small machines
+        static void wait_until(uint64_t due_ns)
+        {
+            uint64_t now = timestamp_ns();
+            if (due_ns > now + 100000)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(due_ns - now - 50000));
+            while (timestamp_ns() < due_ns)
+                std::this_thread::yield();
+        }
+
+        LoadStepResult run_step(double rate, const LoadTestConfig &config, const std::function<bool()> &cancelled)
+        {
+            LoadStepResult step;
+            step.offered_rate = rate;
+            completed_.store(0);
+            last_done_ns_.store(0);
+            dropped_.store(0);
+            LatencyHistogram discard;
+            latency_.drain_into(discard);
+            opportunity_.drain_into(discard);
+
+            uint64_t count = std::max<uint64_t>(1, static_cast<uint64_t>(rate * config.step_ns / 1e9));
+            double interval_ns = 1e9 / rate;
+            uint64_t start = timestamp_ns() + 1000000; // Scheduled from a moment ahead, not from now
+            uint64_t last_sent = start;
+            for (uint64_t i = 0; i < count && !cancelled(); ++i)
+            {
+                uint64_t due = start + static_cast<uint64_t>(i * interval_ns);
+                wait_until(due);
+
+                MarketUpdate update = source_[next_sequence_ % source_.size()];
+                update.sequence_id = next_sequence_++;
+                update.timestamp_ns = due;
+                sink_(update);
+                last_sent = timestamp_ns();
+                step.send_lag.record(elapsed_ns(due, last_sent));
+                step.sent++;
+            }
+            step.send_rate = step.sent / std::max(1e-9, elapsed_ns(start, last_sent) / 1e9);
+
+            // Wait for the backlog; what is still queued at the timeout makes the step saturated
+            uint64_t deadline = timestamp_ns() + config.drain_timeout_ns;
+            while (completed_.load() < step.sent && timestamp_ns() < deadline && !cancelled())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            step.completed = completed_.load();
+            step.drained = step.completed >= step.sent;
+            step.throughput = step.completed / std::max(1e-9, elapsed_ns(start, last_done_ns_.load()) / 1e9);
+            latency_.drain_into(step.latency);
+            opportunity_.drain_into(step.opportunity);
+            step.opportunities_dropped = dropped_.load();
+            step.saturated = !step.drained || step.throughput < config.min_throughput * rate ||
+                             step.latency.percentile(0.99) > config.slo_p99_ns;
+            return step;
+        }
+
+    public:
+        // sink receives each update on the generator's thread (the caller of run())
+        OpenLoopLoadGenerator(std::vector<MarketUpdate> source, std::function<void(const MarketUpdate &)> sink)
+            : source_(std::move(source)), sink_(std::move(sink)) {}
+
+        // An update stamped intended_ns finished at done_ns
+        void record_update(uint64_t intended_ns, uint64_t done_ns)
+        {
+            latency_.record(elapsed_ns(intended_ns, done_ns));
+            uint64_t last = last_done_ns_.load(std::memory_order_relaxed);
+            while (done_ns > last && !last_done_ns_.compare_exchange_weak(last, done_ns, std::memory_order_relaxed))
+            {
+            }
+            completed_.fetch_add(1, std::memory_order_release);
+        }
+
+        // An opportunity reached the log; intended_ns is its triggering update's stamp
+        void record_opportunity(uint64_t intended_ns, uint64_t logged_ns)
+        {
+            opportunity_.record(elapsed_ns(intended_ns, logged_ns));
+        }
+
+        // Opportunities the engine dropped (expired or evicted) instead of logging
+        void record_dropped(uint64_t n)
+        {
+            dropped_.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        // Ramp until a step saturates, the next step would pass max_rate, or cancelled()
+        std::vector<LoadStepResult> run(const LoadTestConfig &config, const std::function<bool()> &cancelled,
+                                        const std::function<void(const LoadStepResult &)> &on_step = nullptr)
+        {
+            std::vector<LoadStepResult> steps;
+            if (source_.empty() || !sink_ || config.start_rate <= 0.0)
+                return steps;
+
+            for (double rate = config.start_rate; rate <= config.max_rate && !cancelled();
+                 rate *= std::max(1.01, config.rate_factor))
+            {
+                steps.push_back(run_step(rate, config, cancelled));
+                if (on_step)
+                    on_step(steps.back());
+                if (steps.back().saturated)
+                    break;
+            }
+            return steps;
+        }
+
+        static void print_header(std::ostream &out)
+        {
+            out << std::setw(10) << "offered/s" << std::setw(11) << "sent/s" << std::setw(11) << "done/s"
+                << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(11) << "p99.9 us"
+                << std::setw(11) << "max us" << std::setw(10) << "lag p99" << std::setw(11) << "opp p99" << std::setw(8) << "opps"
+                << std::setw(9) << "dropped" << "  state" << std::endl;
+        }
+
+        static void print_step(std::ostream &out, const LoadStepResult &s)
+        {
+            auto us = [](uint64_t ns)
+            { return ns / 1000.0; };
+            out << std::fixed << std::setprecision(0) << std::setw(10) << s.offered_rate << std::setw(11) << s.send_rate
+                << std::setw(11) << s.throughput << std::setprecision(1) << std::setw(10) << us(s.latency.percentile(0.50))
+                << std::setw(10) << us(s.latency.percentile(0.99)) << std::setw(11) << us(s.latency.percentile(0.999))
+                << std::setw(11) << us(s.latency.max()) << std::setw(10) << us(s.send_lag.percentile(0.99))
+                << std::setw(11) << us(s.opportunity.percentile(0.99))
+                << std::setw(8) << s.opportunity.count() << std::setw(9) << s.opportunities_dropped << "  "
+                << (s.saturated ? (s.drained ? "SATURATED" : "SATURATED (backlog)") : "ok") << std::endl;
+        }
+
+        // Throughput vs latency curve, one row per step
+        static bool write_csv(const std::string &path, const std::vector<LoadStepResult> &steps)
+        {
+            std::ofstream out(path);
+            if (!out.is_open())
+                return false;
+            out << "offered_rate,send_rate,throughput,sent,completed,p50_us,p90_us,p99_us,p999_us,max_us,"
+                   "opportunities,opportunity_p50_us,opportunity_p99_us,opportunities_dropped,send_lag_p99_us,saturated\n";
+            out << std::fixed << std::setprecision(1);
+            for (const auto &s : steps)
+            {
+                out << s.offered_rate << "," << s.send_rate << "," << s.throughput << "," << s.sent << ","
+                    << s.completed << "," << s.latency.percentile(0.50) / 1000.0 << ","
+                    << s.latency.percentile(0.90) / 1000.0 << "," << s.latency.percentile(0.99) / 1000.0 << ","
+                    << s.latency.percentile(0.999) / 1000.0 << "," << s.latency.max() / 1000.0 << ","
+                    << s.opportunity.count() << "," << s.opportunity.percentile(0.50) / 1000.0 << ","
+                    << s.opportunity.percentile(0.99) / 1000.0 << "," << s.opportunities_dropped << ","
+                    << s.send_lag.percentile(0.99) / 1000.0 << "," << (s.saturated ? 1 : 0) << "\n";
+            }
+            return static_cast<bool>(out);
+        }
+    };
+
+} // namespace arbisim
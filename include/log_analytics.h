@@ -0,0 +1,677 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "columnar_log.h"
+#include "thread_pool.h"
+
+namespace arbisim
+{
+
+    // Post-session analytics over opportunity and trade logs. Logs are loaded into
+    // column vectors (one per field, venue pairs interned to ids), blocks or CSV chunks
+    // decoded in parallel. Queries are branch-free passes over those columns: one to
+    // compute a dense group id per row, one per chunk to accumulate sums, then a
+    // partition by group for the percentiles.
+    namespace analytics
+    {
+        enum GroupBy : unsigned
+        {
+            BY_PAIR = 1,
+            BY_HOUR = 2,
+            BY_DECISION = 4
+        };
+
+        static constexpr size_t HOURS = 24;
+        static constexpr size_t DECISIONS = 12; // Stored as decision + 1: -1 (CLOSE) .. 10
+        static constexpr uint64_t NS_PER_HOUR = 3600ULL * 1000000000ULL;
+
+        // Hour of day (UTC) for wall-clock timestamps
+        inline uint8_t hour_of(uint64_t ts_ns)
+        {
+            return static_cast<uint8_t>((ts_ns / NS_PER_HOUR) % HOURS);
+        }
+
+        inline const char *decision_label(int decision)
+        {
+            static const char *labels[] = {"close", "approved", "position", "exposure", "trade_size",
+                                           "min_profit", "daily_loss", "drawdown", "exchange_limit",
+                                           "batch_budget", "liquidity"};
+            if (decision < -1 || decision > 9)
+                return "other";
+            return labels[decision + 1];
+        }
+
+        // "BTCUSDT binance>kraken"
+        template <typename Record>
+        void pair_key(const Record &r, std::string &key)
+        {
+            key.assign(r.symbol);
+            key += ' ';
+            key += r.buy_exchange;
+            key += '>';
+            key += r.sell_exchange;
+        }
+
+        class Interner
+        {
+        private:
+            std::unordered_map<std::string, uint32_t> ids_;
+
+        public:
+            std::vector<std::string> names;
+
+            uint32_t id(const std::string &name)
+            {
+                auto it = ids_.find(name);
+                if (it != ids_.end())
+                    return it->second;
+                uint32_t id = static_cast<uint32_t>(names.size());
+                ids_.emplace(name, id);
+                names.push_back(name);
+                return id;
+            }
+        };
+
+        // Rows of each group laid out contiguously: rows[offsets[g] .. offsets[g + 1])
+        struct GroupPartition
+        {
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> rows;
+        };
+
+        // Dense group ids for pair x hour x decision (dimensions not grouped on collapse
+        // to 1). Rows with keep[i] == 0 get id `groups`, which every query ignores.
+        struct GroupKeys
+        {
+            std::vector<uint32_t> key;
+            size_t pairs = 1;
+            size_t hours = 1;
+            size_t decisions = 1;
+            size_t groups = 1;
+
+            int pair_of(size_t g) const { return pairs > 1 ? static_cast<int>(g / (hours * decisions)) : -1; }
+            int hour_of(size_t g) const { return hours > 1 ? static_cast<int>(g / decisions % hours) : -1; }
+            int decision_of(size_t g) const { return decisions > 1 ? static_cast<int>(g % decisions) - 1 : -2; }
+        };
+
+        // decision may be null (trade logs); keep may be null (all rows)
+        inline GroupKeys make_group_keys(const std::vector<uint32_t> &pair, const std::vector<uint8_t> &hour,
+                                         const int8_t *decision, const uint8_t *keep,
+                                         size_t pair_count, unsigned group_by)
+        {
+            GroupKeys keys;
+            size_t n = pair.size();
+            keys.pairs = (group_by & BY_PAIR) ? std::max<size_t>(1, pair_count) : 1;
+            keys.hours = (group_by & BY_HOUR) ? HOURS : 1;
+            keys.decisions = (group_by & BY_DECISION) && decision ? DECISIONS : 1;
+            keys.groups = keys.pairs * keys.hours * keys.decisions;
+            keys.key.resize(n);
+
+            // Multipliers of 0 drop a dimension without a branch in the loop
+            const uint32_t pair_mul = (group_by & BY_PAIR) ? static_cast<uint32_t>(keys.hours * keys.decisions) : 0;
+            const uint32_t hour_mul = (group_by & BY_HOUR) ? static_cast<uint32_t>(keys.decisions) : 0;
+            const uint32_t dead = static_cast<uint32_t>(keys.groups);
+            const uint32_t *p = pair.data();
+            const uint8_t *h = hour.data();
+            uint32_t *k = keys.key.data();
+
+            for (size_t i = 0; i < n; ++i)
+                k[i] = p[i] * pair_mul + h[i] * hour_mul;
+
+            if (keys.decisions > 1)
+            {
+                for (size_t i = 0; i < n; ++i)
+                    k[i] += static_cast<uint32_t>(std::min(std::max(decision[i] + 1, 0), static_cast<int>(DECISIONS) - 1));
+            }
+            if (keep)
+            {
+                for (size_t i = 0; i < n; ++i)
+                    k[i] = keep[i] ? k[i] : dead;
+            }
+            return keys;
+        }
+
+        // Counting sort of row indices by group id
+        inline GroupPartition partition_by_group(const GroupKeys &keys, const std::vector<uint64_t> &counts)
+        {
+            GroupPartition part;
+            part.offsets.assign(keys.groups + 1, 0);
+            for (size_t g = 0; g < keys.groups; ++g)
+                part.offsets[g + 1] = part.offsets[g] + static_cast<uint32_t>(counts[g]);
+
+            part.rows.resize(part.offsets[keys.groups]);
+            std::vector<uint32_t> cursor(part.offsets.begin(), part.offsets.end() - 1);
+            for (size_t i = 0; i < keys.key.size(); ++i)
+            {
+                uint32_t g = keys.key[i];
+                if (g < keys.groups)
+                    part.rows[cursor[g]++] = static_cast<uint32_t>(i);
+            }
+            return part;
+        }
+
+        // Percentiles q (ascending, in [0, 1]) of column over group g, written to out
+        template <typename T>
+        void group_percentiles(const std::vector<T> &column, const GroupPartition &part, size_t g,
+                               std::initializer_list<double> qs, T *out, std::vector<T> &scratch)
+        {
+            size_t begin = part.offsets[g], end = part.offsets[g + 1];
+            scratch.resize(end - begin);
+            for (size_t i = begin; i < end; ++i)
+                scratch[i - begin] = column[part.rows[i]];
+            if (scratch.empty())
+            {
+                for (size_t j = 0; j < qs.size(); ++j)
+                    out[j] = T{};
+                return;
+            }
+
+            // Successive nth_element calls only search the range above the previous rank
+            auto lo = scratch.begin();
+            for (double q : qs)
+            {
+                size_t rank = std::min(scratch.size() - 1, static_cast<size_t>(q * scratch.size()));
+                auto nth = scratch.begin() + rank;
+                if (nth >= lo)
+                {
+                    std::nth_element(lo, nth, scratch.end());
+                    lo = nth;
+                }
+                *out++ = *nth;
+            }
+        }
+
+        // Split [0, rows) into about 4 chunks per thread, at least min_chunk rows each
+        inline size_t chunk_rows(size_t rows, const WorkStealingPool &pool, size_t min_chunk = 16384)
+        {
+            return std::max(min_chunk, rows / (pool.thread_count() * 4) + 1);
+        }
+
+        // Load every block of an .arbcol file in [from_ns, to_ns] into table, decoding
+        // blocks in parallel. Returns false if the file is not a log of this schema.
+        template <typename Columns, typename Table>
+        bool load_columnar(const std::string &path, WorkStealingPool &pool, Table &table,
+                           uint64_t from_ns, uint64_t to_ns, bool &damaged)
+        {
+            ColumnarLogReader<Columns> reader;
+            if (!reader.open(path))
+                return false;
+
+            // Reading is sequential; decoding and projection are not
+            std::vector<std::string> bodies;
+            std::vector<uint32_t> block_rows;
+            const char *body;
+            size_t body_bytes;
+            typename ColumnarLogReader<Columns>::BlockInfo info;
+            while (reader.next_raw_block(body, body_bytes, info))
+            {
+                if (info.last_ts < from_ns || info.first_ts > to_ns)
+                    continue;
+                bodies.emplace_back(body, body_bytes);
+                block_rows.push_back(info.rows);
+            }
+            damaged = reader.corrupt();
+
+            std::vector<Table> parts(bodies.size());
+            std::vector<uint8_t> ok(bodies.size(), 1);
+            pool.parallel_for(bodies.size(), 1, [&](size_t begin, size_t end)
+                              {
+                std::vector<typename Columns::Record> records;
+                for (size_t b = begin; b < end; ++b) {
+                    records.assign(block_rows[b], typename Columns::Record{});
+                    columnar::BlockDecoder decoder(bodies[b].data(), bodies[b].size());
+                    if (!Columns::decode(decoder, records)) {
+                        ok[b] = 0;
+                        continue;
+                    }
+                    parts[b].add_rows(records.data(), records.size(), from_ns, to_ns);
+                } });
+
+            for (size_t b = 0; b < parts.size(); ++b)
+            {
+                if (!ok[b])
+                {
+                    damaged = true;
+                    break;
+                }
+                table.append(parts[b]);
+            }
+            return true;
+        }
+
+        // Field parsers for the engine's CSV; each advances p past the field and its separator
+        inline bool csv_u64(const char *&p, const char *end, uint64_t &v)
+        {
+            auto r = std::from_chars(p, end, v);
+            p = r.ptr + 1;
+            return r.ec == std::errc();
+        }
+
+        inline bool csv_int(const char *&p, const char *end, int &v)
+        {
+            auto r = std::from_chars(p, end, v);
+            p = r.ptr + 1;
+            return r.ec == std::errc();
+        }
+
+        inline bool csv_double(const char *&p, const char *end, double &v)
+        {
+            auto r = std::from_chars(p, end, v);
+            p = r.ptr + 1;
+            return r.ec == std::errc();
+        }
+
+        inline bool csv_name(const char *&p, const char *end, char (&dst)[16])
+        {
+            const char *comma = static_cast<const char *>(std::memchr(p, ',', end - p));
+            if (!comma)
+                return false;
+            columnar::copy_name(dst, p, static_cast<size_t>(comma - p));
+            p = comma + 1;
+            return true;
+        }
+
+        // One arbitrage_opportunities.csv row (without the newline)
+        inline bool parse_opportunity_csv(const char *p, const char *end, OpportunityRecord &r)
+        {
+            int decision = 0, event = 0;
+            bool ok = csv_u64(p, end, r.detected_at_ns) &&
+                      csv_name(p, end, r.symbol) &&
+                      csv_name(p, end, r.buy_exchange) &&
+                      csv_name(p, end, r.sell_exchange) &&
+                      csv_double(p, end, r.buy_price) &&
+                      csv_double(p, end, r.sell_price) &&
+                      csv_double(p, end, r.profit_bps) &&
+                      csv_double(p, end, r.net_profit_bps) &&
+                      csv_u64(p, end, r.latency_ns) &&
+                      csv_int(p, end, decision);
+            r.decision = static_cast<int8_t>(decision);
+            // Event and duration were added later; older logs stop after the decision
+            r.event = 0;
+            r.duration_ns = 0;
+            if (ok && p < end && csv_int(p, end, event))
+            {
+                r.event = static_cast<uint8_t>(event);
+                if (p < end)
+                    csv_u64(p, end, r.duration_ns);
+            }
+            return ok;
+        }
+
+        // Load an opportunity CSV, parsing newline-aligned chunks of the file in parallel.
+        // Rows that do not parse are counted in bad_rows and skipped.
+        template <typename Table>
+        bool load_opportunity_csv(const std::string &path, WorkStealingPool &pool, Table &table,
+                                  uint64_t from_ns, uint64_t to_ns, uint64_t &bad_rows)
+        {
+            std::FILE *file = std::fopen(path.c_str(), "rb");
+            if (!file)
+                return false;
+            std::string data;
+            char buffer[1 << 16];
+            size_t got;
+            while ((got = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+                data.append(buffer, got);
+            std::fclose(file);
+
+            // Skip the header line
+            size_t start = data.find('\n');
+            start = start == std::string::npos ? data.size() : start + 1;
+
+            const size_t chunk_bytes = 1 << 20;
+            std::vector<size_t> bounds{start};
+            while (bounds.back() < data.size())
+            {
+                size_t next = std::min(data.size(), bounds.back() + chunk_bytes);
+                next = data.find('\n', next);
+                bounds.push_back(next == std::string::npos ? data.size() : next + 1);
+            }
+
+            size_t chunks = bounds.size() - 1;
+            std::vector<Table> parts(chunks);
+            std::vector<uint64_t> bad(chunks, 0);
+            pool.parallel_for(chunks, 1, [&](size_t begin, size_t end)
+                              {
+                std::vector<OpportunityRecord> records;
+                for (size_t c = begin; c < end; ++c) {
+                    records.clear();
+                    const char *p = data.data() + bounds[c];
+                    const char *chunk_end = data.data() + bounds[c + 1];
+                    while (p < chunk_end) {
+                        const char *eol = static_cast<const char *>(std::memchr(p, '\n', chunk_end - p));
+                        if (!eol)
+                            eol = chunk_end;
+                        const char *line_end = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+                        OpportunityRecord r;
+                        if (line_end > p) {
+                            if (parse_opportunity_csv(p, line_end, r))
+                                records.push_back(r);
+                            else
+                                bad[c]++;
+                        }
+                        p = eol + 1;
+                    }
+                    parts[c].add_rows(records.data(), records.size(), from_ns, to_ns);
+                } });
+
+            bad_rows = 0;
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                table.append(parts[c]);
+                bad_rows += bad[c];
+            }
+            return true;
+        }
+    } // namespace analytics
+
+    // Opportunity log as columns
+    struct OpportunityTable
+    {
+        std::vector<uint64_t> timestamp_ns;
+        std::vector<uint64_t> latency_ns;
+        std::vector<double> profit_bps;
+        std::vector<double> net_profit_bps;
+        std::vector<int8_t> decision;
+        std::vector<uint8_t> event;
+        std::vector<uint8_t> hour;
+        std::vector<uint32_t> pair;
+        analytics::Interner pairs;
+
+        size_t size() const { return timestamp_ns.size(); }
+
+        void add_rows(const OpportunityRecord *records, size_t count, uint64_t from_ns, uint64_t to_ns)
+        {
+            std::string key;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const OpportunityRecord &r = records[i];
+                if (r.detected_at_ns < from_ns || r.detected_at_ns > to_ns)
+                    continue;
+                analytics::pair_key(r, key);
+                timestamp_ns.push_back(r.detected_at_ns);
+                latency_ns.push_back(r.latency_ns);
+                profit_bps.push_back(r.profit_bps);
+                net_profit_bps.push_back(r.net_profit_bps);
+                decision.push_back(r.decision);
+                event.push_back(r.event);
+                hour.push_back(analytics::hour_of(r.detected_at_ns));
+                pair.push_back(pairs.id(key));
+            }
+        }
+
+        void append(const OpportunityTable &part)
+        {
+            std::vector<uint32_t> remap;
+            for (const auto &name : part.pairs.names)
+                remap.push_back(pairs.id(name));
+
+            timestamp_ns.insert(timestamp_ns.end(), part.timestamp_ns.begin(), part.timestamp_ns.end());
+            latency_ns.insert(latency_ns.end(), part.latency_ns.begin(), part.latency_ns.end());
+            profit_bps.insert(profit_bps.end(), part.profit_bps.begin(), part.profit_bps.end());
+            net_profit_bps.insert(net_profit_bps.end(), part.net_profit_bps.begin(), part.net_profit_bps.end());
+            decision.insert(decision.end(), part.decision.begin(), part.decision.end());
+            event.insert(event.end(), part.event.begin(), part.event.end());
+            hour.insert(hour.end(), part.hour.begin(), part.hour.end());
+            for (uint32_t id : part.pair)
+                pair.push_back(remap[id]);
+        }
+    };
+
+    // Trade log as columns
+    struct TradeTable
+    {
+        std::vector<uint64_t> timestamp_ns;
+        std::vector<double> quantity;
+        std::vector<double> fees;
+        std::vector<double> net_pnl;
+        std::vector<uint8_t> hour;
+        std::vector<uint32_t> pair;
+        analytics::Interner pairs;
+
+        size_t size() const { return timestamp_ns.size(); }
+
+        void add_rows(const TradeRecord *records, size_t count, uint64_t from_ns, uint64_t to_ns)
+        {
+            std::string key;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const TradeRecord &r = records[i];
+                if (r.timestamp_ns < from_ns || r.timestamp_ns > to_ns)
+                    continue;
+                analytics::pair_key(r, key);
+                timestamp_ns.push_back(r.timestamp_ns);
+                quantity.push_back(r.quantity);
+                fees.push_back(r.fees);
+                net_pnl.push_back(r.net_pnl);
+                hour.push_back(analytics::hour_of(r.timestamp_ns));
+                pair.push_back(pairs.id(key));
+            }
+        }
+
+        void append(const TradeTable &part)
+        {
+            std::vector<uint32_t> remap;
+            for (const auto &name : part.pairs.names)
+                remap.push_back(pairs.id(name));
+
+            timestamp_ns.insert(timestamp_ns.end(), part.timestamp_ns.begin(), part.timestamp_ns.end());
+            quantity.insert(quantity.end(), part.quantity.begin(), part.quantity.end());
+            fees.insert(fees.end(), part.fees.begin(), part.fees.end());
+            net_pnl.insert(net_pnl.end(), part.net_pnl.begin(), part.net_pnl.end());
+            hour.insert(hour.end(), part.hour.begin(), part.hour.end());
+            for (uint32_t id : part.pair)
+                pair.push_back(remap[id]);
+        }
+    };
+
+    struct OpportunityGroupStats
+    {
+        int pair = -1;      // Index into OpportunityTable::pairs.names, -1 if not grouped
+        int hour = -1;      // -1 if not grouped
+        int decision = -2;  // -2 if not grouped
+        uint64_t count = 0;
+        double mean_profit_bps = 0.0;
+        double p99_profit_bps = 0.0;
+        double mean_net_profit_bps = 0.0;
+        double approval_rate = 0.0; // Approved / risk-assessed (CLOSE rows are not assessed)
+        uint64_t p50_latency_ns = 0;
+        uint64_t p99_latency_ns = 0;
+    };
+
+    struct TradeGroupStats
+    {
+        int pair = -1;
+        int hour = -1;
+        uint64_t count = 0;
+        double quantity = 0.0;
+        double fees = 0.0;
+        double total_pnl = 0.0;
+        double mean_pnl = 0.0;
+        double p01_pnl = 0.0; // Worst 1% of fills
+        double win_rate = 0.0;
+    };
+
+    // Group-by aggregates over an opportunity table. event_mask selects OpportunityEvent
+    // values (bit 0 OPEN, 1 UPDATE, 2 CLOSE). Empty groups are omitted.
+    inline std::vector<OpportunityGroupStats> aggregate_opportunities(const OpportunityTable &table, WorkStealingPool &pool,
+                                                                      unsigned group_by, unsigned event_mask = 0x3)
+    {
+        const size_t n = table.size();
+        std::vector<uint8_t> keep(n);
+        const uint8_t *ev = table.event.data();
+        for (size_t i = 0; i < n; ++i)
+            keep[i] = static_cast<uint8_t>((event_mask >> (ev[i] & 7)) & 1);
+
+        analytics::GroupKeys keys = analytics::make_group_keys(table.pair, table.hour, table.decision.data(),
+                                                               keep.data(), table.pairs.names.size(), group_by);
+        const size_t groups = keys.groups;
+
+        // Per-chunk sums, merged afterwards
+        struct Sums
+        {
+            std::vector<uint64_t> count, approved, assessed;
+            std::vector<double> profit, net;
+        };
+        size_t chunk = analytics::chunk_rows(n, pool);
+        size_t chunks = (n + chunk - 1) / chunk;
+        std::vector<Sums> partial(chunks);
+
+        pool.parallel_for(n, chunk, [&](size_t begin, size_t end)
+                          {
+            Sums &s = partial[begin / chunk];
+            // One spare slot absorbs filtered-out rows so the loop needs no branch
+            s.count.assign(groups + 1, 0);
+            s.approved.assign(groups + 1, 0);
+            s.assessed.assign(groups + 1, 0);
+            s.profit.assign(groups + 1, 0.0);
+            s.net.assign(groups + 1, 0.0);
+            const uint32_t *k = keys.key.data();
+            const int8_t *d = table.decision.data();
+            const double *pb = table.profit_bps.data();
+            const double *nb = table.net_profit_bps.data();
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t g = k[i];
+                s.count[g]++;
+                s.approved[g] += d[i] == 0;
+                s.assessed[g] += d[i] >= 0;
+                s.profit[g] += pb[i];
+                s.net[g] += nb[i];
+            } });
+
+        Sums total;
+        total.count.assign(groups, 0);
+        total.approved.assign(groups, 0);
+        total.assessed.assign(groups, 0);
+        total.profit.assign(groups, 0.0);
+        total.net.assign(groups, 0.0);
+        for (const auto &s : partial)
+        {
+            for (size_t g = 0; g < groups; ++g)
+            {
+                total.count[g] += s.count[g];
+                total.approved[g] += s.approved[g];
+                total.assessed[g] += s.assessed[g];
+                total.profit[g] += s.profit[g];
+                total.net[g] += s.net[g];
+            }
+        }
+
+        std::vector<uint32_t> live;
+        for (size_t g = 0; g < groups; ++g)
+            if (total.count[g] > 0)
+                live.push_back(static_cast<uint32_t>(g));
+
+        analytics::GroupPartition part = analytics::partition_by_group(keys, total.count);
+        std::vector<OpportunityGroupStats> result(live.size());
+
+        pool.parallel_for(live.size(), 1, [&](size_t begin, size_t end)
+                          {
+            std::vector<double> profit_scratch;
+            std::vector<uint64_t> latency_scratch;
+            for (size_t j = begin; j < end; ++j) {
+                size_t g = live[j];
+                OpportunityGroupStats &r = result[j];
+                r.pair = keys.pair_of(g);
+                r.hour = keys.hour_of(g);
+                r.decision = keys.decision_of(g);
+                r.count = total.count[g];
+                r.mean_profit_bps = total.profit[g] / r.count;
+                r.mean_net_profit_bps = total.net[g] / r.count;
+                r.approval_rate = total.assessed[g] ? static_cast<double>(total.approved[g]) / total.assessed[g] : 0.0;
+                analytics::group_percentiles(table.profit_bps, part, g, {0.99}, &r.p99_profit_bps, profit_scratch);
+                uint64_t latency[2];
+                analytics::group_percentiles(table.latency_ns, part, g, {0.50, 0.99}, latency, latency_scratch);
+                r.p50_latency_ns = latency[0];
+                r.p99_latency_ns = latency[1];
+            } });
+        return result;
+    }
+
+    // Group-by aggregates over a trade table (BY_DECISION does not apply and is ignored)
+    inline std::vector<TradeGroupStats> aggregate_trades(const TradeTable &table, WorkStealingPool &pool, unsigned group_by)
+    {
+        const size_t n = table.size();
+        analytics::GroupKeys keys = analytics::make_group_keys(table.pair, table.hour, nullptr, nullptr,
+                                                               table.pairs.names.size(), group_by);
+        const size_t groups = keys.groups;
+
+        struct Sums
+        {
+            std::vector<uint64_t> count, wins;
+            std::vector<double> quantity, fees, pnl;
+        };
+        size_t chunk = analytics::chunk_rows(n, pool);
+        size_t chunks = (n + chunk - 1) / chunk;
+        std::vector<Sums> partial(chunks);
+
+        pool.parallel_for(n, chunk, [&](size_t begin, size_t end)
+                          {
+            Sums &s = partial[begin / chunk];
+            s.count.assign(groups, 0);
+            s.wins.assign(groups, 0);
+            s.quantity.assign(groups, 0.0);
+            s.fees.assign(groups, 0.0);
+            s.pnl.assign(groups, 0.0);
+            const uint32_t *k = keys.key.data();
+            const double *q = table.quantity.data();
+            const double *f = table.fees.data();
+            const double *p = table.net_pnl.data();
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t g = k[i];
+                s.count[g]++;
+                s.wins[g] += p[i] > 0.0;
+                s.quantity[g] += q[i];
+                s.fees[g] += f[i];
+                s.pnl[g] += p[i];
+            } });
+
+        Sums total;
+        total.count.assign(groups, 0);
+        total.wins.assign(groups, 0);
+        total.quantity.assign(groups, 0.0);
+        total.fees.assign(groups, 0.0);
+        total.pnl.assign(groups, 0.0);
+        for (const auto &s : partial)
+        {
+            for (size_t g = 0; g < groups; ++g)
+            {
+                total.count[g] += s.count[g];
+                total.wins[g] += s.wins[g];
+                total.quantity[g] += s.quantity[g];
+                total.fees[g] += s.fees[g];
+                total.pnl[g] += s.pnl[g];
+            }
+        }
+
+        std::vector<uint32_t> live;
+        for (size_t g = 0; g < groups; ++g)
+            if (total.count[g] > 0)
+                live.push_back(static_cast<uint32_t>(g));
+
+        analytics::GroupPartition part = analytics::partition_by_group(keys, total.count);
+        std::vector<TradeGroupStats> result(live.size());
+        std::vector<double> scratch;
+        for (size_t j = 0; j < live.size(); ++j)
+        {
+            size_t g = live[j];
+            TradeGroupStats &r = result[j];
+            r.pair = keys.pair_of(g);
+            r.hour = keys.hour_of(g);
+            r.count = total.count[g];
+            r.quantity = total.quantity[g];
+            r.fees = total.fees[g];
+            r.total_pnl = total.pnl[g];
+            r.mean_pnl = total.pnl[g] / r.count;
+            r.win_rate = static_cast<double>(total.wins[g]) / r.count;
+            analytics::group_percentiles(table.net_pnl, part, g, {0.01}, &r.p01_pnl, scratch);
+        }
+        return result;
+    }
+
+} // namespace arbisim
@@ -0,0 +1,245 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cache_line.h"
+#include "latency_histogram.h"
+
+namespace arbisim
+{
+
+    // Aggregated view of a registry at one moment, in registration order
+    struct MetricsSnapshot
+    {
+        std::vector<std::pair<std::string, uint64_t>> counters;
+        std::vector<std::pair<std::string, double>> gauges;
+        std::vector<std::pair<std::string, LatencyHistogram>> histograms;
+
+        uint64_t counter(const std::string &name) const
+        {
+            for (const auto &[n, v] : counters)
+                if (n == name)
+                    return v;
+            return 0;
+        }
+
+        double gauge(const std::string &name) const
+        {
+            for (const auto &[n, v] : gauges)
+                if (n == name)
+                    return v;
+            return 0;
+        }
+
+        const LatencyHistogram *histogram(const std::string &name) const
+        {
+            for (const auto &[n, h] : histograms)
+                if (n == name)
+                    return &h;
+            return nullptr;
+        }
+    };
+
+    // One thread's metrics. Only the owning thread writes, so counters and gauges are
+    // plain load+store (no locked RMW) on lines no other writer touches; readers sum
+    // across shards. Histograms are allocated on the owner's first record.
+    class alignas(CACHE_LINE_SIZE) MetricsShard
+    {
+    public:
+        static constexpr size_t MAX_COUNTERS = 32;
+        static constexpr size_t MAX_GAUGES = 16;
+        static constexpr size_t MAX_HISTOGRAMS = 8;
+
+    private:
+        std::array<std::atomic<uint64_t>, MAX_COUNTERS> counters_{};
+        std::array<std::atomic<double>, MAX_GAUGES> gauges_{};
+        std::array<std::atomic<ConcurrentLatencyHistogram *>, MAX_HISTOGRAMS> histograms_{};
+        std::vector<std::unique_ptr<ConcurrentLatencyHistogram>> owned_; // Owner thread only
+
+        friend class MetricsRegistry;
+
+    public:
+        void add(uint32_t counter, uint64_t n = 1)
+        {
+            if (counter >= MAX_COUNTERS)
+                return;
+            auto &c = counters_[counter];
+            c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        // A gauge's value is the sum of what each thread last set
+        void set(uint32_t gauge, double value)
+        {
+            if (gauge < MAX_GAUGES)
+                gauges_[gauge].store(value, std::memory_order_relaxed);
+        }
+
+        void record(uint32_t histogram, uint64_t value_ns)
+        {
+            if (histogram >= MAX_HISTOGRAMS)
+                return;
+            ConcurrentLatencyHistogram *h = histograms_[histogram].load(std::memory_order_relaxed);
+            if (!h)
+            {
+                owned_.push_back(std::make_unique<ConcurrentLatencyHistogram>());
+                h = owned_.back().get();
+                histograms_[histogram].store(h, std::memory_order_release);
+            }
+            h->record(value_ns);
+        }
+    };
+
+    // Named counters, gauges and latency histograms with one shard per writing thread,
+    // so recording never contends with other writers however many threads record.
+    // Readers (the stats loop, exporters) aggregate on demand: counter() sums one
+    // counter, snapshot() sums everything, drain_histogram() takes a histogram's
+    // interval view. Shards outlive their threads, so totals never go backwards.
+    class MetricsRegistry
+    {
+    public:
+        static constexpr uint32_t INVALID = UINT32_MAX; // Registry full; writes are ignored
+
+    private:
+        mutable std::mutex mutex_;
+        std::vector<std::string> counter_names_;
+        std::vector<std::string> gauge_names_;
+        std::vector<std::string> histogram_names_;
+        std::vector<std::unique_ptr<MetricsShard>> shards_;
+        uint64_t instance_;
+
+        static uint64_t next_instance()
+        {
+            static std::atomic<uint64_t> counter{0};
+            return ++counter;
+        }
+
+        static uint32_t find_or_add(std::vector<std::string> &names, const std::string &name, size_t capacity)
+        {
+            for (size_t i = 0; i < names.size(); ++i)
+                if (names[i] == name)
+                    return static_cast<uint32_t>(i);
+            if (names.size() >= capacity)
+                return INVALID;
+            names.push_back(name);
+            return static_cast<uint32_t>(names.size() - 1);
+        }
+
+        template <typename Fn>
+        void for_each_shard(Fn fn) const
+        {
+            for (const auto &shard : shards_)
+                fn(*shard);
+        }
+
+    public:
+        MetricsRegistry() : instance_(next_instance()) {}
+
+        MetricsRegistry(const MetricsRegistry &) = delete;
+        MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+        // Registering a name twice returns the same id
+        uint32_t counter(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return find_or_add(counter_names_, name, MetricsShard::MAX_COUNTERS);
+        }
+
+        uint32_t gauge(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return find_or_add(gauge_names_, name, MetricsShard::MAX_GAUGES);
+        }
+
+        uint32_t histogram(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return find_or_add(histogram_names_, name, MetricsShard::MAX_HISTOGRAMS);
+        }
+
+        // The calling thread's shard, created on first use. Keyed by registry instance in
+        // a thread_local list; hot loops can hold on to the reference.
+        MetricsShard &local()
+        {
+            thread_local std::vector<std::pair<uint64_t, MetricsShard *>> owned;
+            for (const auto &[instance, cached] : owned)
+                if (instance == instance_)
+                    return *cached;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            shards_.push_back(std::make_unique<MetricsShard>());
+            owned.emplace_back(instance_, shards_.back().get());
+            return *shards_.back();
+        }
+
+        void add(uint32_t counter, uint64_t n = 1) { local().add(counter, n); }
+        void set(uint32_t gauge, double value) { local().set(gauge, value); }
+        void record(uint32_t histogram, uint64_t value_ns) { local().record(histogram, value_ns); }
+
+        // One counter summed across threads, without building a snapshot
+        uint64_t counter_value(uint32_t counter) const
+        {
+            if (counter >= MetricsShard::MAX_COUNTERS)
+                return 0;
+            std::lock_guard<std::mutex> lock(mutex_);
+            uint64_t total = 0;
+            for_each_shard([&](const MetricsShard &s)
+                           { total += s.counters_[counter].load(std::memory_order_relaxed); });
+            return total;
+        }
+
+        // Move everything one histogram recorded since the last drain into out
+        void drain_histogram(uint32_t histogram, LatencyHistogram &out)
+        {
+            if (histogram >= MetricsShard::MAX_HISTOGRAMS)
+                return;
+            std::lock_guard<std::mutex> lock(mutex_);
+            for_each_shard([&](const MetricsShard &s)
+                           {
+                if (auto *h = s.histograms_[histogram].load(std::memory_order_acquire))
+                    h->drain_into(out); });
+        }
+
+        // Everything summed across threads. Histograms show what has not been drained.
+        MetricsSnapshot snapshot() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            MetricsSnapshot snap;
+            for (size_t i = 0; i < counter_names_.size(); ++i)
+            {
+                uint64_t total = 0;
+                for_each_shard([&](const MetricsShard &s)
+                               { total += s.counters_[i].load(std::memory_order_relaxed); });
+                snap.counters.emplace_back(counter_names_[i], total);
+            }
+            for (size_t i = 0; i < gauge_names_.size(); ++i)
+            {
+                double total = 0.0;
+                for_each_shard([&](const MetricsShard &s)
+                               { total += s.gauges_[i].load(std::memory_order_relaxed); });
+                snap.gauges.emplace_back(gauge_names_[i], total);
+            }
+            for (size_t i = 0; i < histogram_names_.size(); ++i)
+            {
+                snap.histograms.emplace_back(histogram_names_[i], LatencyHistogram());
+                for_each_shard([&](const MetricsShard &s)
+                               {
+                    if (auto *h = s.histograms_[i].load(std::memory_order_acquire))
+                        h->snapshot_into(snap.histograms.back().second); });
+            }
+            return snap;
+        }
+
+        size_t shard_count() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return shards_.size();
+        }
+    };
+
+} // namespace arbisim
@@ -0,0 +1,332 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "arbisim_core.h"
+#include "latency_histogram.h"
+#include "net_socket.h"
+
+namespace arbisim
+{
+
+    // Prometheus text exposition format (version 0.0.4): a HELP and TYPE line per metric
+    // family, then one sample per line
+    namespace prometheus
+    {
+        inline void put_value(std::string &out, double value)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.10g", value);
+            out += buf;
+        }
+
+        inline void family(std::string &out, const char *name, const char *type, const char *help)
+        {
+            out += "# HELP ";
+            out += name;
+            out += ' ';
+            out += help;
+            out += "\n# TYPE ";
+            out += name;
+            out += ' ';
+            out += type;
+            out += '\n';
+        }
+
+        // labels without braces, e.g. venue="binance"
+        inline void sample(std::string &out, const std::string &name, double value, const std::string &labels = "")
+        {
+            out += name;
+            if (!labels.empty())
+                out += '{' + labels + '}';
+            out += ' ';
+            put_value(out, value);
+            out += '\n';
+        }
+
+        inline void counter(std::string &out, const char *name, const char *help, double value)
+        {
+            family(out, name, "counter", help);
+            sample(out, name, value);
+        }
+
+        inline void gauge(std::string &out, const char *name, const char *help, double value)
+        {
+            family(out, name, "gauge", help);
+            sample(out, name, value);
+        }
+
+        // A latency histogram in seconds, on a fixed 1 us .. 1 s ladder. Bucket counts are
+        // exact to the histogram's resolution (1/64 of the bound).
+        inline void histogram(std::string &out, const char *name, const char *help, const LatencyHistogram &h)
+        {
+            static const uint64_t bounds_ns[] = {1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+                                                 1000000, 2500000, 5000000, 10000000, 25000000, 50000000,
+                                                 100000000, 250000000, 1000000000};
+            family(out, name, "histogram", help);
+            std::string bucket = std::string(name) + "_bucket";
+            for (uint64_t bound : bounds_ns)
+            {
+                char le[32];
+                std::snprintf(le, sizeof(le), "le=\"%g\"", bound / 1e9);
+                sample(out, bucket, static_cast<double>(h.count_at_or_below(bound)), le);
+            }
+            sample(out, bucket, static_cast<double>(h.count()), "le=\"+Inf\"");
+            sample(out, std::string(name) + "_sum", h.sum() / 1e9);
+            sample(out, std::string(name) + "_count", static_cast<double>(h.count()));
+        }
+    } // namespace prometheus
+
+    struct MetricsServerConfig
+    {
+        std::string host = "127.0.0.1"; // Loopback only: unauthenticated
+        uint16_t port = 9464;           // 0 = any free port
+        int poll_interval_ms = 100;     // Only bounds how long stop() waits
+        size_t max_clients = 8;
+        size_t max_request = 8192;
+        uint64_t request_timeout_ms = 5000; // Close connections that never finish a request
+    };
+
+    // Plain HTTP/1.1 endpoint for Prometheus scrapes, on its own thread. GET /metrics
+    // calls the body source on this thread and answers with it; every response closes
+    // the connection. The source should read only lock-free state (registry snapshots,
+    // atomics), so a scrape costs the engine nothing but the reads.
+    class MetricsServer
+    {
+    public:
+        struct Stats
+        {
+            uint64_t scrapes = 0;
+            uint64_t rejected = 0; // Not GET /metrics, malformed, or over max_clients
+        };
+
+    private:
+        struct Client
+        {
+            net::socket_t socket;
+            std::string in;
+            std::string out;
+            size_t out_offset = 0;
+            bool responded = false;
+            uint64_t accepted_ns = 0;
+        };
+
+        MetricsServerConfig config_;
+        net::socket_t listener_ = net::INVALID_SOCKET_VALUE;
+        uint16_t port_ = 0;
+        std::thread thread_;
+        std::atomic<bool> running_{false};
+        std::function<std::string()> source_;
+        std::vector<Client> clients_; // Server thread only
+
+        std::atomic<uint64_t> scrapes_{0};
+        std::atomic<uint64_t> rejected_{0};
+
+        static std::string response(const char *status, const char *content_type, const std::string &body)
+        {
+            return std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + content_type +
+                   "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        }
+
+        // Returns false if the request is not complete yet
+        bool respond(Client &client)
+        {
+            size_t header_end = client.in.find("\r\n\r\n");
+            if (header_end == std::string::npos)
+            {
+                if (client.in.size() < config_.max_request)
+                    return false;
+                client.out = response("431 Request Header Fields Too Large", "text/plain", "");
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            // Request line: METHOD SP TARGET SP VERSION; the query string is ignored
+            size_t line_end = client.in.find("\r\n");
+            std::string line = client.in.substr(0, line_end);
+            size_t sp1 = line.find(' '), sp2 = line.rfind(' ');
+            std::string method = line.substr(0, sp1);
+            std::string target = sp1 != std::string::npos && sp2 > sp1 ? line.substr(sp1 + 1, sp2 - sp1 - 1) : "";
+            target = target.substr(0, target.find('?'));
+
+            if (method != "GET" && method != "HEAD")
+            {
+                client.out = response("405 Method Not Allowed", "text/plain", "");
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (target != "/metrics")
+            {
+                client.out = response("404 Not Found", "text/plain", "Try /metrics\n");
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                std::string body = source_ ? source_() : std::string();
+                client.out = response("200 OK", "text/plain; version=0.0.4; charset=utf-8", body);
+                if (method == "HEAD")
+                    client.out.resize(client.out.size() - body.size());
+                scrapes_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        // Returns false once the connection can be closed
+        bool flush(Client &client)
+        {
+            while (client.out_offset < client.out.size())
+            {
+                long n = net::send_some(client.socket, client.out.data() + client.out_offset,
+                                        client.out.size() - client.out_offset);
+                if (n < 0)
+                    return false;
+                if (n == 0)
+                    return true;
+                client.out_offset += static_cast<size_t>(n);
+            }
+            return !client.responded;
+        }
+
+        void serve()
+        {
+            std::vector<net::PollFd> fds;
+            std::vector<char> buffer(4096);
+
+            while (running_.load(std::memory_order_relaxed))
+            {
+                fds.clear();
+                net::PollFd listen_fd{};
+                listen_fd.fd = listener_;
+                listen_fd.events = POLLIN;
+                fds.push_back(listen_fd);
+                for (const auto &client : clients_)
+                {
+                    net::PollFd fd{};
+                    fd.fd = client.socket;
+                    fd.events = client.responded ? POLLOUT : POLLIN;
+                    fds.push_back(fd);
+                }
+
+                net::poll_sockets(fds.data(), fds.size(), config_.poll_interval_ms);
+
+                // Reads first (clients accepted below are polled next cycle)
+                for (size_t i = 1; i < fds.size(); ++i)
+                {
+                    Client &client = clients_[i - 1];
+                    if (client.responded || !(fds[i].revents & (POLLIN | POLLERR | POLLHUP)))
+                        continue;
+                    long n;
+                    while ((n = net::recv_some(client.socket, buffer.data(), buffer.size())) > 0)
+                        client.in.append(buffer.data(), static_cast<size_t>(n));
+                    if (n < 0)
+                        client.responded = true; // Gone: nothing to send, close below
+                    else if (respond(client))
+                        client.responded = true;
+                }
+
+                if (fds[0].revents & POLLIN)
+                {
+                    net::socket_t s;
+                    while ((s = net::accept_client(listener_)) != net::INVALID_SOCKET_VALUE)
+                    {
+                        if (clients_.size() >= config_.max_clients)
+                        {
+                            net::close_socket(s);
+                            rejected_.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        Client client;
+                        client.socket = s;
+                        client.accepted_ns = timestamp_ns();
+                        clients_.push_back(std::move(client));
+                    }
+                }
+
+                uint64_t now = timestamp_ns();
+                for (size_t i = 0; i < clients_.size();)
+                {
+                    if (!clients_[i].responded && now - clients_[i].accepted_ns > config_.request_timeout_ms * 1000000ULL)
+                    {
+                        clients_[i].responded = true;
+                        rejected_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    if (!flush(clients_[i]))
+                    {
+                        net::close_socket(clients_[i].socket);
+                        clients_[i] = std::move(clients_.back());
+                        clients_.pop_back();
+                        continue;
+                    }
+                    ++i;
+                }
+            }
+
+            for (auto &client : clients_)
+                net::close_socket(client.socket);
+            clients_.clear();
+        }
+
+    public:
+        MetricsServer() = default;
+        ~MetricsServer() { stop(); }
+
+        MetricsServer(const MetricsServer &) = delete;
+        MetricsServer &operator=(const MetricsServer &) = delete;
+
+        // Builds the /metrics body; called on the server thread per scrape (set before start)
+        void set_source(std::function<std::string()> source)
+        {
+            source_ = std::move(source);
+        }
+
+        // Bind and start serving; false if the port is taken
+        bool start(const MetricsServerConfig &config = MetricsServerConfig())
+        {
+            if (running_.load())
+                return false;
+            config_ = config;
+
+            if (!net::startup())
+                return false;
+            listener_ = net::listen_tcp(config_.host.c_str(), config_.port);
+            if (listener_ == net::INVALID_SOCKET_VALUE)
+            {
+                net::cleanup();
+                return false;
+            }
+            port_ = net::local_port(listener_);
+
+            running_.store(true);
+            thread_ = std::thread([this]()
+                                  { serve(); });
+            return true;
+        }
+
+        void stop()
+        {
+            if (!running_.exchange(false))
+                return;
+            if (thread_.joinable())
+                thread_.join();
+            net::close_socket(listener_);
+            listener_ = net::INVALID_SOCKET_VALUE;
+            net::cleanup();
+        }
+
+        bool running() const { return running_.load(); }
+        uint16_t port() const { return port_; }
+
+        Stats get_stats() const
+        {
+            Stats stats;
+            stats.scrapes = scrapes_.load();
+            stats.rejected = rejected_.load();
+            return stats;
+        }
+    };
+
+} // namespace arbisim
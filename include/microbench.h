@@ -0,0 +1,301 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "arbisim_core.h"
+
+#if defined(__OPTIMIZE__) || (defined(_MSC_VER) && !defined(_DEBUG))
+#define ARBISIM_OPTIMIZED_BUILD 1
+#endif
+
+namespace arbisim
+{
+    namespace bench
+    {
+        // Keep a computed value alive so the optimizer cannot drop the work behind it
+        template <typename T>
+        inline void do_not_optimize(const T &value)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : "r,m"(value) : "memory");
+#else
+            static const void *volatile sink;
+            sink = &value;
+#endif
+        }
+
+        // Cost of the two clock reads around a timed region (the cheapest of many tries)
+        inline uint64_t clock_overhead_ns()
+        {
+            static const uint64_t overhead = []()
+            {
+                uint64_t best = UINT64_MAX;
+                for (int i = 0; i < 1000; ++i)
+                {
+                    uint64_t start = timestamp_ns();
+                    best = std::min(best, timestamp_ns() - start);
+                }
+                return best;
+            }();
+            return overhead;
+        }
+
+        // ns spent in fn(), less the clock overhead
+        template <typename Fn>
+        inline uint64_t timed(Fn fn)
+        {
+            uint64_t start = timestamp_ns();
+            fn();
+            uint64_t elapsed = timestamp_ns() - start;
+            return elapsed > clock_overhead_ns() ? elapsed - clock_overhead_ns() : 0;
+        }
+
+        struct Summary
+        {
+            double min = 0.0;
+            double median = 0.0;
+            double mean = 0.0;
+            double p90 = 0.0;
+            double max = 0.0;
+            double stddev = 0.0;
+
+            double cv() const { return mean > 0.0 ? stddev / mean : 0.0; }
+
+            static Summary of(std::vector<double> samples)
+            {
+                Summary s;
+                if (samples.empty())
+                    return s;
+                std::sort(samples.begin(), samples.end());
+                size_t n = samples.size();
+                s.min = samples.front();
+                s.max = samples.back();
+                s.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+                s.p90 = samples[std::min(n - 1, static_cast<size_t>(std::ceil(0.9 * n)) - 1)];
+                double sum = 0.0;
+                for (double v : samples)
+                    sum += v;
+                s.mean = sum / n;
+                double var = 0.0;
+                for (double v : samples)
+                    var += (v - s.mean) * (v - s.mean);
+                s.stddev = n > 1 ? std::sqrt(var / (n - 1)) : 0.0;
+                return s;
+            }
+        };
+
+        using Params = std::vector<std::pair<std::string, long long>>;
+
+        struct BenchResult
+        {
+            std::string name;
+            Params params;
+            uint64_t ops_per_rep = 0;
+            std::vector<double> samples; // ns/op, one per repetition
+            Summary summary;
+
+            // name/key=value/... : stable across runs, used to match results for comparison
+            std::string id() const
+            {
+                std::string id = name;
+                for (const auto &[key, value] : params)
+                    id += "/" + key + "=" + std::to_string(value);
+                return id;
+            }
+        };
+
+        struct BenchConfig
+        {
+            uint64_t warmup_ns = 50000000ULL; // Also sizes a repetition
+            size_t repetitions = 10;
+            uint64_t min_rep_ns = 10000000ULL; // Timed work per repetition
+        };
+
+        // Runs benchmark bodies with warmup and repeated timed samples, and keeps the
+        // results for printing and JSON export. A body performs a fixed number of
+        // operations per call and returns the ns spent in its timed part (see timed()),
+        // so per-call setup and state restoration stay out of the numbers.
+        class BenchRunner
+        {
+        private:
+            BenchConfig config_;
+            std::vector<std::string> filters_;
+            std::vector<BenchResult> results_;
+
+            static void put_double(std::string &out, double value)
+            {
+                char buf[32];
+                std::snprintf(buf, sizeof(buf), "%.3f", value);
+                out += buf;
+            }
+
+        public:
+            explicit BenchRunner(const BenchConfig &config = BenchConfig()) : config_(config)
+            {
+                config_.repetitions = std::max<size_t>(1, config_.repetitions);
+            }
+
+            const BenchConfig &config() const { return config_; }
+            const std::vector<BenchResult> &results() const { return results_; }
+
+            // Comma-separated substrings; a benchmark runs if its id contains any of them
+            void set_filter(const std::string &list)
+            {
+                filters_.clear();
+                std::stringstream ss(list);
+                std::string item;
+                while (std::getline(ss, item, ','))
+                    if (!item.empty())
+                        filters_.push_back(item);
+            }
+
+            bool selected(const std::string &id) const
+            {
+                if (filters_.empty())
+                    return true;
+                for (const auto &f : filters_)
+                    if (id.find(f) != std::string::npos)
+                        return true;
+                return false;
+            }
+
+            // Returns the result, or nullptr if the filter skipped it
+            template <typename Body>
+            const BenchResult *run(const std::string &name, const Params &params, uint64_t ops_per_call, Body body)
+            {
+                BenchResult result;
+                result.name = name;
+                result.params = params;
+                if (!selected(result.id()) || ops_per_call == 0)
+                    return nullptr;
+
+                // Warm caches and branch predictors, and measure a call's timed cost
+                uint64_t warm_start = timestamp_ns();
+                uint64_t warm_ns = 0, warm_calls = 0;
+                do
+                {
+                    warm_ns += body();
+                    ++warm_calls;
+                } while (timestamp_ns() - warm_start < config_.warmup_ns);
+
+                double ns_per_call = std::max(1.0, static_cast<double>(warm_ns) / warm_calls);
+                uint64_t calls = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(config_.min_rep_ns / ns_per_call)));
+                result.ops_per_rep = calls * ops_per_call;
+
+                for (size_t rep = 0; rep < config_.repetitions; ++rep)
+                {
+                    uint64_t elapsed = 0;
+                    for (uint64_t c = 0; c < calls; ++c)
+                        elapsed += body();
+                    result.samples.push_back(static_cast<double>(elapsed) / result.ops_per_rep);
+                }
+                result.summary = Summary::of(result.samples);
+                results_.push_back(std::move(result));
+                return &results_.back();
+            }
+
+            // One result per line, so results can be diffed and matched by id
+            std::string to_json() const
+            {
+                std::string out = "{\"suite\":\"arbisim-microbench\",\"timestamp_ns\":" + std::to_string(timestamp_ns());
+#ifdef ARBISIM_OPTIMIZED_BUILD
+                out += ",\"optimized\":true";
+#else
+                out += ",\"optimized\":false";
+#endif
+                TscClock &tsc = TscClock::instance();
+                out += ",\"clock\":{\"tsc\":" + std::string(tsc.uses_tsc() ? "true" : "false") + ",\"ghz\":";
+                put_double(out, tsc.ghz());
+                out += ",\"overhead_ns\":" + std::to_string(clock_overhead_ns()) + "}";
+                out += ",\"config\":{\"warmup_ns\":" + std::to_string(config_.warmup_ns) +
+                       ",\"repetitions\":" + std::to_string(config_.repetitions) +
+                       ",\"min_rep_ns\":" + std::to_string(config_.min_rep_ns) + "}";
+                out += ",\"results\":[\n";
+
+                for (size_t i = 0; i < results_.size(); ++i)
+                {
+                    const BenchResult &r = results_[i];
+                    out += "{\"id\":\"" + r.id() + "\",\"name\":\"" + r.name + "\",\"params\":{";
+                    for (size_t p = 0; p < r.params.size(); ++p)
+                        out += (p ? ",\"" : "\"") + r.params[p].first + "\":" + std::to_string(r.params[p].second);
+                    out += "},\"ops_per_rep\":" + std::to_string(r.ops_per_rep) + ",\"unit\":\"ns/op\"";
+                    const std::pair<const char *, double> stats[] = {
+                        {"min_ns", r.summary.min}, {"median_ns", r.summary.median}, {"mean_ns", r.summary.mean},
+                        {"p90_ns", r.summary.p90}, {"max_ns", r.summary.max}, {"stddev_ns", r.summary.stddev},
+                        {"cv", r.summary.cv()}};
+                    for (const auto &[key, value] : stats)
+                    {
+                        out += ",\"";
+                        out += key;
+                        out += "\":";
+                        put_double(out, value);
+                    }
+                    out += ",\"samples_ns\":[";
+                    for (size_t s = 0; s < r.samples.size(); ++s)
+                    {
+                        if (s)
+                            out += ',';
+                        put_double(out, r.samples[s]);
+                    }
+                    out += i + 1 < results_.size() ? "]},\n" : "]}\n";
+                }
+                out += "]}\n";
+                return out;
+            }
+
+            bool write_json(const std::string &path) const
+            {
+                std::ofstream out(path, std::ios::binary);
+                if (!out)
+                    return false;
+                out << to_json();
+                return static_cast<bool>(out);
+            }
+
+            void print(const BenchResult &r) const
+            {
+                std::cout << std::left << std::setw(52) << r.id() << std::right << std::fixed << std::setprecision(1)
+                          << std::setw(10) << r.summary.median << std::setw(10) << r.summary.p90
+                          << std::setw(10) << r.summary.min << std::setw(7) << r.summary.cv() * 100.0 << "%" << std::endl;
+            }
+
+            void print_header() const
+            {
+                std::cout << std::left << std::setw(52) << "benchmark (ns/op)" << std::right << std::setw(10) << "median"
+                          << std::setw(10) << "p90" << std::setw(10) << "min" << std::setw(8) << "cv" << std::endl;
+            }
+        };
+
+        // (id, median ns/op) of every result in a file written by BenchRunner::write_json
+        inline bool read_json_medians(const std::string &path, std::vector<std::pair<std::string, double>> &medians)
+        {
+            std::ifstream in(path);
+            if (!in)
+                return false;
+            std::string line;
+            while (std::getline(in, line))
+            {
+                size_t id = line.find("{\"id\":\"");
+                size_t median = line.find("\"median_ns\":");
+                if (id == std::string::npos || median == std::string::npos)
+                    continue;
+                id += 7;
+                size_t id_end = line.find('"', id);
+                if (id_end == std::string::npos)
+                    continue;
+                medians.emplace_back(line.substr(id, id_end - id), std::strtod(line.c_str() + median + 12, nullptr));
+            }
+            return true;
+        }
+    } // namespace bench
+
+} // namespace arbisim
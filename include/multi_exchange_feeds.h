@@ -10,6 +10,7 @@
 #include <sstream>
 #include <string>
 #include "arbisim_core.h"
+#include "cache_line.h"
 
 namespace arbisim
 {
@@ -81,11 +82,13 @@ namespace arbisim
     };
 
     // Base class for all exchange feeds
-    class ExchangeFeedBase
+    class alignas(CACHE_LINE_SIZE) ExchangeFeedBase
     {
     protected:
-        std::thread worker_thread_;
-        std::atomic<bool> running_{false};
+        // Written by the controlling thread, polled by the worker every tick; alone on its
+        // line so the worker's own state (here and in derived feeds) does not share it
+        alignas(CACHE_LINE_SIZE) std::atomic<bool> running_{false};
+        alignas(CACHE_LINE_SIZE) std::thread worker_thread_;
         std::function<void(const MarketUpdate &)> update_callback_;
         std::string symbol_ = "BTCUSDT";
         std::string exchange_name_;
@@ -154,10 +157,11 @@ namespace arbisim
                 double ask = mid_price + half_spread;
                 
                 if (update_callback_) {
-                    MarketUpdate bid_update(MarketUpdate::BID_UPDATE, symbol_, exchange_name_, bid, 150.0);
+                    uint64_t quoted_ns = timestamp_ns(); // One stamp for both sides of the quote
+                    MarketUpdate bid_update(MarketUpdate::BID_UPDATE, symbol_, exchange_name_, bid, 150.0, 0, quoted_ns);
                     update_callback_(bid_update);
                     
-                    MarketUpdate ask_update(MarketUpdate::ASK_UPDATE, symbol_, exchange_name_, ask, 150.0);
+                    MarketUpdate ask_update(MarketUpdate::ASK_UPDATE, symbol_, exchange_name_, ask, 150.0, 0, quoted_ns);
                     update_callback_(ask_update);
                 }
                 
@@ -200,10 +204,11 @@ namespace arbisim
                 double ask = mid_price + half_spread;
                 
                 if (update_callback_) {
-                    MarketUpdate bid_update(MarketUpdate::BID_UPDATE, symbol_, exchange_name_, bid, 120.0);
+                    uint64_t quoted_ns = timestamp_ns();
+                    MarketUpdate bid_update(MarketUpdate::BID_UPDATE, symbol_, exchange_name_, bid, 120.0, 0, quoted_ns);
                     update_callback_(bid_update);
                     
-                    MarketUpdate ask_update(MarketUpdate::ASK_UPDATE, symbol_, exchange_name_, ask, 120.0);
+                    MarketUpdate ask_update(MarketUpdate::ASK_UPDATE, symbol_, exchange_name_, ask, 120.0, 0, quoted_ns);
                     update_callback_(ask_update);
                 }
                 
@@ -246,10 +251,11 @@ namespace arbisim
                 double ask = mid_price + half_spread;
                 
                 if (update_callback_) {
-                    MarketUpdate bid_update(MarketUpdate::BID_UPDATE, symbol_, exchange_name_, bid, 80.0);
+                    uint64_t quoted_ns = timestamp_ns();
+                    MarketUpdate bid_update(MarketUpdate::BID_UPDATE, symbol_, exchange_name_, bid, 80.0, 0, quoted_ns);
                     update_callback_(bid_update);
                     
-                    MarketUpdate ask_update(MarketUpdate::ASK_UPDATE, symbol_, exchange_name_, ask, 80.0);
+                    MarketUpdate ask_update(MarketUpdate::ASK_UPDATE, symbol_, exchange_name_, ask, 80.0, 0, quoted_ns);
                     update_callback_(ask_update);
                 }
                 
@@ -293,10 +299,11 @@ namespace arbisim
                 double ask = mid_price + half_spread;
                 
                 if (update_callback_) {
-                    MarketUpdate bid_update(MarketUpdate::BID_UPDATE, symbol_, exchange_name_, bid, 200.0);
+                    uint64_t quoted_ns = timestamp_ns();
+                    MarketUpdate bid_update(MarketUpdate::BID_UPDATE, symbol_, exchange_name_, bid, 200.0, 0, quoted_ns);
                     update_callback_(bid_update);
                     
-                    MarketUpdate ask_update(MarketUpdate::ASK_UPDATE, symbol_, exchange_name_, ask, 200.0);
+                    MarketUpdate ask_update(MarketUpdate::ASK_UPDATE, symbol_, exchange_name_, ask, 200.0, 0, quoted_ns);
                     update_callback_(ask_update);
                 }
                 
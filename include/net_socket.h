@@ -0,0 +1,175 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace arbisim
+{
+
+    // Minimal non-blocking TCP helpers over BSD sockets / Winsock, just enough for
+    // the loopback dashboard server. Every call reports failure through its return
+    // value; nothing throws.
+    namespace net
+    {
+#ifdef _WIN32
+        using socket_t = SOCKET;
+        static const socket_t INVALID_SOCKET_VALUE = INVALID_SOCKET;
+        using PollFd = WSAPOLLFD;
+
+        inline bool startup()
+        {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }
+        inline void cleanup() { WSACleanup(); }
+        inline void close_socket(socket_t s) { closesocket(s); }
+        inline bool would_block() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+        inline int poll_sockets(PollFd *fds, size_t count, int timeout_ms)
+        {
+            return WSAPoll(fds, static_cast<ULONG>(count), timeout_ms);
+        }
+        inline bool set_nonblocking(socket_t s)
+        {
+            u_long mode = 1;
+            return ioctlsocket(s, FIONBIO, &mode) == 0;
+        }
+#else
+        using socket_t = int;
+        static const socket_t INVALID_SOCKET_VALUE = -1;
+        using PollFd = pollfd;
+
+        inline bool startup() { return true; }
+        inline void cleanup() {}
+        inline void close_socket(socket_t s) { ::close(s); }
+        inline bool would_block() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+        inline int poll_sockets(PollFd *fds, size_t count, int timeout_ms)
+        {
+            return ::poll(fds, static_cast<nfds_t>(count), timeout_ms);
+        }
+        inline bool set_nonblocking(socket_t s)
+        {
+            int flags = ::fcntl(s, F_GETFL, 0);
+            return flags >= 0 && ::fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+        }
+#endif
+
+        // Small writes are already batched by the caller; don't let Nagle hold them back
+        inline void set_nodelay(socket_t s)
+        {
+            int one = 1;
+            ::setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
+#ifdef SO_NOSIGPIPE
+            ::setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, reinterpret_cast<const char *>(&one), sizeof(one));
+#endif
+        }
+
+        // Non-blocking listener on host:port (port 0 picks a free one, see local_port)
+        inline socket_t listen_tcp(const char *host, uint16_t port, int backlog = 16)
+        {
+            socket_t s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (s == INVALID_SOCKET_VALUE)
+                return INVALID_SOCKET_VALUE;
+
+#ifndef _WIN32
+            // Allow a quick restart while old connections sit in TIME_WAIT
+            int one = 1;
+            ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+#endif
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (::inet_pton(AF_INET, host, &addr.sin_addr) != 1 ||
+                ::bind(s, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+                ::listen(s, backlog) != 0 || !set_nonblocking(s))
+            {
+                close_socket(s);
+                return INVALID_SOCKET_VALUE;
+            }
+            return s;
+        }
+
+        inline uint16_t local_port(socket_t s)
+        {
+            sockaddr_in addr;
+            socklen_t len = sizeof(addr);
+            if (::getsockname(s, reinterpret_cast<sockaddr *>(&addr), &len) != 0)
+                return 0;
+            return ntohs(addr.sin_port);
+        }
+
+        // Returns INVALID_SOCKET_VALUE when nothing is pending
+        inline socket_t accept_client(socket_t listener)
+        {
+            socket_t s = ::accept(listener, nullptr, nullptr);
+            if (s == INVALID_SOCKET_VALUE)
+                return INVALID_SOCKET_VALUE;
+            if (!set_nonblocking(s))
+            {
+                close_socket(s);
+                return INVALID_SOCKET_VALUE;
+            }
+            set_nodelay(s);
+            return s;
+        }
+
+        // Blocking connect, for tests and tools
+        inline socket_t connect_tcp(const char *host, uint16_t port)
+        {
+            socket_t s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (s == INVALID_SOCKET_VALUE)
+                return INVALID_SOCKET_VALUE;
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (::inet_pton(AF_INET, host, &addr.sin_addr) != 1 ||
+                ::connect(s, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+            {
+                close_socket(s);
+                return INVALID_SOCKET_VALUE;
+            }
+            set_nodelay(s);
+            return s;
+        }
+
+        // Bytes sent (0 if the socket buffer is full), or -1 if the connection is gone
+        inline long send_some(socket_t s, const char *data, size_t len)
+        {
+#if defined(MSG_NOSIGNAL)
+            long n = static_cast<long>(::send(s, data, len, MSG_NOSIGNAL));
+#else
+            long n = static_cast<long>(::send(s, data, static_cast<int>(len), 0));
+#endif
+            if (n < 0)
+                return would_block() ? 0 : -1;
+            return n;
+        }
+
+        // Bytes received, 0 if nothing is available, or -1 on close or error
+        inline long recv_some(socket_t s, char *data, size_t len)
+        {
+            long n = static_cast<long>(::recv(s, data, static_cast<int>(len), 0));
+            if (n == 0)
+                return -1;
+            if (n < 0)
+                return would_block() ? 0 : -1;
+            return n;
+        }
+    } // namespace net
+
+} // namespace arbisim
@@ -0,0 +1,180 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "arbisim_core.h"
+#include "risk_pipeline.h"
+
+namespace arbisim
+{
+
+    // Bounded priority queue between detection and risk. Opportunities are served best
+    // expected net P&L first (fresher first on ties); each carries a deadline of
+    // market update time + latency budget and is dropped, not served, once it passes.
+    // When full, a new opportunity displaces the worst queued one, or is refused if it
+    // is no better.
+    class OpportunityQueue
+    {
+    public:
+        struct Stats
+        {
+            uint64_t pushed = 0;
+            uint64_t served = 0;
+            uint64_t expired = 0; // Dropped for exceeding the latency budget
+            uint64_t evicted = 0; // Displaced or refused while the queue was full
+            size_t depth = 0;
+            size_t max_depth = 0;
+        };
+
+    private:
+        struct Entry
+        {
+            ArbitrageOpportunity opp;
+            uint64_t market_ts_ns;
+            uint64_t deadline_ns;
+            double score;
+        };
+
+        // Max-heap order: higher score first, then newer market data
+        static bool lower_priority(const Entry &a, const Entry &b)
+        {
+            if (a.score != b.score)
+                return a.score < b.score;
+            return a.market_ts_ns < b.market_ts_ns;
+        }
+
+        size_t capacity_;
+        uint64_t latency_budget_ns_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable ready_cv_;
+        std::vector<Entry> heap_;
+        bool closed_ = false;
+        Stats stats_;
+
+    public:
+        explicit OpportunityQueue(size_t capacity = 256, uint64_t latency_budget_ns = 2000000)
+            : capacity_(std::max<size_t>(1, capacity)), latency_budget_ns_(latency_budget_ns)
+        {
+            heap_.reserve(capacity_);
+        }
+
+        void set_latency_budget_ns(uint64_t budget_ns)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            latency_budget_ns_ = budget_ns;
+        }
+
+        uint64_t latency_budget_ns() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return latency_budget_ns_;
+        }
+
+        // market_ts_ns is the MarketUpdate timestamp the opportunity was detected from.
+        // Returns false if the opportunity was refused because the queue is full of better ones.
+        bool push(ArbitrageOpportunity opp, uint64_t market_ts_ns)
+        {
+            Entry entry{std::move(opp), market_ts_ns, market_ts_ns + latency_budget_ns_, 0.0};
+            entry.score = FeeModel::expected_net_pnl(entry.opp);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (closed_)
+                    return false;
+                stats_.pushed++;
+
+                if (heap_.size() >= capacity_)
+                {
+                    // The worst entry is one of the leaves
+                    auto worst = std::min_element(heap_.begin() + heap_.size() / 2, heap_.end(), lower_priority);
+                    if (!lower_priority(*worst, entry))
+                    {
+                        stats_.evicted++;
+                        return false;
+                    }
+                    *worst = std::move(entry);
+                    std::make_heap(heap_.begin(), heap_.end(), lower_priority);
+                    stats_.evicted++;
+                }
+                else
+                {
+                    heap_.push_back(std::move(entry));
+                    std::push_heap(heap_.begin(), heap_.end(), lower_priority);
+                }
+                stats_.max_depth = std::max(stats_.max_depth, heap_.size());
+            }
+            ready_cv_.notify_one();
+            return true;
+        }
+
+        // Move up to max_count live opportunities into out, best first. Entries whose
+        // deadline is before now_ns are discarded and counted as expired. stats, if given,
+        // gets get_stats() as of the pop, under the lock already held.
+        size_t pop_batch(std::vector<ArbitrageOpportunity> &out, size_t max_count, uint64_t now_ns,
+                         Stats *stats = nullptr)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t taken = 0;
+            while (!heap_.empty() && taken < max_count)
+            {
+                std::pop_heap(heap_.begin(), heap_.end(), lower_priority);
+                Entry &entry = heap_.back();
+                if (entry.deadline_ns < now_ns)
+                {
+                    stats_.expired++;
+                }
+                else
+                {
+                    out.push_back(std::move(entry.opp));
+                    stats_.served++;
+                    taken++;
+                }
+                heap_.pop_back();
+            }
+            if (stats)
+            {
+                *stats = stats_;
+                stats->depth = heap_.size();
+            }
+            return taken;
+        }
+
+        // Block until something is queued, the queue is closed or the timeout passes
+        bool wait_for_work(std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_cv_.wait_for(lock, timeout, [this]()
+                               { return closed_ || !heap_.empty(); });
+            return !heap_.empty();
+        }
+
+        // Wake waiters and refuse further pushes; queued entries can still be drained
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+            }
+            ready_cv_.notify_all();
+        }
+
+        bool closed() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return closed_;
+        }
+
+        Stats get_stats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Stats stats = stats_;
+            stats.depth = heap_.size();
+            return stats;
+        }
+    };
+
+} // namespace arbisim
@@ -0,0 +1,267 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace arbisim
+{
+
+    // Pipeline stages, in the order an update passes through them
+    enum class TraceStage : uint8_t
+    {
+        FEED,        // Feed thread: update stamped to handed to the engine
+        ENQUEUE,     // Feed thread: push into the update queue
+        DEQUEUE,     // Market thread: swap the pending batch out
+        BOOK_APPLY,  // Market thread: apply the delta to its book
+        DETECT,      // Market thread: detection pass over the symbol
+        RISK,        // Risk thread: batch assessment the opportunity was part of
+        LOG_ENQUEUE, // Risk or market thread: hand the record to the log writer
+        LOG_WRITE    // Log writer thread: format and write the batch holding the record
+    };
+
+    inline const char *trace_stage_name(TraceStage stage)
+    {
+        static const char *names[] = {"feed", "enqueue", "dequeue", "book_apply", "detect", "risk", "log_enqueue", "log_write"};
+        return names[static_cast<size_t>(stage)];
+    }
+
+    struct TraceEvent
+    {
+        uint64_t trace_id = 0; // Market update the stage worked on behalf of
+        uint64_t begin_ns = 0;
+        uint64_t end_ns = 0;
+        TraceStage stage = TraceStage::FEED;
+    };
+
+    struct TraceConfig
+    {
+        bool enabled = false;
+        uint64_t sample_every = 1;       // Trace one update in this many (and everything it causes)
+        size_t events_per_thread = 65536; // Per-thread ring; the oldest events are overwritten
+    };
+
+    // Per-event stage spans for sampled market updates. Each update gets a trace id when
+    // it enters the engine; every stage that handles it, or something derived from it,
+    // records one span into a ring owned by the recording thread. Untraced updates carry
+    // id 0 and every record call returns on that check, so a disabled tracer costs a
+    // branch per stage. Exported as Chrome trace JSON (chrome://tracing, Perfetto).
+    class PipelineTracer
+    {
+    private:
+        struct ThreadBuffer
+        {
+            std::mutex mutex; // Uncontended except while exporting
+            std::vector<TraceEvent> events;
+            uint64_t head = 0;
+            uint32_t tid = 0;
+            std::string name;
+        };
+
+        TraceConfig config_;
+        std::atomic<bool> enabled_{false};
+        std::atomic<uint64_t> next_id_{0};
+        uint64_t instance_;
+
+        std::mutex registry_mutex_;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+        static uint64_t next_instance()
+        {
+            static std::atomic<uint64_t> counter{0};
+            return ++counter;
+        }
+
+        // This thread's buffer, created on first use. Keyed by tracer instance in a
+        // thread_local list (not by thread id, which the OS reuses after a join).
+        ThreadBuffer &buffer()
+        {
+            thread_local std::vector<std::pair<uint64_t, ThreadBuffer *>> owned;
+            for (const auto &[instance, cached] : owned)
+                if (instance == instance_)
+                    return *cached;
+
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            buffers_.push_back(std::make_unique<ThreadBuffer>());
+            ThreadBuffer *created = buffers_.back().get();
+            created->events.resize(std::max<size_t>(1, config_.events_per_thread));
+            created->tid = static_cast<uint32_t>(buffers_.size());
+            owned.emplace_back(instance_, created);
+            return *created;
+        }
+
+        static void put_us(std::string &out, uint64_t ns)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%llu.%03llu", static_cast<unsigned long long>(ns / 1000),
+                          static_cast<unsigned long long>(ns % 1000));
+            out += buf;
+        }
+
+    public:
+        PipelineTracer() : instance_(next_instance()) {}
+
+        PipelineTracer(const PipelineTracer &) = delete;
+        PipelineTracer &operator=(const PipelineTracer &) = delete;
+
+        // Set before any thread records
+        void configure(const TraceConfig &config)
+        {
+            config_ = config;
+            config_.sample_every = std::max<uint64_t>(1, config_.sample_every);
+            enabled_.store(config_.enabled, std::memory_order_release);
+        }
+
+        bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+        // Trace id for a new market update, or 0 if it is not sampled
+        uint64_t begin_trace()
+        {
+            if (!enabled())
+                return 0;
+            uint64_t n = next_id_.fetch_add(1, std::memory_order_relaxed);
+            return n % config_.sample_every == 0 ? n + 1 : 0;
+        }
+
+        void record(TraceStage stage, uint64_t trace_id, uint64_t begin_ns, uint64_t end_ns)
+        {
+            if (trace_id == 0)
+                return;
+            ThreadBuffer &b = buffer();
+            std::lock_guard<std::mutex> lock(b.mutex);
+            TraceEvent &e = b.events[b.head % b.events.size()];
+            e.trace_id = trace_id;
+            e.begin_ns = begin_ns;
+            e.end_ns = end_ns;
+            e.stage = stage;
+            b.head++;
+        }
+
+        // Label the calling thread in exported traces (the first name sticks)
+        void name_thread(const std::string &name)
+        {
+            if (!enabled())
+                return;
+            ThreadBuffer &b = buffer();
+            std::lock_guard<std::mutex> lock(b.mutex);
+            if (b.name.empty())
+                b.name = name;
+        }
+
+        // Everything still in the rings with begin_ns in [from_ns, to_ns], sorted by time;
+        // tids are parallel to the events
+        void collect(std::vector<TraceEvent> &events, std::vector<uint32_t> &tids,
+                     uint64_t from_ns = 0, uint64_t to_ns = UINT64_MAX)
+        {
+            std::lock_guard<std::mutex> registry(registry_mutex_);
+            std::vector<std::pair<TraceEvent, uint32_t>> all;
+            for (auto &b : buffers_)
+            {
+                std::lock_guard<std::mutex> lock(b->mutex);
+                size_t size = b->events.size();
+                uint64_t first = b->head > size ? b->head - size : 0;
+                for (uint64_t i = first; i < b->head; ++i)
+                {
+                    const TraceEvent &e = b->events[i % size];
+                    if (e.begin_ns >= from_ns && e.begin_ns <= to_ns)
+                        all.emplace_back(e, b->tid);
+                }
+            }
+            std::sort(all.begin(), all.end(), [](const auto &a, const auto &b)
+                      { return a.first.begin_ns < b.first.begin_ns; });
+            events.clear();
+            tids.clear();
+            for (const auto &[e, tid] : all)
+            {
+                events.push_back(e);
+                tids.push_back(tid);
+            }
+        }
+
+        // Chrome trace JSON: one complete ("X") event per span, a flow arrow from each
+        // stage of a trace to the next, and thread names. Returns events written, or -1.
+        long write_chrome_trace(const std::string &path, uint64_t from_ns = 0, uint64_t to_ns = UINT64_MAX)
+        {
+            std::vector<TraceEvent> events;
+            std::vector<uint32_t> tids;
+            collect(events, tids, from_ns, to_ns);
+
+            std::FILE *file = std::fopen(path.c_str(), "wb");
+            if (!file)
+                return -1;
+
+            // Timestamps relative to the first event keep the numbers short
+            uint64_t origin = events.empty() ? 0 : events.front().begin_ns;
+            std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+            bool first = true;
+            auto separator = [&]()
+            {
+                if (!first)
+                    out += ",\n";
+                first = false;
+            };
+
+            {
+                std::lock_guard<std::mutex> registry(registry_mutex_);
+                for (auto &b : buffers_)
+                {
+                    std::lock_guard<std::mutex> lock(b->mutex);
+                    separator();
+                    out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(b->tid) +
+                           ",\"args\":{\"name\":\"" + (b->name.empty() ? "thread " + std::to_string(b->tid) : b->name) + "\"}}";
+                }
+            }
+
+            // Last event seen per trace id, for the flow arrows
+            std::unordered_map<uint64_t, size_t> last_of;
+            uint64_t flow_id = 0;
+            for (size_t i = 0; i < events.size(); ++i)
+            {
+                const TraceEvent &e = events[i];
+                separator();
+                out += "{\"name\":\"";
+                out += trace_stage_name(e.stage);
+                out += "\",\"cat\":\"pipeline\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(tids[i]) + ",\"ts\":";
+                put_us(out, e.begin_ns - origin);
+                out += ",\"dur\":";
+                put_us(out, e.end_ns > e.begin_ns ? e.end_ns - e.begin_ns : 0);
+                out += ",\"args\":{\"trace_id\":" + std::to_string(e.trace_id) + "}}";
+
+                auto it = last_of.find(e.trace_id);
+                if (it != last_of.end())
+                {
+                    const TraceEvent &prev = events[it->second];
+                    std::string id = std::to_string(++flow_id);
+                    out += ",\n{\"name\":\"update\",\"cat\":\"flow\",\"ph\":\"s\",\"pid\":1,\"tid\":" +
+                           std::to_string(tids[it->second]) + ",\"id\":" + id + ",\"ts\":";
+                    put_us(out, prev.begin_ns - origin);
+                    out += "},\n{\"name\":\"update\",\"cat\":\"flow\",\"ph\":\"f\",\"bp\":\"e\",\"pid\":1,\"tid\":" +
+                           std::to_string(tids[i]) + ",\"id\":" + id + ",\"ts\":";
+                    put_us(out, e.begin_ns - origin);
+                    out += "}";
+                    it->second = i;
+                }
+                else
+                {
+                    last_of.emplace(e.trace_id, i);
+                }
+
+                if (out.size() > (1 << 20))
+                {
+                    std::fwrite(out.data(), 1, out.size(), file);
+                    out.clear();
+                }
+            }
+            out += "\n]}\n";
+            std::fwrite(out.data(), 1, out.size(), file);
+            std::fclose(file);
+            return static_cast<long>(events.size());
+        }
+    };
+
+} // namespace arbisim
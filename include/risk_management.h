@@ -5,7 +5,10 @@
 #include <chrono>
 #include <algorithm>
 #include <vector>
+#include <iostream>
+#include <string>
 #include "arbisim_core.h"
+#include "risk_pipeline.h"
 
 namespace arbisim
 {
@@ -50,141 +53,200 @@ namespace arbisim
         {
 
             gross_pnl = (sell_price - buy_price) * quantity;
-            fees = calculate_fees(qty, buy_price, sell_price);
+            fees = FeeModel::round_trip_fees(opp, qty);
             net_pnl = gross_pnl - fees;
         }
+    };
 
-    private:
-        double calculate_fees(double qty, double buy_px, double sell_px)
+    // Limits plus account state, as seen by the check policies in risk_pipeline.h
+    struct RiskState
+    {
+        RiskLimits limits;
+
+        std::unordered_map<std::string, Position> positions; // key: exchange_symbol
+        double total_exposure = 0.0;                         // Maintained on every position update
+
+        // Use regular doubles with mutex protection (std::atomic<double> doesn't have fetch_add in all compilers)
+        double daily_pnl = 0.0;
+        double total_pnl = 0.0;
+        double max_balance = 10000.0; // Starting balance
+
+        // Reused for every lookup (callers hold the risk lock), so building a key does
+        // not allocate once it has grown to the longest one
+        mutable std::string key_scratch;
+
+        const std::string &position_key(const std::string &exchange, const std::string &symbol) const
         {
-            // Typical crypto exchange fees: 0.1% per side
-            const double fee_rate = 0.001;
-            return (qty * buy_px + qty * sell_px) * fee_rate;
+            key_scratch.assign(exchange);
+            key_scratch += '_';
+            key_scratch += symbol;
+            return key_scratch;
+        }
+
+        double position_quantity(const std::string &exchange, const std::string &symbol) const
+        {
+            auto it = positions.find(position_key(exchange, symbol));
+            return it != positions.end() ? it->second.quantity : 0.0;
+        }
+
+        double drawdown() const
+        {
+            double current_balance = max_balance + total_pnl;
+            return (max_balance - current_balance) / max_balance;
         }
     };
 
-    // Risk management system
-    class RiskManager
+    // Risk management system. The Pipeline picks which limit checks run, and in what
+    // order; everything else (sizing, batching, execution, reporting) is shared.
+    template <typename Pipeline>
+    class BasicRiskManager
     {
+    public:
+        using RiskDecision = ::arbisim::RiskDecision;
+        using RiskAssessment = ::arbisim::RiskAssessment;
+
     private:
-        // Risk limits - UPDATED TO BE MORE LIBERAL
-        double max_position_size_ = 2.0;       // Max position per exchange (BTC) - increased from 1.0
-        double max_total_exposure_ = 100000.0; // Max total exposure ($) - increased from 5.0 BTC
-        double max_single_trade_size_ = 0.5;   // Max single trade size (BTC) - increased from 0.1
-        double min_profit_after_fees_ = 5.0;   // Min profit after fees (bps) - reduced from 10.0
-        double max_daily_loss_ = 2000.0;       // Max daily loss ($) - increased from 1000.0
-        double max_drawdown_ = 0.10;           // Max 10% drawdown - increased from 0.05
-
-        // Current state - using regular doubles with mutex protection instead of atomic<double>
-        std::unordered_map<std::string, Position> positions_; // key: exchange_symbol
+        RiskState state_;
+        Pipeline pipeline_;
+
         std::vector<Trade> trade_history_;
         std::atomic<uint64_t> next_trade_id_{1};
 
-        // Use regular doubles with mutex protection (std::atomic<double> doesn't have fetch_add in all compilers)
-        double daily_pnl_ = 0.0;
-        double total_pnl_ = 0.0;
-        double max_balance_ = 10000.0; // Starting balance
-
         mutable std::mutex risk_mutex_;
 
-        // Performance tracking
-        std::atomic<uint64_t> opportunities_seen_{0};
-        std::atomic<uint64_t> opportunities_taken_{0};
-        std::atomic<uint64_t> opportunities_rejected_{0};
+        // assess_batch scratch, under risk_mutex_; kept so batches reuse the capacity
+        std::vector<size_t> batch_order_;
+        ReservedPositions batch_reserved_;
 
-    public:
-        // Risk check for arbitrage opportunity
-        enum class RiskDecision
-        {
-            APPROVED = 0,
-            REJECTED_POSITION_LIMIT = 1,
-            REJECTED_EXPOSURE_LIMIT = 2,
-            REJECTED_TRADE_SIZE = 3,
-            REJECTED_PROFIT_TOO_LOW = 4,
-            REJECTED_DAILY_LOSS = 5,
-            REJECTED_DRAWDOWN = 6,
-            REJECTED_EXCHANGE_LIMIT = 7
-        };
+        // Performance tracking, under risk_mutex_ like everything they count
+        uint64_t opportunities_seen_ = 0;
+        uint64_t opportunities_taken_ = 0;
+        uint64_t opportunities_rejected_ = 0;
 
-        struct RiskAssessment
+        // Run the pipeline for one opportunity and fill in the assessment
+        void assess_locked(const ArbitrageOpportunity &opp, RiskContext &ctx, RiskAssessment &assessment)
         {
-            RiskDecision decision = RiskDecision::REJECTED_PROFIT_TOO_LOW;
-            double recommended_size = 0.0;
-            std::string reason;
-            double expected_pnl = 0.0;
-            double fees = 0.0;
-            double net_profit_bps = 0.0;
-        };
+            assessment.net_profit_bps = ctx.net_profit_bps;
+            assessment.decision = pipeline_.evaluate(state_, ctx, assessment.reason);
+
+            if (assessment.decision != RiskDecision::APPROVED)
+            {
+                opportunities_rejected_++;
+                return;
+            }
+
+            // Price the fill at the depth-walk VWAP when we have one: conservative for any
+            // size up to max_quantity
+            double buy_px = opp.buy_vwap > 0.0 ? opp.buy_vwap : opp.buy_price;
+            double sell_px = opp.sell_vwap > 0.0 ? opp.sell_vwap : opp.sell_price;
+
+            assessment.recommended_size = ctx.size;
+            assessment.expected_pnl = (sell_px - buy_px) * ctx.size;
+            assessment.fees = FeeModel::round_trip_fees(opp, ctx.size);
+            assessment.reason = "Trade approved";
+            opportunities_taken_++;
+        }
+
+    public:
+        static constexpr size_t check_count = Pipeline::check_count;
 
         RiskAssessment assess_opportunity(const ArbitrageOpportunity &opp)
         {
             std::lock_guard<std::mutex> lock(risk_mutex_);
-            opportunities_seen_.fetch_add(1);
+            opportunities_seen_++;
 
             RiskAssessment assessment;
+            RiskContext ctx(opp, opp.net_profit_bps, state_.limits.max_single_trade_size);
+            assess_locked(opp, ctx, assessment);
+            return assessment;
+        }
 
-            // Calculate optimal trade size
-            double max_size_by_position = calculate_max_size_by_position(opp);
-            double max_size_by_exposure = calculate_max_size_by_exposure();
-            double recommended_size = std::min({max_single_trade_size_, max_size_by_position, max_size_by_exposure});
-
-            std::cout << "[DEBUG] Position limit: " << max_size_by_position
-                      << ", Exposure limit: " << max_size_by_exposure
-                      << ", Max trade: " << max_single_trade_size_
-                      << ", Final size: " << recommended_size << std::endl;
-
-            if (recommended_size <= 0.001)
-            { // Minimum viable trade size - reduced from 0.001 to 0.01
-                assessment.decision = RiskDecision::REJECTED_TRADE_SIZE;
-                assessment.reason = "Trade size too small: " + std::to_string(recommended_size);
-                return assessment;
-            }
-
-            // Calculate expected P&L after fees
-            Trade simulated_trade(next_trade_id_.load(), opp, recommended_size);
-            assessment.expected_pnl = simulated_trade.gross_pnl;
-            assessment.fees = simulated_trade.fees;
-            assessment.net_profit_bps = (simulated_trade.net_pnl / (recommended_size * opp.buy_price)) * 10000.0;
+        // Batch risk check for every opportunity from one detection pass (or a short window).
+        // Opportunities are run through the pipeline best expected net P&L first (the
+        // opportunity queue's ranking), each approval reserving per-(exchange, symbol)
+        // position and total exposure headroom, so scarce inventory goes to the most
+        // valuable crosses instead of the first ones seen.
+        // Returns one assessment per input opportunity, in input order.
+        std::vector<RiskAssessment> assess_batch(const std::vector<ArbitrageOpportunity> &opps,
+                                                 uint64_t time_budget_ns = 250000)
+        {
+            std::vector<RiskAssessment> assessments;
+            assess_batch(opps, assessments, time_budget_ns);
+            return assessments;
+        }
 
-            std::cout << "[DEBUG] Net profit: " << assessment.net_profit_bps
-                      << " bps, Min required: " << min_profit_after_fees_ << " bps" << std::endl;
+        // Same, into a caller-owned vector; with the scratch below, a steady-state batch
+        // allocates nothing
+        void assess_batch(const std::vector<ArbitrageOpportunity> &opps, std::vector<RiskAssessment> &assessments,
+                          uint64_t time_budget_ns = 250000)
+        {
+            std::lock_guard<std::mutex> lock(risk_mutex_);
+            uint64_t batch_start = timestamp_ns();
+            opportunities_seen_ += opps.size();
 
-            // Check minimum profit threshold
-            if (assessment.net_profit_bps < min_profit_after_fees_)
+            assessments.assign(opps.size(), RiskAssessment());
+            if (opps.empty())
             {
-                assessment.decision = RiskDecision::REJECTED_PROFIT_TOO_LOW;
-                assessment.reason = "Net profit below threshold (" +
-                                    std::to_string(assessment.net_profit_bps) + " < " +
-                                    std::to_string(min_profit_after_fees_) + " bps)";
-                return assessment;
+                return;
             }
 
-            // Check daily loss limit
-            if (daily_pnl_ < -max_daily_loss_)
+            std::vector<size_t> &order = batch_order_;
+            order.resize(opps.size());
+            for (size_t i = 0; i < opps.size(); ++i)
             {
-                assessment.decision = RiskDecision::REJECTED_DAILY_LOSS;
-                assessment.reason = "Daily loss limit exceeded";
-                return assessment;
+                order[i] = i;
             }
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                      { return FeeModel::expected_net_pnl(opps[a]) > FeeModel::expected_net_pnl(opps[b]); });
+
+            // Headroom already promised to better opportunities in this batch
+            ReservedPositions &reserved_position = batch_reserved_;
+            reserved_position.clear();
+            double reserved_exposure = 0.0;
+            auto reserve = [&](const std::string &exchange, const std::string &symbol, double size)
+            {
+                for (auto &entry : reserved_position)
+                {
+                    if (entry.exchange == exchange && entry.symbol == symbol)
+                    {
+                        entry.quantity += size;
+                        return;
+                    }
+                }
+                reserved_position.push_back({exchange, symbol, size});
+            };
 
-            // Check drawdown limit
-            double current_balance = max_balance_ + total_pnl_;
-            double drawdown = (max_balance_ - current_balance) / max_balance_;
-            if (drawdown > max_drawdown_)
+            for (size_t n = 0; n < order.size(); ++n)
             {
-                assessment.decision = RiskDecision::REJECTED_DRAWDOWN;
-                assessment.reason = "Drawdown limit exceeded (" +
-                                    std::to_string(drawdown * 100) + "%)";
-                return assessment;
-            }
+                size_t i = order[n];
+                const auto &opp = opps[i];
 
-            // All checks passed
-            assessment.decision = RiskDecision::APPROVED;
-            assessment.recommended_size = recommended_size;
-            assessment.reason = "Trade approved";
-            opportunities_taken_.fetch_add(1);
+                // Bounded solve, checked before every candidate (the clock read is a few ns
+                // next to a pipeline pass): whatever is left when the budget runs out is not allocated
+                if (timestamp_ns() - batch_start > time_budget_ns)
+                {
+                    for (size_t m = n; m < order.size(); ++m)
+                    {
+                        assessments[order[m]].decision = RiskDecision::REJECTED_BATCH_BUDGET;
+                        assessments[order[m]].reason = "Batch time budget exhausted";
+                        assessments[order[m]].net_profit_bps = opps[order[m]].net_profit_bps;
+                    }
+                    opportunities_rejected_ += order.size() - n;
+                    break;
+                }
 
-            return assessment;
+                RiskContext ctx(opp, opp.net_profit_bps, state_.limits.max_single_trade_size);
+                ctx.reserved_position = &reserved_position;
+                ctx.reserved_exposure = reserved_exposure;
+                assess_locked(opp, ctx, assessments[i]);
+
+                if (assessments[i].decision == RiskDecision::APPROVED)
+                {
+                    reserve(opp.buy_exchange, opp.symbol, ctx.size);
+                    reserve(opp.sell_exchange, opp.symbol, ctx.size);
+                    reserved_exposure += ctx.size * (opp.buy_price + opp.sell_price);
+                }
+            }
         }
 
         // Execute approved trade
@@ -200,14 +262,14 @@ namespace arbisim
             update_position(opp.sell_exchange, opp.symbol, -size, opp.sell_price);
 
             // Update P&L (thread-safe with mutex)
-            daily_pnl_ += trade.net_pnl;
-            total_pnl_ += trade.net_pnl;
+            state_.daily_pnl += trade.net_pnl;
+            state_.total_pnl += trade.net_pnl;
 
             // Update max balance if we have a new high
-            double current_balance = max_balance_ + total_pnl_;
-            if (current_balance > max_balance_)
+            double current_balance = state_.max_balance + state_.total_pnl;
+            if (current_balance > state_.max_balance)
             {
-                max_balance_ = current_balance;
+                state_.max_balance = current_balance;
             }
 
             // Record trade
@@ -216,6 +278,20 @@ namespace arbisim
             return true;
         }
 
+        // Realized P&L that is not a matched trade (e.g. a leg-risk unwind)
+        void record_realized_pnl(double pnl)
+        {
+            std::lock_guard<std::mutex> lock(risk_mutex_);
+            state_.daily_pnl += pnl;
+            state_.total_pnl += pnl;
+
+            double current_balance = state_.max_balance + state_.total_pnl;
+            if (current_balance > state_.max_balance)
+            {
+                state_.max_balance = current_balance;
+            }
+        }
+
         // Risk monitoring and reporting
         struct RiskReport
         {
@@ -230,6 +306,10 @@ namespace arbisim
             uint64_t opportunities_seen = 0;
             uint64_t opportunities_taken = 0;
             double take_rate = 0.0;
+
+            // Rejections per pipeline check, in pipeline order
+            std::array<const char *, Pipeline::check_count> check_names = Pipeline::check_names;
+            std::array<uint64_t, Pipeline::check_count> check_rejections{};
         };
 
         RiskReport generate_report() const
@@ -237,25 +317,23 @@ namespace arbisim
             std::lock_guard<std::mutex> lock(risk_mutex_);
 
             RiskReport report;
-            report.daily_pnl = daily_pnl_;
-            report.total_pnl = total_pnl_;
+            report.daily_pnl = state_.daily_pnl;
+            report.total_pnl = state_.total_pnl;
             report.total_trades = trade_history_.size();
-            report.opportunities_seen = opportunities_seen_.load();
-            report.opportunities_taken = opportunities_taken_.load();
+            report.opportunities_seen = opportunities_seen_;
+            report.opportunities_taken = opportunities_taken_;
+            report.total_exposure = state_.total_exposure;
+            report.check_rejections = pipeline_.rejection_counts();
 
-            // Calculate exposure
-            for (const auto &[key, pos] : positions_)
+            for (const auto &[key, pos] : state_.positions)
             {
-                report.total_exposure += std::abs(pos.quantity * pos.avg_price);
                 if (std::abs(pos.quantity) > 0.001)
                 {
                     report.active_positions++;
                 }
             }
 
-            // Calculate drawdown
-            double current_balance = max_balance_ + total_pnl_;
-            report.current_drawdown = (max_balance_ - current_balance) / max_balance_;
+            report.current_drawdown = state_.drawdown();
 
             // Calculate performance metrics
             if (report.total_trades > 0)
@@ -282,17 +360,33 @@ namespace arbisim
             return report;
         }
 
+        // Snapshot of open positions (for scenario revaluation)
+        std::vector<Position> get_positions() const
+        {
+            std::lock_guard<std::mutex> lock(risk_mutex_);
+
+            std::vector<Position> open_positions;
+            for (const auto &[key, pos] : state_.positions)
+            {
+                if (std::abs(pos.quantity) > 0.001)
+                {
+                    open_positions.push_back(pos);
+                }
+            }
+            return open_positions;
+        }
+
         // Configuration
         void set_risk_limits(double max_pos, double max_exp, double max_trade,
                              double min_profit, double max_loss, double max_dd)
         {
             std::lock_guard<std::mutex> lock(risk_mutex_);
-            max_position_size_ = max_pos;
-            max_total_exposure_ = max_exp;
-            max_single_trade_size_ = max_trade;
-            min_profit_after_fees_ = min_profit;
-            max_daily_loss_ = max_loss;
-            max_drawdown_ = max_dd;
+            state_.limits.max_position_size = max_pos;
+            state_.limits.max_total_exposure = max_exp;
+            state_.limits.max_single_trade_size = max_trade;
+            state_.limits.min_profit_after_fees = min_profit;
+            state_.limits.max_daily_loss = max_loss;
+            state_.limits.max_drawdown = max_dd;
 
             std::cout << "[DEBUG] Risk limits updated - Max pos: " << max_pos
                       << ", Max exp: $" << max_exp
@@ -300,151 +394,41 @@ namespace arbisim
                       << ", Min profit: " << min_profit << " bps" << std::endl;
         }
 
+        void set_risk_limits(const RiskLimits &limits)
+        {
+            std::lock_guard<std::mutex> lock(risk_mutex_);
+            state_.limits = limits;
+        }
+
         void reset_daily_pnl()
         {
             std::lock_guard<std::mutex> lock(risk_mutex_);
-            daily_pnl_ = 0.0;
+            state_.daily_pnl = 0.0;
         }
         void reset_all_positions()
         {
             std::lock_guard<std::mutex> lock(risk_mutex_);
 
             std::cout << "[RESET] Clearing all positions and trade history..." << std::endl;
-            std::cout << "[RESET] Before reset - Total positions: " << positions_.size()
+            std::cout << "[RESET] Before reset - Total positions: " << state_.positions.size()
                       << ", Total trades: " << trade_history_.size() << std::endl;
 
-            positions_.clear();
+            state_.positions.clear();
+            state_.total_exposure = 0.0;
             trade_history_.clear();
-            daily_pnl_ = 0.0;
-            total_pnl_ = 0.0;
+            state_.daily_pnl = 0.0;
+            state_.total_pnl = 0.0;
             next_trade_id_.store(1);
+            pipeline_.reset_counters();
 
             std::cout << "[RESET] ✅ All positions reset. Starting fresh!" << std::endl;
         }
 
     private:
-        double calculate_max_size_by_position(const ArbitrageOpportunity &opp)
-        {
-            std::cout << "[DEBUG] === Position Calculation Start ===" << std::endl;
-            std::cout << "[DEBUG] Max position size limit: " << max_position_size_ << " BTC" << std::endl;
-
-            // Check position limits on both exchanges
-            std::string buy_key = opp.buy_exchange + "_" + opp.symbol;
-            std::string sell_key = opp.sell_exchange + "_" + opp.symbol;
-
-            std::cout << "[DEBUG] Buy key: '" << buy_key << "', Sell key: '" << sell_key << "'" << std::endl;
-            std::cout << "[DEBUG] Total positions in map: " << positions_.size() << std::endl;
-
-            double buy_current = 0.0;
-            double sell_current = 0.0;
-
-            auto buy_it = positions_.find(buy_key);
-            if (buy_it != positions_.end())
-            {
-                buy_current = std::abs(buy_it->second.quantity);
-                std::cout << "[DEBUG] Found existing buy position: " << buy_current << " BTC" << std::endl;
-            }
-            else
-            {
-                std::cout << "[DEBUG] No existing buy position found" << std::endl;
-            }
-
-            auto sell_it = positions_.find(sell_key);
-            if (sell_it != positions_.end())
-            {
-                sell_current = std::abs(sell_it->second.quantity);
-                std::cout << "[DEBUG] Found existing sell position: " << sell_current << " BTC" << std::endl;
-            }
-            else
-            {
-                std::cout << "[DEBUG] No existing sell position found" << std::endl;
-            }
-
-            std::cout << "[DEBUG] Buy exchange (" << opp.buy_exchange << ") current: " << buy_current
-                      << " BTC, Sell exchange (" << opp.sell_exchange << ") current: " << sell_current << " BTC" << std::endl;
-
-            // Calculate available size for each exchange
-            double max_buy_size = max_position_size_ - buy_current;
-            double max_sell_size = max_position_size_ - sell_current;
-
-            std::cout << "[DEBUG] Calculation: max_buy_size = " << max_position_size_ << " - " << buy_current << " = " << max_buy_size << std::endl;
-            std::cout << "[DEBUG] Calculation: max_sell_size = " << max_position_size_ << " - " << sell_current << " = " << max_sell_size << std::endl;
-
-            // Take the minimum of the two
-            double recommended_size = std::min(max_buy_size, max_sell_size);
-
-            std::cout << "[DEBUG] min(" << max_buy_size << ", " << max_sell_size << ") = " << recommended_size << std::endl;
-
-            // If calculated size is negative or too small, still allow minimum trade
-            if (recommended_size <= 0.0)
-            {
-                std::cout << "[DEBUG] Position limits exceeded, allowing minimum trade" << std::endl;
-                return 0.01; // Allow minimum viable trade
-            }
-
-            // Ensure we have at least minimum viable size
-            double final_result = std::max(recommended_size, 0.01);
-            std::cout << "[DEBUG] Final position limit result: " << final_result << " BTC" << std::endl;
-            std::cout << "[DEBUG] === Position Calculation End ===" << std::endl;
-
-            return final_result;
-        }
-
-        double calculate_max_size_by_exposure()
-        {
-            std::cout << "[DEBUG] === Exposure Calculation Start ===" << std::endl;
-            std::cout << "[DEBUG] Max total exposure limit: $" << max_total_exposure_ << std::endl;
-
-            double current_exposure = 0.0;
-
-            // Calculate current exposure from all positions
-            std::cout << "[DEBUG] Checking " << positions_.size() << " positions for exposure calculation:" << std::endl;
-
-            for (const auto &[key, pos] : positions_)
-            {
-                double position_exposure = std::abs(pos.quantity * pos.avg_price);
-                current_exposure += position_exposure;
-                std::cout << "[DEBUG]   Position '" << key << "': " << pos.quantity << " @ $" << pos.avg_price
-                          << " = $" << position_exposure << " exposure" << std::endl;
-            }
-
-            std::cout << "[DEBUG] Total current exposure: $" << current_exposure
-                      << ", Max allowed: $" << max_total_exposure_ << std::endl;
-
-            double remaining_exposure = max_total_exposure_ - current_exposure;
-
-            std::cout << "[DEBUG] Remaining exposure: $" << max_total_exposure_ << " - $" << current_exposure
-                      << " = $" << remaining_exposure << std::endl;
-
-            // If we have negative remaining exposure, allow minimum trade
-            if (remaining_exposure <= 0.0)
-            {
-                std::cout << "[DEBUG] Exposure limit exceeded, allowing minimum trade" << std::endl;
-                return 0.01; // Allow minimum viable trade even if over exposure limit
-            }
-
-            // Convert remaining dollar exposure to BTC size
-            double btc_price = 50000.0; // Rough estimate
-            double btc_size = remaining_exposure / btc_price;
-
-            std::cout << "[DEBUG] Converting to BTC: $" << remaining_exposure << " / $" << btc_price
-                      << " = " << btc_size << " BTC" << std::endl;
-
-            // Ensure minimum viable size, but cap at reasonable maximum
-            double final_result = std::max(std::min(btc_size, 10.0), 0.001);
-
-            std::cout << "[DEBUG] Final exposure limit result: max(min(" << btc_size << ", 2.0), 0.01) = "
-                      << final_result << " BTC" << std::endl;
-            std::cout << "[DEBUG] === Exposure Calculation End ===" << std::endl;
-
-            return final_result;
-        }
-
         void update_position(const std::string &exchange, const std::string &symbol,
                              double quantity, double price)
         {
-            std::string key = exchange + "_" + symbol;
-            auto &pos = positions_[key];
+            auto &pos = state_.positions[state_.position_key(exchange, symbol)];
 
             if (pos.exchange.empty())
             {
@@ -452,6 +436,8 @@ namespace arbisim
                 pos.symbol = symbol;
             }
 
+            double old_exposure = std::abs(pos.quantity * pos.avg_price);
+
             // Update average price and quantity
             if ((pos.quantity > 0 && quantity > 0) || (pos.quantity < 0 && quantity < 0))
             {
@@ -465,20 +451,28 @@ namespace arbisim
             }
             else
             {
-                // Different direction - reduce position or flip
+                // Different direction - reduce position, flip, or open from flat
+                bool was_flat = std::abs(pos.quantity) < 0.001;
                 pos.quantity += quantity;
                 if (std::abs(pos.quantity) < 0.001)
                 {
                     pos.avg_price = 0.0; // Position closed
                 }
-                else if ((pos.quantity > 0 && quantity < 0) || (pos.quantity < 0 && quantity > 0))
+                else if (was_flat || (pos.quantity > 0 && quantity > 0) || (pos.quantity < 0 && quantity < 0))
                 {
-                    pos.avg_price = price; // Position flipped
+                    pos.avg_price = price; // Position opened or flipped
                 }
             }
 
+            state_.total_exposure += std::abs(pos.quantity * pos.avg_price) - old_exposure;
             pos.last_update_ns = timestamp_ns();
         }
     };
 
-} // namespace arbisim
\ No newline at end of file
+    // Full limit set: profit, daily loss, drawdown, trade size, exchange and exposure limits
+    using RiskManager = BasicRiskManager<FullRiskPipeline>;
+
+    // Ultra-fast mode: profit and size checks only
+    using SimpleRiskManager = BasicRiskManager<FastRiskPipeline>;
+
+} // namespace arbisim
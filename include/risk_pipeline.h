@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "arbisim_core.h"
+
+namespace arbisim
+{
+
+    // Risk decision codes (values are written to the CSV log, keep them stable)
+    enum class RiskDecision
+    {
+        APPROVED = 0,
+        REJECTED_POSITION_LIMIT = 1,
+        REJECTED_EXPOSURE_LIMIT = 2,
+        REJECTED_TRADE_SIZE = 3,
+        REJECTED_PROFIT_TOO_LOW = 4,
+        REJECTED_DAILY_LOSS = 5,
+        REJECTED_DRAWDOWN = 6,
+        REJECTED_EXCHANGE_LIMIT = 7,
+        REJECTED_BATCH_BUDGET = 8,
+        REJECTED_LIQUIDITY = 9
+    };
+
+    struct RiskAssessment
+    {
+        RiskDecision decision = RiskDecision::REJECTED_PROFIT_TOO_LOW;
+        double recommended_size = 0.0;
+        const char *reason = ""; // Static string, no allocation on the hot path
+        double expected_pnl = 0.0;
+        double fees = 0.0;
+        double net_profit_bps = 0.0;
+    };
+
+    static constexpr double MIN_TRADE_SIZE = 0.001;
+
+    // Fee model shared by checks, sizing and trade records. Fee rates come from the
+    // opportunity, which carries each leg's taker fee from the detector's fee schedule.
+    struct FeeModel
+    {
+        static double round_trip_fees(const ArbitrageOpportunity &opp, double qty)
+        {
+            return qty * (opp.buy_price * opp.buy_fee_bps + opp.sell_price * opp.sell_fee_bps) / 10000.0;
+        }
+
+        // Expected P&L after fees if the full profitable depth were taken; the ranking
+        // score for both the opportunity queue and batch allocation
+        static double expected_net_pnl(const ArbitrageOpportunity &opp)
+        {
+            double qty = opp.max_quantity > 0.0 ? opp.max_quantity : MIN_TRADE_SIZE;
+            double buy_px = opp.buy_vwap > 0.0 ? opp.buy_vwap : opp.buy_price;
+            double sell_px = opp.sell_vwap > 0.0 ? opp.sell_vwap : opp.sell_price;
+            return (sell_px - buy_px) * qty - round_trip_fees(opp, qty);
+        }
+    };
+
+    struct RiskLimits
+    {
+        double max_position_size = 2.0;       // Max position per exchange (BTC)
+        double max_total_exposure = 100000.0; // Max total exposure ($)
+        double max_single_trade_size = 0.5;   // Max single trade size (BTC)
+        double min_profit_after_fees = 5.0;   // Min profit after fees (bps)
+        double max_daily_loss = 2000.0;       // Max daily loss ($)
+        double max_drawdown = 0.10;           // Max drawdown (fraction of peak balance)
+    };
+
+    // Position already reserved per (exchange, symbol) by earlier approvals in a batch,
+    // matching the positions the limits are checked against. A batch touches a handful
+    // of venues and symbols, so a flat list the caller clears and reuses keeps the
+    // lookups cheap where a map would allocate a node per entry per batch.
+    struct ReservedPosition
+    {
+        std::string exchange;
+        std::string symbol;
+        double quantity = 0.0;
+    };
+    using ReservedPositions = std::vector<ReservedPosition>;
+
+    // Per-opportunity working state threaded through the checks. Sizing checks only ever
+    // shrink `size`; batch callers pass in what earlier opportunities already reserved.
+    struct RiskContext
+    {
+        const ArbitrageOpportunity &opp;
+        double net_profit_bps = 0.0;
+        double size = 0.0;
+        const ReservedPositions *reserved_position = nullptr;
+        double reserved_exposure = 0.0;
+
+        RiskContext(const ArbitrageOpportunity &o, double net_bps, double max_size)
+            : opp(o), net_profit_bps(net_bps), size(max_size) {}
+
+        double reserved(const std::string &exchange, const std::string &symbol) const
+        {
+            if (!reserved_position)
+                return 0.0;
+            for (const auto &entry : *reserved_position)
+                if (entry.exchange == exchange && entry.symbol == symbol)
+                    return entry.quantity;
+            return 0.0;
+        }
+    };
+
+    // Check policies. Each is a stateless struct with a static pass() against the risk
+    // state; the pipeline inlines them in declaration order, so put frequent, cheap
+    // rejections first and leave out checks a configuration never needs.
+
+    struct MinProfitCheck
+    {
+        static constexpr RiskDecision code = RiskDecision::REJECTED_PROFIT_TOO_LOW;
+        static constexpr const char *name = "min_profit";
+        static constexpr const char *reason = "Net profit below threshold";
+
+        template <typename State>
+        static bool pass(const State &state, RiskContext &ctx)
+        {
+            return ctx.net_profit_bps >= state.limits.min_profit_after_fees;
+        }
+    };
+
+    struct DailyLossCheck
+    {
+        static constexpr RiskDecision code = RiskDecision::REJECTED_DAILY_LOSS;
+        static constexpr const char *name = "daily_loss";
+        static constexpr const char *reason = "Daily loss limit exceeded";
+
+        template <typename State>
+        static bool pass(const State &state, RiskContext &)
+        {
+            return state.daily_pnl >= -state.limits.max_daily_loss;
+        }
+    };
+
+    struct DrawdownCheck
+    {
+        static constexpr RiskDecision code = RiskDecision::REJECTED_DRAWDOWN;
+        static constexpr const char *name = "drawdown";
+        static constexpr const char *reason = "Drawdown limit exceeded";
+
+        template <typename State>
+        static bool pass(const State &state, RiskContext &)
+        {
+            return state.drawdown() <= state.limits.max_drawdown;
+        }
+    };
+
+    // Per-exchange position limits on both legs
+    struct ExchangeLimitCheck
+    {
+        static constexpr RiskDecision code = RiskDecision::REJECTED_EXCHANGE_LIMIT;
+        static constexpr const char *name = "exchange_limit";
+        static constexpr const char *reason = "Exchange position limit reached";
+
+        template <typename State>
+        static bool pass(const State &state, RiskContext &ctx)
+        {
+            double buy_headroom = state.limits.max_position_size -
+                                  std::abs(state.position_quantity(ctx.opp.buy_exchange, ctx.opp.symbol)) -
+                                  ctx.reserved(ctx.opp.buy_exchange, ctx.opp.symbol);
+            double sell_headroom = state.limits.max_position_size -
+                                   std::abs(state.position_quantity(ctx.opp.sell_exchange, ctx.opp.symbol)) -
+                                   ctx.reserved(ctx.opp.sell_exchange, ctx.opp.symbol);
+            ctx.size = std::min({ctx.size, buy_headroom, sell_headroom});
+            return ctx.size > MIN_TRADE_SIZE;
+        }
+    };
+
+    // Total dollar exposure; a trade adds notional on both legs
+    struct ExposureCheck
+    {
+        static constexpr RiskDecision code = RiskDecision::REJECTED_EXPOSURE_LIMIT;
+        static constexpr const char *name = "exposure";
+        static constexpr const char *reason = "Total exposure limit reached";
+
+        template <typename State>
+        static bool pass(const State &state, RiskContext &ctx)
+        {
+            double headroom = state.limits.max_total_exposure - state.total_exposure - ctx.reserved_exposure;
+            ctx.size = std::min(ctx.size, headroom / (ctx.opp.buy_price + ctx.opp.sell_price));
+            return ctx.size > MIN_TRADE_SIZE;
+        }
+    };
+
+    // Book depth at which the cross still clears fees (from the detector's depth walk)
+    struct LiquidityCheck
+    {
+        static constexpr RiskDecision code = RiskDecision::REJECTED_LIQUIDITY;
+        static constexpr const char *name = "liquidity";
+        static constexpr const char *reason = "Not enough profitable book depth";
+
+        template <typename State>
+        static bool pass(const State &, RiskContext &ctx)
+        {
+            ctx.size = std::min(ctx.size, ctx.opp.max_quantity);
+            return ctx.size > MIN_TRADE_SIZE;
+        }
+    };
+
+    struct TradeSizeCheck
+    {
+        static constexpr RiskDecision code = RiskDecision::REJECTED_TRADE_SIZE;
+        static constexpr const char *name = "trade_size";
+        static constexpr const char *reason = "Trade size too small";
+
+        template <typename State>
+        static bool pass(const State &state, RiskContext &ctx)
+        {
+            ctx.size = std::min(ctx.size, state.limits.max_single_trade_size);
+            return ctx.size > MIN_TRADE_SIZE;
+        }
+    };
+
+    // Compile-time composed risk pipeline: runs Checks... in order, stops at the first
+    // rejection and counts rejections per check. No virtual dispatch; unused checks are
+    // simply not part of the type.
+    template <typename... Checks>
+    class RiskPipeline
+    {
+    public:
+        static constexpr size_t check_count = sizeof...(Checks);
+
+        template <typename Check>
+        static constexpr bool has = (std::is_same_v<Check, Checks> || ...);
+
+        static constexpr std::array<const char *, check_count> check_names = {Checks::name...};
+
+        template <typename State>
+        RiskDecision evaluate(const State &state, RiskContext &ctx, const char *&reason)
+        {
+            RiskDecision decision = RiskDecision::APPROVED;
+            evaluate_impl(state, ctx, decision, reason, std::index_sequence_for<Checks...>{});
+            return decision;
+        }
+
+        std::array<uint64_t, check_count> rejection_counts() const
+        {
+            std::array<uint64_t, check_count> counts{};
+            for (size_t i = 0; i < check_count; ++i)
+            {
+                counts[i] = rejections_[i].load(std::memory_order_relaxed);
+            }
+            return counts;
+        }
+
+        void reset_counters()
+        {
+            for (auto &counter : rejections_)
+            {
+                counter.store(0, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, check_count> rejections_{};
+
+        template <typename State, size_t... Is>
+        void evaluate_impl(const State &state, RiskContext &ctx, RiskDecision &decision,
+                           const char *&reason, std::index_sequence<Is...>)
+        {
+            // Short-circuits on the first failing check
+            (void)(run_check<Is, Checks>(state, ctx, decision, reason) && ...);
+        }
+
+        template <size_t I, typename Check, typename State>
+        bool run_check(const State &state, RiskContext &ctx, RiskDecision &decision, const char *&reason)
+        {
+            if (Check::pass(state, ctx))
+            {
+                return true;
+            }
+            rejections_[I].fetch_add(1, std::memory_order_relaxed);
+            decision = Check::code;
+            reason = Check::reason;
+            return false;
+        }
+    };
+
+    // Full limits, cheapest and most frequent rejections first
+    using FullRiskPipeline = RiskPipeline<MinProfitCheck, DailyLossCheck, DrawdownCheck,
+                                          TradeSizeCheck, LiquidityCheck, ExchangeLimitCheck, ExposureCheck>;
+
+    // Ultra-fast mode: profit, size and available depth only
+    using FastRiskPipeline = RiskPipeline<MinProfitCheck, TradeSizeCheck, LiquidityCheck>;
+
+} // namespace arbisim
@@ -0,0 +1,213 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include "arbisim_core.h"
+#include "thread_pool.h"
+
+namespace arbisim
+{
+
+    // One position as seen by the scenario engine, marked at the current venue price
+    struct ScenarioPosition
+    {
+        std::string exchange;
+        std::string symbol;
+        double quantity = 0.0; // Positive = long, negative = short
+        double mark_price = 0.0;
+    };
+
+    struct VaRReport
+    {
+        double var_99 = 0.0; // Losses are reported as positive dollars
+        double es_99 = 0.0;
+        double var_975 = 0.0;
+        double es_975 = 0.0;
+        double worst_loss = 0.0;
+        double mean_pnl = 0.0;
+        size_t paths = 0;
+        size_t risk_factors = 0;
+        uint64_t compute_ns = 0;
+        uint64_t computed_at_ns = 0;
+    };
+
+    // Monte Carlo stress engine: correlated log-price shocks across venues and symbols,
+    // full revaluation of every position per path, VaR/ES from the simulated P&L.
+    // Paths are split into chunks on a work-stealing pool; each chunk keeps its shocks in
+    // factor-major blocks so the revaluation loop runs over contiguous path arrays.
+    class ScenarioEngine
+    {
+    private:
+        static constexpr size_t PATH_BLOCK = 256;
+
+        WorkStealingPool &pool_;
+        size_t num_paths_ = 10000;
+        double horizon_sec_ = 60.0;
+        double annual_volatility_ = 0.60;   // Typical BTC annualised vol
+        double venue_correlation_ = 0.98;  // Same symbol on different venues
+        double symbol_correlation_ = 0.60; // Different symbols
+        uint64_t seed_ = 20240101;
+
+        std::vector<double> pnl_;
+
+        // Lower-triangular Cholesky factor of the factor correlation matrix (row-major).
+        // Falls back to the diagonal if the matrix is not positive definite.
+        static std::vector<double> cholesky(const std::vector<double> &corr, size_t n)
+        {
+            std::vector<double> l(n * n, 0.0);
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t j = 0; j <= i; ++j)
+                {
+                    double sum = corr[i * n + j];
+                    for (size_t k = 0; k < j; ++k)
+                    {
+                        sum -= l[i * n + k] * l[j * n + k];
+                    }
+
+                    if (i == j)
+                    {
+                        if (sum <= 0.0)
+                        {
+                            std::vector<double> diag(n * n, 0.0);
+                            for (size_t d = 0; d < n; ++d)
+                                diag[d * n + d] = 1.0;
+                            return diag;
+                        }
+                        l[i * n + i] = std::sqrt(sum);
+                    }
+                    else
+                    {
+                        l[i * n + j] = sum / l[j * n + j];
+                    }
+                }
+            }
+            return l;
+        }
+
+    public:
+        explicit ScenarioEngine(WorkStealingPool &pool) : pool_(pool) {}
+
+        void set_paths(size_t paths) { num_paths_ = std::max<size_t>(100, paths); }
+        void set_horizon_seconds(double seconds) { horizon_sec_ = seconds; }
+        void set_volatility(double annual_vol) { annual_volatility_ = annual_vol; }
+        void set_correlations(double venue_corr, double symbol_corr)
+        {
+            venue_correlation_ = venue_corr;
+            symbol_correlation_ = symbol_corr;
+        }
+        void set_seed(uint64_t seed) { seed_ = seed; }
+
+        VaRReport run(const std::vector<ScenarioPosition> &positions)
+        {
+            uint64_t start = timestamp_ns();
+            VaRReport report;
+            report.paths = num_paths_;
+
+            // Risk factors are the non-flat positions; each one carries its own dollar exposure
+            std::vector<ScenarioPosition> factors;
+            for (const auto &pos : positions)
+            {
+                if (std::abs(pos.quantity) > 1e-9 && pos.mark_price > 0.0)
+                {
+                    factors.push_back(pos);
+                }
+            }
+            size_t n = factors.size();
+            report.risk_factors = n;
+            if (n == 0)
+            {
+                report.compute_ns = timestamp_ns() - start;
+                report.computed_at_ns = timestamp_ns();
+                return report;
+            }
+
+            std::vector<double> corr(n * n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t j = 0; j < n; ++j)
+                {
+                    if (i == j)
+                        corr[i * n + j] = 1.0;
+                    else if (factors[i].symbol == factors[j].symbol)
+                        corr[i * n + j] = venue_correlation_;
+                    else
+                        corr[i * n + j] = symbol_correlation_;
+                }
+            }
+            const std::vector<double> chol = cholesky(corr, n);
+
+            std::vector<double> exposure(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                exposure[i] = factors[i].quantity * factors[i].mark_price;
+            }
+
+            const double seconds_per_year = 365.0 * 24.0 * 3600.0;
+            const double sigma = annual_volatility_ * std::sqrt(horizon_sec_ / seconds_per_year);
+            const double drift = -0.5 * sigma * sigma;
+
+            pnl_.assign(num_paths_, 0.0);
+            size_t num_blocks = (num_paths_ + PATH_BLOCK - 1) / PATH_BLOCK;
+
+            pool_.parallel_for(num_blocks, 1, [&](size_t block_begin, size_t block_end)
+                               {
+                // Factor-major scratch: z[f * PATH_BLOCK + p]
+                std::vector<double> z(n * PATH_BLOCK);
+                std::vector<double> shock(PATH_BLOCK);
+
+                for (size_t block = block_begin; block < block_end; ++block) {
+                    std::mt19937_64 gen(seed_ + block * 0x9E3779B97F4A7C15ULL);
+                    std::normal_distribution<double> normal(0.0, 1.0);
+
+                    size_t first = block * PATH_BLOCK;
+                    size_t count = std::min(PATH_BLOCK, num_paths_ - first);
+                    double *pnl = pnl_.data() + first;
+
+                    for (auto &v : z) v = normal(gen);
+
+                    for (size_t i = 0; i < n; ++i) {
+                        // Correlate: shock_i = sum_k L[i][k] * z_k
+                        std::fill(shock.begin(), shock.begin() + count, 0.0);
+                        for (size_t k = 0; k <= i; ++k) {
+                            const double l_ik = chol[i * n + k];
+                            const double *zk = z.data() + k * PATH_BLOCK;
+                            for (size_t p = 0; p < count; ++p) shock[p] += l_ik * zk[p];
+                        }
+
+                        // Revalue: position value moves by exposure * (exp(return) - 1)
+                        const double exp_i = exposure[i];
+                        for (size_t p = 0; p < count; ++p) {
+                            pnl[p] += exp_i * std::expm1(drift + sigma * shock[p]);
+                        }
+                    }
+                } });
+
+            report.mean_pnl = std::accumulate(pnl_.begin(), pnl_.end(), 0.0) / num_paths_;
+
+            // Tail statistics from the sorted loss side only
+            auto tail = [&](double confidence, double &var, double &es)
+            {
+                size_t tail_count = std::max<size_t>(1, static_cast<size_t>(num_paths_ * (1.0 - confidence)));
+                std::nth_element(pnl_.begin(), pnl_.begin() + (tail_count - 1), pnl_.end());
+                var = -pnl_[tail_count - 1];
+                double tail_sum = 0.0;
+                for (size_t i = 0; i < tail_count; ++i)
+                    tail_sum += pnl_[i];
+                es = -tail_sum / tail_count;
+            };
+
+            tail(0.975, report.var_975, report.es_975);
+            tail(0.99, report.var_99, report.es_99);
+            report.worst_loss = -*std::min_element(pnl_.begin(), pnl_.end());
+
+            report.compute_ns = timestamp_ns() - start;
+            report.computed_at_ns = timestamp_ns();
+            return report;
+        }
+    };
+
+} // namespace arbisim
@@ -0,0 +1,452 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(ARBISIM_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#include <immintrin.h>
+#define ARBISIM_HAVE_X86_SIMD 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#define ARBISIM_TARGET_AVX2
+#define ARBISIM_FLATTEN
+#define ARBISIM_ALWAYS_INLINE __forceinline
+#define ARBISIM_UNROLL
+#else
+#define ARBISIM_TARGET_AVX2 __attribute__((target("avx2")))
+#define ARBISIM_FLATTEN __attribute__((flatten))
+#define ARBISIM_ALWAYS_INLINE inline __attribute__((always_inline))
+#define ARBISIM_UNROLL _Pragma("GCC unroll 8") // Fixed-count vector loops: keep them in registers
+#endif
+#endif
+#ifndef ARBISIM_ALWAYS_INLINE
+#define ARBISIM_ALWAYS_INLINE inline
+#endif
+
+namespace arbisim
+{
+    // Kernels over a book side's structure-of-arrays levels: price search, level insert,
+    // erase and replace, and the cumulative-quantity prefix sum, in AVX2, SSE2 and scalar forms. The widest
+    // form the CPU supports is picked once at runtime (SSE2 is baseline on x86-64); other
+    // targets, or builds with ARBISIM_NO_SIMD, always run scalar. Search and moves give
+    // identical results on every path; prefix sums agree to rounding. A side is only a
+    // few vectors long, so the kernels are forced inline into a caller that dispatches
+    // once (see the kernel sets at the end).
+    namespace simd
+    {
+        enum class Level
+        {
+            SCALAR = 0,
+            SSE2 = 1,
+            AVX2 = 2
+        };
+
+        inline const char *level_name(Level level)
+        {
+            switch (level)
+            {
+            case Level::AVX2:
+                return "avx2";
+            case Level::SSE2:
+                return "sse2";
+            default:
+                return "scalar";
+            }
+        }
+
+        inline Level detect_level()
+        {
+#ifdef ARBISIM_HAVE_X86_SIMD
+#ifdef _MSC_VER
+            int regs[4];
+            __cpuid(regs, 1);
+            bool os_avx = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+            __cpuidex(regs, 7, 0);
+            if (os_avx && (regs[1] & (1 << 5)))
+                return Level::AVX2;
+#else
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return Level::AVX2;
+#endif
+            return Level::SSE2;
+#else
+            return Level::SCALAR;
+#endif
+        }
+
+        inline std::atomic<int> selected_level{-1}; // Detected on first use
+
+        inline Level active_level()
+        {
+            int level = selected_level.load(std::memory_order_relaxed);
+            if (level < 0)
+            {
+                level = static_cast<int>(detect_level());
+                selected_level.store(level, std::memory_order_relaxed);
+            }
+            return static_cast<Level>(level);
+        }
+
+        // Force a narrower path (tests, benchmarks); clamped to what the CPU supports
+        inline Level set_level(Level level)
+        {
+            int chosen = std::min(static_cast<int>(level), static_cast<int>(detect_level()));
+            selected_level.store(chosen, std::memory_order_relaxed);
+            return static_cast<Level>(chosen);
+        }
+
+        inline unsigned lowest_bit(unsigned mask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+
+        // Kernels work on one side's fixed arrays of N slots (N a multiple of 4); slots at
+        // or past the side's count are padding, which the vector forms read and may
+        // overwrite. The vector forms load and store the arrays only in whole aligned
+        // vectors: a load that straddles, or is wider than, an earlier store still in the
+        // store buffer misses store forwarding, and consecutive updates to one side would
+        // otherwise stall on each other's writes.
+
+        // First i < count where the level at i is `price` or worse than it (so `price`
+        // belongs at or before i): prices[i] <= price on bids, >= on asks. count if none.
+        template <bool Bids>
+        ARBISIM_ALWAYS_INLINE size_t find_level_scalar(const double *prices, size_t count, double price)
+        {
+            for (size_t i = 0; i < count; ++i)
+                if (Bids ? prices[i] <= price : prices[i] >= price)
+                    return i;
+            return count;
+        }
+
+        // Move [at, end) up one slot and put value at `at`
+        template <size_t N, typename T>
+        ARBISIM_ALWAYS_INLINE void insert_scalar(T *values, size_t at, size_t end, T value)
+        {
+            for (size_t j = end; j > at; --j)
+                values[j] = values[j - 1];
+            values[at] = value;
+        }
+
+        // Move [at + 1, count) down one slot, over `at`
+        template <size_t N, typename T>
+        ARBISIM_ALWAYS_INLINE void erase_scalar(T *values, size_t at, size_t count)
+        {
+            for (size_t j = at; j + 1 < count; ++j)
+                values[j] = values[j + 1];
+        }
+
+        template <size_t N, typename T>
+        ARBISIM_ALWAYS_INLINE void replace_scalar(T *values, size_t at, T value)
+        {
+            values[at] = value;
+        }
+
+        // cum[i] = cum[i - 1] + qty[i] for i in [from, count)
+        template <size_t N>
+        ARBISIM_ALWAYS_INLINE void prefix_sum_scalar(const double *qty, double *cum, size_t from, size_t count)
+        {
+            double running = from > 0 ? cum[from - 1] : 0.0;
+            for (size_t i = from; i < count; ++i)
+            {
+                running += qty[i];
+                cum[i] = running;
+            }
+        }
+
+#ifdef ARBISIM_HAVE_X86_SIMD
+        // 8-byte values travel in double lanes bit for bit
+        template <typename T>
+        inline double lane_bits(T value)
+        {
+            static_assert(sizeof(T) == sizeof(double), "8-byte lanes");
+            double bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        template <bool Bids>
+        ARBISIM_TARGET_AVX2 inline size_t find_level_avx2(const double *prices, size_t count, double price)
+        {
+            const __m256d target = _mm256_set1_pd(price);
+            for (size_t i = 0; i < count; i += 4)
+            {
+                __m256d levels = _mm256_load_pd(prices + i);
+                __m256d hit = Bids ? _mm256_cmp_pd(levels, target, _CMP_LE_OQ) : _mm256_cmp_pd(levels, target, _CMP_GE_OQ);
+                unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(hit));
+                if (mask)
+                {
+                    size_t index = i + lowest_bit(mask);
+                    return index < count ? index : count;
+                }
+            }
+            return count;
+        }
+
+        template <bool Bids>
+        ARBISIM_ALWAYS_INLINE size_t find_level_sse2(const double *prices, size_t count, double price)
+        {
+            const __m128d target = _mm_set1_pd(price);
+            for (size_t i = 0; i < count; i += 2)
+            {
+                __m128d levels = _mm_load_pd(prices + i);
+                __m128d hit = Bids ? _mm_cmple_pd(levels, target) : _mm_cmpge_pd(levels, target);
+                unsigned mask = static_cast<unsigned>(_mm_movemask_pd(hit));
+                if (mask)
+                {
+                    size_t index = i + lowest_bit(mask);
+                    return index < count ? index : count;
+                }
+            }
+            return count;
+        }
+
+        // Lane indices of vector k, compared against a slot with the integer compares
+        ARBISIM_TARGET_AVX2 inline __m256i lane_index_avx2(size_t k)
+        {
+            return _mm256_add_epi64(_mm256_set_epi64x(3, 2, 1, 0), _mm256_set1_epi64x(static_cast<long long>(4 * k)));
+        }
+
+        // Every slot j > at takes slot j - 1 (the neighbour lane comes from the vector
+        // below, still in a register) and `at` takes value, over the vectors up to the one
+        // holding `end`; those wholly below `at` are rewritten unchanged. The trip count is
+        // bounded by N so the loop unrolls and nothing spills.
+        template <size_t N, typename T>
+        ARBISIM_TARGET_AVX2 inline void insert_avx2(T *values, size_t at, size_t end, T value)
+        {
+            static_assert(N % 4 == 0, "whole vectors");
+            double *v = reinterpret_cast<double *>(values);
+            const __m256i slot = _mm256_set1_epi64x(static_cast<long long>(at));
+            const __m256d fill = _mm256_set1_pd(lane_bits(value));
+            __m256d below = _mm256_setzero_pd();
+            ARBISIM_UNROLL
+            for (size_t k = 0; k < N / 4; ++k)
+            {
+                if (4 * k > end)
+                    break;
+                __m256d kept = _mm256_load_pd(v + 4 * k);
+                __m256d moved = _mm256_blend_pd(_mm256_permute4x64_pd(kept, 0x90), // [below3, x0, x1, x2]
+                                                _mm256_permute4x64_pd(below, 0xFF), 0x1);
+                __m256i index = lane_index_avx2(k);
+                __m256d out = _mm256_blendv_pd(kept, moved, _mm256_castsi256_pd(_mm256_cmpgt_epi64(index, slot)));
+                _mm256_store_pd(v + 4 * k, _mm256_blendv_pd(out, fill, _mm256_castsi256_pd(_mm256_cmpeq_epi64(index, slot))));
+                below = kept;
+            }
+        }
+
+        // Every slot j >= at takes slot j + 1, over the vectors holding [0, count); the
+        // vector above is loaded before the one below it is stored
+        template <size_t N, typename T>
+        ARBISIM_TARGET_AVX2 inline void erase_avx2(T *values, size_t at, size_t count)
+        {
+            static_assert(N % 4 == 0, "whole vectors");
+            double *v = reinterpret_cast<double *>(values);
+            const __m256i slot = _mm256_set1_epi64x(static_cast<long long>(at) - 1);
+            __m256d above = _mm256_load_pd(v);
+            ARBISIM_UNROLL
+            for (size_t k = 0; k < N / 4; ++k)
+            {
+                if (4 * k >= count)
+                    break;
+                __m256d kept = above;
+                if (k + 1 < N / 4)
+                    above = _mm256_load_pd(v + 4 * k + 4);
+                __m256d moved = _mm256_blend_pd(_mm256_permute4x64_pd(kept, 0xF9), // [x1, x2, x3, above0]
+                                                _mm256_permute4x64_pd(above, 0x00), 0x8);
+                __m256d mask = _mm256_castsi256_pd(_mm256_cmpgt_epi64(lane_index_avx2(k), slot));
+                _mm256_store_pd(v + 4 * k, _mm256_blendv_pd(kept, moved, mask));
+            }
+        }
+
+        template <size_t N, typename T>
+        ARBISIM_TARGET_AVX2 inline void replace_avx2(T *values, size_t at, T value)
+        {
+            double *v = reinterpret_cast<double *>(values) + at / 4 * 4;
+            __m256d mask = _mm256_castsi256_pd(
+                _mm256_cmpeq_epi64(lane_index_avx2(0), _mm256_set1_epi64x(static_cast<long long>(at % 4))));
+            _mm256_store_pd(v, _mm256_blendv_pd(_mm256_load_pd(v), _mm256_set1_pd(lane_bits(value)), mask));
+        }
+
+        // In-register prefix sum of four lanes (two shifted adds) plus the running total,
+        // from the vector holding `from` through the one holding count - 1
+        template <size_t N>
+        ARBISIM_TARGET_AVX2 inline void prefix_sum_avx2(const double *qty, double *cum, size_t from, size_t count)
+        {
+            const __m256d zero = _mm256_setzero_pd();
+            size_t i = from / 4 * 4;
+            __m256d carry = _mm256_set1_pd(i > 0 ? cum[i - 1] : 0.0);
+            for (; i < count; i += 4)
+            {
+                __m256d v = _mm256_load_pd(qty + i);
+                v = _mm256_add_pd(v, _mm256_blend_pd(_mm256_permute4x64_pd(v, 0x90), zero, 0x1)); // + [0, a, b, c]
+                v = _mm256_add_pd(v, _mm256_blend_pd(_mm256_permute4x64_pd(v, 0x40), zero, 0x3)); // + [0, 0, a, a+b]
+                v = _mm256_add_pd(v, carry);
+                _mm256_store_pd(cum + i, v);
+                carry = _mm256_permute4x64_pd(v, 0xFF);
+            }
+        }
+
+        // SSE2 has no 64-bit integer compare, so lane indices are compared as doubles
+        inline __m128d select_sse2(__m128d mask, __m128d if_set, __m128d if_clear)
+        {
+            return _mm_or_pd(_mm_and_pd(mask, if_set), _mm_andnot_pd(mask, if_clear));
+        }
+
+        inline __m128d lane_index_sse2(size_t k)
+        {
+            return _mm_set_pd(static_cast<double>(2 * k + 1), static_cast<double>(2 * k));
+        }
+
+        template <size_t N, typename T>
+        ARBISIM_ALWAYS_INLINE void insert_sse2(T *values, size_t at, size_t end, T value)
+        {
+            static_assert(N % 2 == 0, "whole vectors");
+            double *v = reinterpret_cast<double *>(values);
+            const __m128d slot = _mm_set1_pd(static_cast<double>(at));
+            const __m128d fill = _mm_set1_pd(lane_bits(value));
+            __m128d below = _mm_setzero_pd();
+            ARBISIM_UNROLL
+            for (size_t k = 0; k < N / 2; ++k)
+            {
+                if (2 * k > end)
+                    break;
+                __m128d kept = _mm_load_pd(v + 2 * k);
+                __m128d moved = _mm_shuffle_pd(below, kept, 0x1); // [below1, x0]
+                __m128d index = lane_index_sse2(k);
+                __m128d out = select_sse2(_mm_cmpgt_pd(index, slot), moved, kept);
+                _mm_store_pd(v + 2 * k, select_sse2(_mm_cmpeq_pd(index, slot), fill, out));
+                below = kept;
+            }
+        }
+
+        template <size_t N, typename T>
+        ARBISIM_ALWAYS_INLINE void erase_sse2(T *values, size_t at, size_t count)
+        {
+            static_assert(N % 2 == 0, "whole vectors");
+            double *v = reinterpret_cast<double *>(values);
+            const __m128d slot = _mm_set1_pd(static_cast<double>(at));
+            __m128d above = _mm_load_pd(v);
+            ARBISIM_UNROLL
+            for (size_t k = 0; k < N / 2; ++k)
+            {
+                if (2 * k >= count)
+                    break;
+                __m128d kept = above;
+                if (k + 1 < N / 2)
+                    above = _mm_load_pd(v + 2 * k + 2);
+                __m128d moved = _mm_shuffle_pd(kept, above, 0x1); // [x1, above0]
+                _mm_store_pd(v + 2 * k, select_sse2(_mm_cmpge_pd(lane_index_sse2(k), slot), moved, kept));
+            }
+        }
+
+        template <size_t N, typename T>
+        ARBISIM_ALWAYS_INLINE void replace_sse2(T *values, size_t at, T value)
+        {
+            double *v = reinterpret_cast<double *>(values) + at / 2 * 2;
+            __m128d fill = _mm_set1_pd(lane_bits(value));
+            __m128d old = _mm_load_pd(v);
+            _mm_store_pd(v, at % 2 ? _mm_unpacklo_pd(old, fill) : _mm_shuffle_pd(fill, old, 0x2));
+        }
+
+        template <size_t N>
+        ARBISIM_ALWAYS_INLINE void prefix_sum_sse2(const double *qty, double *cum, size_t from, size_t count)
+        {
+            size_t i = from / 2 * 2;
+            __m128d carry = _mm_set1_pd(i > 0 ? cum[i - 1] : 0.0);
+            for (; i < count; i += 2)
+            {
+                __m128d v = _mm_load_pd(qty + i);
+                v = _mm_add_pd(v, _mm_unpacklo_pd(_mm_setzero_pd(), v)); // + [0, a]
+                v = _mm_add_pd(v, carry);
+                _mm_store_pd(cum + i, v);
+                carry = _mm_unpackhi_pd(v, v);
+            }
+        }
+#endif
+
+        // Kernel sets, passed as a template argument: code instantiated with one runs that
+        // form throughout, so callers dispatch on active_level() once per operation rather
+        // than once per kernel
+        struct ScalarKernels
+        {
+            template <bool Bids>
+            static ARBISIM_ALWAYS_INLINE size_t find_level(const double *prices, size_t count, double price)
+            {
+                return find_level_scalar<Bids>(prices, count, price);
+            }
+            template <size_t N, typename T>
+            static ARBISIM_ALWAYS_INLINE void insert(T *values, size_t at, size_t end, T value)
+            {
+                insert_scalar<N>(values, at, end, value);
+            }
+            template <size_t N, typename T>
+            static ARBISIM_ALWAYS_INLINE void erase(T *values, size_t at, size_t count) { erase_scalar<N>(values, at, count); }
+            template <size_t N, typename T>
+            static ARBISIM_ALWAYS_INLINE void replace(T *values, size_t at, T value) { replace_scalar<N>(values, at, value); }
+            template <size_t N>
+            static ARBISIM_ALWAYS_INLINE void prefix_sum(const double *qty, double *cum, size_t from, size_t count)
+            {
+                prefix_sum_scalar<N>(qty, cum, from, count);
+            }
+        };
+
+#ifdef ARBISIM_HAVE_X86_SIMD
+        struct Sse2Kernels
+        {
+            template <bool Bids>
+            static ARBISIM_ALWAYS_INLINE size_t find_level(const double *prices, size_t count, double price)
+            {
+                return find_level_sse2<Bids>(prices, count, price);
+            }
+            template <size_t N, typename T>
+            static ARBISIM_ALWAYS_INLINE void insert(T *values, size_t at, size_t end, T value)
+            {
+                insert_sse2<N>(values, at, end, value);
+            }
+            template <size_t N, typename T>
+            static ARBISIM_ALWAYS_INLINE void erase(T *values, size_t at, size_t count) { erase_sse2<N>(values, at, count); }
+            template <size_t N, typename T>
+            static ARBISIM_ALWAYS_INLINE void replace(T *values, size_t at, T value) { replace_sse2<N>(values, at, value); }
+            template <size_t N>
+            static ARBISIM_ALWAYS_INLINE void prefix_sum(const double *qty, double *cum, size_t from, size_t count)
+            {
+                prefix_sum_sse2<N>(qty, cum, from, count);
+            }
+        };
+
+        // Only call from code compiled for AVX2 (ARBISIM_TARGET_AVX2); GCC will not force
+        // these inline into anything else, so that caller flattens them in instead
+        struct Avx2Kernels
+        {
+            template <bool Bids>
+            ARBISIM_TARGET_AVX2 static size_t find_level(const double *prices, size_t count, double price)
+            {
+                return find_level_avx2<Bids>(prices, count, price);
+            }
+            template <size_t N, typename T>
+            ARBISIM_TARGET_AVX2 static void insert(T *values, size_t at, size_t end, T value)
+            {
+                insert_avx2<N>(values, at, end, value);
+            }
+            template <size_t N, typename T>
+            ARBISIM_TARGET_AVX2 static void erase(T *values, size_t at, size_t count) { erase_avx2<N>(values, at, count); }
+            template <size_t N, typename T>
+            ARBISIM_TARGET_AVX2 static void replace(T *values, size_t at, T value) { replace_avx2<N>(values, at, value); }
+            template <size_t N>
+            ARBISIM_TARGET_AVX2 static void prefix_sum(const double *qty, double *cum, size_t from, size_t count)
+            {
+                prefix_sum_avx2<N>(qty, cum, from, count);
+            }
+        };
+#endif
+    } // namespace simd
+
+} // namespace arbisim
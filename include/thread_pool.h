@@ -0,0 +1,215 @@
+#pragma once
+#include <thread>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace arbisim
+{
+
+    // Work-stealing thread pool for CPU-bound batch jobs (scenario runs, sweeps, scans).
+    // Each worker owns a deque: it pops its own work LIFO for cache warmth and steals
+    // FIFO from the others when it runs dry, so uneven chunks still keep every core busy.
+    class WorkStealingPool
+    {
+    private:
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues_;
+        std::vector<std::thread> workers_;
+        std::atomic<bool> running_{true};
+        std::atomic<size_t> next_queue_{0};
+        std::atomic<size_t> pending_{0}; // Submitted but not finished
+        std::atomic<size_t> queued_{0};  // Submitted but not started
+
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cv_;
+        std::condition_variable idle_cv_;
+
+        static size_t &worker_index()
+        {
+            static thread_local size_t index = SIZE_MAX;
+            return index;
+        }
+
+        bool pop_task(size_t self, std::function<void()> &task)
+        {
+            // Own queue first (back), then steal from the front of the others
+            {
+                auto &own = *queues_[self];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.tasks.empty())
+                {
+                    task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    queued_.fetch_sub(1);
+                    return true;
+                }
+            }
+
+            for (size_t n = 1; n < queues_.size(); ++n)
+            {
+                auto &victim = *queues_[(self + n) % queues_.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty())
+                {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    queued_.fetch_sub(1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void run_task(std::function<void()> &task)
+        {
+            task();
+            if (pending_.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                idle_cv_.notify_all();
+            }
+        }
+
+        void worker_loop(size_t self)
+        {
+            worker_index() = self;
+            std::function<void()> task;
+
+            while (running_.load())
+            {
+                if (pop_task(self, task))
+                {
+                    run_task(task);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_cv_.wait(lock, [this]()
+                              { return !running_.load() || queued_.load() > 0; });
+            }
+        }
+
+    public:
+        explicit WorkStealingPool(size_t num_threads = 0)
+        {
+            if (num_threads == 0)
+            {
+                num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+            }
+
+            for (size_t i = 0; i < num_threads; ++i)
+            {
+                queues_.push_back(std::make_unique<WorkerQueue>());
+            }
+            for (size_t i = 0; i < num_threads; ++i)
+            {
+                workers_.emplace_back([this, i]()
+                                      { worker_loop(i); });
+            }
+        }
+
+        ~WorkStealingPool()
+        {
+            running_.store(false);
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                wake_cv_.notify_all();
+            }
+            for (auto &worker : workers_)
+            {
+                if (worker.joinable())
+                    worker.join();
+            }
+        }
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        size_t thread_count() const { return workers_.size(); }
+
+        // Queue a task; tasks submitted from a worker go to that worker's own deque
+        void submit(std::function<void()> task)
+        {
+            size_t target = worker_index();
+            if (target >= queues_.size())
+            {
+                target = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+            }
+
+            pending_.fetch_add(1);
+            {
+                auto &queue = *queues_[target];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+                queued_.fetch_add(1);
+            }
+
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            wake_cv_.notify_one();
+        }
+
+        // Block until every submitted task has finished
+        void wait_idle()
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            idle_cv_.wait(lock, [this]()
+                          { return pending_.load() == 0; });
+        }
+
+        // Run fn(begin, end) over [0, count) in chunks of `grain` and wait for all of them
+        template <typename Fn>
+        void parallel_for(size_t count, size_t grain, Fn fn)
+        {
+            if (count == 0)
+                return;
+            grain = std::max<size_t>(1, grain);
+
+            size_t num_chunks = (count + grain - 1) / grain;
+            auto remaining = std::make_shared<std::atomic<size_t>>(num_chunks);
+            auto done_mutex = std::make_shared<std::mutex>();
+            auto done_cv = std::make_shared<std::condition_variable>();
+
+            for (size_t begin = 0; begin < count; begin += grain)
+            {
+                size_t end = std::min(count, begin + grain);
+                submit([=]()
+                       {
+                    fn(begin, end);
+                    if (remaining->fetch_sub(1) == 1) {
+                        std::lock_guard<std::mutex> lock(*done_mutex);
+                        done_cv->notify_all();
+                    } });
+            }
+
+            // The caller helps out instead of just blocking, so nested calls cannot starve the pool
+            std::function<void()> task;
+            while (remaining->load() > 0)
+            {
+                size_t self = std::min(worker_index(), queues_.size() - 1);
+                if (pop_task(self, task))
+                {
+                    run_task(task);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(*done_mutex);
+                done_cv->wait_for(lock, std::chrono::microseconds(100), [&]()
+                                  { return remaining->load() == 0; });
+            }
+        }
+    };
+
+} // namespace arbisim
@@ -0,0 +1,238 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include "cache_line.h"
+
+#if !defined(ARBISIM_NO_TSC) && defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ARBISIM_HAVE_TSC 1
+#elif !defined(ARBISIM_NO_TSC) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define ARBISIM_HAVE_TSC 1
+#endif
+
+namespace arbisim
+{
+
+    // Epoch ns from the system clock: the reference the TSC is calibrated against
+    inline uint64_t wall_clock_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::high_resolution_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    // Epoch ns from the CPU's invariant TSC: one rdtsc and a multiply per read instead of
+    // a clock_gettime. Calibrated against the system clock at startup, then re-anchored
+    // about once a second by whichever reader notices the interval has passed. Drift found
+    // at a re-anchor is slewed out over the next interval (rate change capped at 0.1%), so
+    // readings stay monotonic and within microseconds of wall time; only a jump beyond
+    // STEP_NS (the system clock being set) is applied as a step. Without an invariant TSC,
+    // or built with ARBISIM_NO_TSC, every read goes to the system clock.
+    class alignas(CACHE_LINE_SIZE) TscClock
+    {
+    public:
+        static constexpr uint64_t CALIBRATION_NS = 2000000ULL;   // Startup calibration spin
+        static constexpr uint64_t RECALIBRATE_NS = 1000000000ULL; // Re-anchor interval
+        static constexpr uint64_t STEP_NS = 50000000ULL;         // Larger errors are stepped, not slewed
+        static constexpr double MAX_SLEW = 1e-3;
+
+    private:
+        // Conversion published to readers: ns = base_ns + (tsc - base_tsc) * ns_per_cycle
+        struct Anchor
+        {
+            uint64_t base_tsc = 0;
+            uint64_t base_ns = 0;
+            double ns_per_cycle = 1.0;
+        };
+
+        // What every read touches, on one line that only a re-anchor writes
+        bool tsc_ = false;
+        int64_t recalibrate_cycles_ = INT64_MAX;
+
+        // Seqlock over the anchor: odd while the single writer is mid-update
+        std::atomic<uint32_t> seq_{0};
+        std::atomic<uint64_t> base_tsc_{0};
+        std::atomic<uint64_t> base_ns_{0};
+        std::atomic<double> ns_per_cycle_{1.0};
+
+        // Calibration state, written by whichever reader re-anchors
+        alignas(CACHE_LINE_SIZE) std::mutex calibration_mutex_;
+        uint64_t origin_tsc_ = 0; // First calibration sample, for the long-baseline rate
+        uint64_t origin_ns_ = 0;
+        std::atomic<uint64_t> recalibrations_{0};
+        std::atomic<uint64_t> steps_{0};
+
+        static bool invariant_tsc()
+        {
+#if defined(ARBISIM_HAVE_TSC) && defined(_MSC_VER)
+            int regs[4];
+            __cpuid(regs, 0x80000000);
+            if (static_cast<unsigned>(regs[0]) < 0x80000007u)
+                return false;
+            __cpuid(regs, 0x80000007);
+            return (regs[3] & (1 << 8)) != 0;
+#elif defined(ARBISIM_HAVE_TSC)
+            unsigned eax, ebx, ecx, edx;
+            if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+                return false;
+            return (edx & (1u << 8)) != 0;
+#else
+            return false;
+#endif
+        }
+
+        // One (tsc, wall) pair; the tightest of a few bracketed reads, so a preemption
+        // between the two clocks does not skew it
+        static void sample(uint64_t &tsc, uint64_t &wall)
+        {
+            uint64_t best = UINT64_MAX;
+            for (int i = 0; i < 5; ++i)
+            {
+                uint64_t before = read_tsc();
+                uint64_t ns = wall_clock_ns();
+                uint64_t after = read_tsc();
+                if (after - before < best)
+                {
+                    best = after - before;
+                    tsc = before + (after - before) / 2;
+                    wall = ns;
+                }
+            }
+        }
+
+        Anchor load() const
+        {
+            Anchor a;
+            for (;;)
+            {
+                uint32_t seq = seq_.load(std::memory_order_acquire);
+                if (seq & 1)
+                    continue;
+                a.base_tsc = base_tsc_.load(std::memory_order_relaxed);
+                a.base_ns = base_ns_.load(std::memory_order_relaxed);
+                a.ns_per_cycle = ns_per_cycle_.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq_.load(std::memory_order_relaxed) == seq)
+                    return a;
+            }
+        }
+
+        // Caller holds calibration_mutex_ (or is the constructor)
+        void publish(const Anchor &a)
+        {
+            uint32_t seq = seq_.load(std::memory_order_relaxed);
+            seq_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            base_tsc_.store(a.base_tsc, std::memory_order_relaxed);
+            base_ns_.store(a.base_ns, std::memory_order_relaxed);
+            ns_per_cycle_.store(a.ns_per_cycle, std::memory_order_relaxed);
+            seq_.store(seq + 2, std::memory_order_release);
+        }
+
+        static uint64_t convert(const Anchor &a, uint64_t tsc)
+        {
+            int64_t cycles = static_cast<int64_t>(tsc - a.base_tsc);
+            return a.base_ns + static_cast<uint64_t>(static_cast<int64_t>(static_cast<double>(cycles) * a.ns_per_cycle));
+        }
+
+        TscClock()
+        {
+            if (!invariant_tsc())
+                return;
+
+            sample(origin_tsc_, origin_ns_);
+            uint64_t tsc = 0, wall = 0;
+            do
+            {
+                sample(tsc, wall);
+            } while (wall - origin_ns_ < CALIBRATION_NS);
+
+            // Sanity: 100 MHz to 20 GHz, else trust the system clock instead
+            double ns_per_cycle = static_cast<double>(wall - origin_ns_) / static_cast<double>(tsc - origin_tsc_);
+            if (!(ns_per_cycle > 0.05 && ns_per_cycle < 10.0))
+                return;
+
+            publish({tsc, wall, ns_per_cycle});
+            recalibrate_cycles_ = static_cast<int64_t>(RECALIBRATE_NS / ns_per_cycle);
+            tsc_ = true;
+        }
+
+        void recalibrate()
+        {
+            std::unique_lock<std::mutex> lock(calibration_mutex_, std::try_to_lock);
+            if (!lock.owns_lock())
+                return; // Another reader is on it
+
+            Anchor current = load();
+            uint64_t tsc = 0, wall = 0;
+            sample(tsc, wall);
+            if (static_cast<int64_t>(tsc - current.base_tsc) < recalibrate_cycles_)
+                return; // Done while we waited
+
+            // Rate over everything since startup, plus a bounded correction that brings
+            // our reading back onto wall time by the next re-anchor
+            uint64_t ours = convert(current, tsc);
+            double error_ns = static_cast<double>(wall) - static_cast<double>(ours);
+            double rate = static_cast<double>(wall - origin_ns_) / static_cast<double>(tsc - origin_tsc_);
+            if (std::fabs(error_ns) > static_cast<double>(STEP_NS))
+            {
+                publish({tsc, wall, rate});
+                steps_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                double slew = std::clamp(error_ns / static_cast<double>(RECALIBRATE_NS), -MAX_SLEW, MAX_SLEW);
+                publish({tsc, ours, rate * (1.0 + slew)});
+            }
+            recalibrations_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    public:
+        TscClock(const TscClock &) = delete;
+        TscClock &operator=(const TscClock &) = delete;
+
+        // Process-wide clock, calibrated on first use (a CALIBRATION_NS spin)
+        static TscClock &instance()
+        {
+            static TscClock clock;
+            return clock;
+        }
+
+        static uint64_t read_tsc()
+        {
+#ifdef ARBISIM_HAVE_TSC
+            return __rdtsc();
+#else
+            return 0;
+#endif
+        }
+
+        uint64_t now_ns()
+        {
+            if (!tsc_)
+                return wall_clock_ns();
+            uint64_t tsc = read_tsc();
+            Anchor a = load();
+            if (static_cast<int64_t>(tsc - a.base_tsc) >= recalibrate_cycles_)
+            {
+                recalibrate();
+                a = load();
+            }
+            return convert(a, tsc);
+        }
+
+        bool uses_tsc() const { return tsc_; }
+        double ghz() const { return tsc_ ? 1.0 / load().ns_per_cycle : 0.0; }
+        uint64_t recalibrations() const { return recalibrations_.load(std::memory_order_relaxed); }
+        uint64_t steps() const { return steps_.load(std::memory_order_relaxed); }
+    };
+
+    static_assert(alignof(TscClock) == CACHE_LINE_SIZE, "the anchor every read touches must start a cache line");
+
+} // namespace arbisim
@@ -8,206 +8,125 @@
 
 #include "arbisim_core.h"
 #include "multi_exchange_feeds.h"
-
-#ifdef HAVE_BOOST
 #include "risk_management.h"
-#endif
+#include "scenario_engine.h"
+#include "execution_simulator.h"
+#include "backtester.h"
+#include "opportunity_queue.h"
+#include "conflating_queue.h"
+#include "async_log_writer.h"
+#include "columnar_log.h"
+#include "dashboard_server.h"
+#include "latency_histogram.h"
+#include "pipeline_trace.h"
+#include "metrics_registry.h"
+#include "metrics_server.h"
+#include "load_generator.h"
+#include "alloc_tracker.h"
 
 namespace arbisim
 {
 
-#ifndef HAVE_BOOST
-    // Simplified risk management when Boost is not available
-    class SimpleRiskManager
-    {
-    private:
-        double max_trade_size_ = 0.5; // Increased from 0.1 to 0.5 BTC
-        double min_profit_bps_ = 5.0; // Reduced from 8.0 to 5.0 bps
-        std::atomic<uint64_t> opportunities_seen_{0};
-        std::atomic<uint64_t> opportunities_taken_{0};
-        std::atomic<double> daily_pnl_{0.0};
-
-    public:
-        enum class Decision
-        {
-            APPROVED = 0, // Set explicit values for CSV logging
-            REJECTED_PROFIT = 1,
-            REJECTED_SIZE = 2
-        };
-
-        struct Assessment
-        {
-            Decision decision = Decision::REJECTED_PROFIT;
-            double recommended_size = 0.0;
-            std::string reason;
-            double net_profit_bps = 0.0;
-        };
-
-        Assessment assess_opportunity(const ArbitrageOpportunity &opp)
-        {
-            opportunities_seen_.fetch_add(1);
-
-            Assessment assessment;
-
-            // Calculate net profit after fees (0.1% per side = 20 bps total)
-            double fees_bps = 20.0;
-            assessment.net_profit_bps = opp.profit_bps - fees_bps;
-
-            std::cout << "[DEBUG] Gross: " << opp.profit_bps << " bps, Fees: " << fees_bps
-                      << " bps, Net: " << assessment.net_profit_bps << " bps, Min Required: "
-                      << min_profit_bps_ << " bps" << std::endl;
-
-            if (assessment.net_profit_bps < min_profit_bps_)
-            {
-                assessment.decision = Decision::REJECTED_PROFIT;
-                assessment.reason = "Net profit below threshold (" +
-                                    std::to_string(assessment.net_profit_bps) + " < " +
-                                    std::to_string(min_profit_bps_) + " bps)";
-                return assessment;
-            }
-
-            // Set recommended size
-            assessment.recommended_size = max_trade_size_;
-
-            // Double check size is reasonable
-            if (assessment.recommended_size < 0.001)
-            {
-                assessment.decision = Decision::REJECTED_SIZE;
-                assessment.reason = "Recommended trade size too small: " + std::to_string(assessment.recommended_size);
-                return assessment;
-            }
-
-            // All checks passed
-            assessment.decision = Decision::APPROVED;
-            assessment.reason = "Trade approved";
-            opportunities_taken_.fetch_add(1);
-
-            // Simulate P&L
-            double gross_pnl = (opp.sell_price - opp.buy_price) * assessment.recommended_size;
-            double fees = (assessment.recommended_size * opp.buy_price + assessment.recommended_size * opp.sell_price) * 0.001;
-            // daily_pnl_.fetch_add(gross_pnl - fees);
-            double expected = daily_pnl_.load();
-            while (!daily_pnl_.compare_exchange_weak(expected, expected + (gross_pnl - fees)))
-            {
-                // Keep trying until we successfully update the value
-            }
-
-            std::cout << "[DEBUG] APPROVED: Size=" << assessment.recommended_size
-                      << " BTC, Expected P&L=$" << (gross_pnl - fees) << std::endl;
-
-            return assessment;
-        }
-
-        struct Report
-        {
-            uint64_t opportunities_seen = 0;
-            uint64_t opportunities_taken = 0;
-            double take_rate = 0.0;
-            double daily_pnl = 0.0;
-            double total_exposure = 0.0;
-            size_t active_positions = 0;
-            double current_drawdown = 0.0;
-            double win_rate = 0.0;
-        };
-
-        Report generate_report() const
-        {
-            Report report;
-            report.opportunities_seen = opportunities_seen_.load();
-            report.opportunities_taken = opportunities_taken_.load();
-            report.daily_pnl = daily_pnl_.load();
-
-            if (report.opportunities_seen > 0)
-            {
-                report.take_rate = static_cast<double>(report.opportunities_taken) / report.opportunities_seen;
-            }
-
-            // Simulate some additional metrics for display
-            report.total_exposure = report.opportunities_taken * 0.5 * 50000.0; // Rough estimate
-            report.active_positions = std::min(report.opportunities_taken, uint64_t(8));
-            report.current_drawdown = 0.02; // 2% simulated drawdown
-            report.win_rate = 0.85;         // 85% simulated win rate
-
-            return report;
-        }
-
-        // Add method to adjust thresholds
-        void set_risk_limits(double max_trade, double min_profit)
-        {
-            max_trade_size_ = max_trade;
-            min_profit_bps_ = min_profit;
-
-            std::cout << "[DEBUG] Risk limits updated: Max trade=" << max_trade_size_
-                      << " BTC, Min profit=" << min_profit_bps_ << " bps" << std::endl;
-        }
-    };
-
-    using RiskManagerType = SimpleRiskManager;
-#else
+    // One risk pipeline for both build modes; only the set of checks differs
+#ifdef HAVE_BOOST
     using RiskManagerType = RiskManager;
+#else
+    using RiskManagerType = SimpleRiskManager;
 #endif
 
     class UltraFastPerformanceTracker
     {
     private:
-        std::atomic<uint64_t> total_updates_{0};
-        std::atomic<uint64_t> total_latency_ns_{0};
-        std::atomic<uint64_t> min_latency_ns_{UINT64_MAX};
-        std::atomic<uint64_t> max_latency_ns_{0};
-        std::atomic<uint64_t> arbitrage_opportunities_{0};
-        std::atomic<uint64_t> trades_executed_{0};
+        // Each recording thread writes its own shard; reports aggregate on demand
+        MetricsRegistry &metrics_;
+        uint32_t updates_;
+        uint32_t latency_sum_ns_;
+        uint32_t opportunities_;
+        uint32_t trades_;
+        uint32_t latency_;
+
+        // Readers drain the latency histogram into the interval view (since the last
+        // print_stats) and the session view
+        mutable std::mutex report_mutex_;
+        LatencyHistogram drained_;
+        LatencyHistogram interval_latency_;
+        LatencyHistogram session_latency_;
 
         uint64_t start_time_ns_;
 
+        // Move what was recorded since the last drain into the interval and session views
+        void drain_latency()
+        {
+            drained_.reset();
+            metrics_.drain_histogram(latency_, drained_);
+            interval_latency_.merge(drained_);
+            session_latency_.merge(drained_);
+        }
+
     public:
-        UltraFastPerformanceTracker() : start_time_ns_(timestamp_ns()) {}
+        explicit UltraFastPerformanceTracker(MetricsRegistry &metrics)
+            : metrics_(metrics), updates_(metrics.counter("updates")),
+              latency_sum_ns_(metrics.counter("update_latency_ns_sum")),
+              opportunities_(metrics.counter("opportunities")), trades_(metrics.counter("trades_executed")),
+              latency_(metrics.histogram("update_latency_ns")), start_time_ns_(timestamp_ns()) {}
 
         void record_update_latency(uint64_t latency_ns)
         {
-            total_updates_.fetch_add(1);
-            total_latency_ns_.fetch_add(latency_ns);
-
-            // Fast atomic min/max updates
-            uint64_t current_min = min_latency_ns_.load(std::memory_order_relaxed);
-            while (latency_ns < current_min &&
-                   !min_latency_ns_.compare_exchange_weak(current_min, latency_ns, std::memory_order_relaxed))
-            {
-            }
-
-            uint64_t current_max = max_latency_ns_.load(std::memory_order_relaxed);
-            while (latency_ns > current_max &&
-                   !max_latency_ns_.compare_exchange_weak(current_max, latency_ns, std::memory_order_relaxed))
-            {
-            }
+            MetricsShard &shard = metrics_.local();
+            shard.add(updates_);
+            shard.add(latency_sum_ns_, latency_ns);
+            shard.record(latency_, latency_ns);
         }
 
         void record_arbitrage_opportunity()
         {
-            arbitrage_opportunities_.fetch_add(1, std::memory_order_relaxed);
+            metrics_.add(opportunities_);
         }
 
         void record_trade_executed()
         {
-            trades_executed_.fetch_add(1, std::memory_order_relaxed);
+            metrics_.add(trades_);
+        }
+
+        uint64_t opportunity_count() const { return metrics_.counter_value(opportunities_); }
+
+        uint64_t avg_latency_ns() const
+        {
+            uint64_t updates = metrics_.counter_value(updates_);
+            return updates > 0 ? metrics_.counter_value(latency_sum_ns_) / updates : 0;
         }
 
-        void print_stats() const
+        // Whole-session latency distribution, including anything recorded since the last report
+        LatencyHistogram session_latency()
         {
-            uint64_t updates = total_updates_.load();
+            std::lock_guard<std::mutex> lock(report_mutex_);
+            drain_latency();
+            return session_latency_;
+        }
+
+        // Session percentiles, plus the tail since the previous call (the stats interval)
+        void print_stats()
+        {
+            uint64_t updates = metrics_.counter_value(updates_);
             if (updates == 0)
             {
                 std::cout << "No updates processed yet." << std::endl;
                 return;
             }
 
+            std::lock_guard<std::mutex> lock(report_mutex_);
+            drain_latency();
+            const LatencyHistogram &session = session_latency_;
+            LatencyHistogram interval = interval_latency_;
+            interval_latency_.reset();
+
             uint64_t runtime_ns = timestamp_ns() - start_time_ns_;
             double runtime_sec = runtime_ns / 1e9;
 
-            uint64_t avg_latency = total_latency_ns_.load() / updates;
-            uint64_t min_lat = min_latency_ns_.load();
-            uint64_t max_lat = max_latency_ns_.load();
-            uint64_t opportunities = arbitrage_opportunities_.load();
-            uint64_t trades = trades_executed_.load();
+            uint64_t opportunities = metrics_.counter_value(opportunities_);
+            uint64_t trades = metrics_.counter_value(trades_);
+            auto us = [](uint64_t ns)
+            { return ns / 1000.0; };
 
             std::cout << "\n╔══════════════════════════════════════════════════════════════╗" << std::endl;
             std::cout << "║                    🚀 ULTRA-FAST ARBISIM 🚀                  ║" << std::endl;
@@ -215,9 +134,16 @@ namespace arbisim
             std::cout << "║ Runtime:           " << std::setw(8) << std::fixed << std::setprecision(1) << runtime_sec << " seconds" << std::setw(19) << "║" << std::endl;
             std::cout << "║ Total Updates:     " << std::setw(8) << updates << std::setw(27) << "║" << std::endl;
             std::cout << "║ Updates/sec:       " << std::setw(8) << std::fixed << std::setprecision(1) << (updates / runtime_sec) << std::setw(27) << "║" << std::endl;
-            std::cout << "║ Avg Latency:       " << std::setw(8) << (avg_latency / 1000) << " μs" << std::setw(24) << "║" << std::endl;
-            std::cout << "║ Min Latency:       " << std::setw(8) << (min_lat == UINT64_MAX ? 0 : min_lat / 1000) << " μs" << std::setw(24) << "║" << std::endl;
-            std::cout << "║ Max Latency:       " << std::setw(8) << (max_lat / 1000) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ Avg Latency:       " << std::setw(8) << us(session.mean()) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ Min Latency:       " << std::setw(8) << us(session.min()) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ p50 Latency:       " << std::setw(8) << us(session.percentile(0.50)) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ p90 Latency:       " << std::setw(8) << us(session.percentile(0.90)) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ p99 Latency:       " << std::setw(8) << us(session.percentile(0.99)) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ p99.9 Latency:     " << std::setw(8) << us(session.percentile(0.999)) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ p99.99 Latency:    " << std::setw(8) << us(session.percentile(0.9999)) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ Max Latency:       " << std::setw(8) << us(session.max()) << " μs" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ Interval p99/max:  " << std::setw(8) << us(interval.percentile(0.99)) << " / " << std::setw(8)
+                      << us(interval.max()) << " μs" << std::setw(13) << "║" << std::endl;
             std::cout << "║ Opportunities:     " << std::setw(8) << opportunities << std::setw(27) << "║" << std::endl;
             std::cout << "║ Trades Executed:   " << std::setw(8) << trades << std::setw(27) << "║" << std::endl;
             if (opportunities > 0)
@@ -233,23 +159,97 @@ namespace arbisim
     {
     private:
         ArbitrageDetector detector_;
-        UltraFastPerformanceTracker perf_tracker_;
+        MetricsRegistry metrics_; // Per-thread counters and histograms, aggregated for reports
+        UltraFastPerformanceTracker perf_tracker_{metrics_};
         RiskManagerType risk_manager_;
+        ExecutionSimulator exec_sim_{detector_};
         ExchangeManager exchange_manager_;
 
-        std::ofstream arbitrage_log_;
+        PipelineTracer tracer_; // Off unless enable_tracing() is called before start()
+        std::string trace_path_;
+        uint64_t trace_from_ns_ = 0, trace_to_ns_ = UINT64_MAX;
+
+        AsyncLogWriter opportunity_log_; // CSV for the dashboard bridge, written off the hot path
+        ColumnarLogWriter<OpportunityColumns> opportunity_archive_; // Compact copy for analysis
+        ColumnarLogWriter<TradeColumns> trade_archive_;
+        MarketDataRecorder capture_; // Optional raw feed capture for the backtester
+        DashboardServer dashboard_;  // Pushes events straight to dashboard.html over WebSocket
+        bool dashboard_enabled_ = true;
+        MetricsServer metrics_server_; // Prometheus text on http://127.0.0.1:<port>/metrics
+        MetricsServerConfig metrics_config_;
+        bool metrics_enabled_ = true;
+        uint64_t started_ns_ = 0;
+
+        // Open-loop load test in place of the feeds (enable_load_test); null otherwise
+        std::unique_ptr<OpenLoopLoadGenerator> load_;
+        bool quiet_ = false; // No per-opportunity console output
+
+        // Engine state published by the thread that owns it, so scrapes read the registry
+        // instead of taking engine locks
+        uint32_t update_queue_depth_ = metrics_.gauge("update_queue_depth");
+        uint32_t opportunity_queue_depth_ = metrics_.gauge("opportunity_queue_depth");
+        uint32_t opportunities_expired_ = metrics_.counter("opportunities_expired");
+        uint32_t opportunities_evicted_ = metrics_.counter("opportunities_evicted");
+        uint32_t risk_exposure_ = metrics_.gauge("risk_exposure_usd");
+        uint32_t risk_daily_pnl_ = metrics_.gauge("risk_daily_pnl_usd");
+        uint32_t risk_drawdown_ = metrics_.gauge("risk_drawdown");
+        uint32_t risk_positions_ = metrics_.gauge("risk_open_positions");
+        uint32_t risk_var99_ = metrics_.gauge("risk_var99_usd");
+        uint32_t risk_es99_ = metrics_.gauge("risk_es99_usd");
         std::atomic<bool> running_{false};
 
         std::thread stats_thread_;
 
+        // Feeds only enqueue; one market thread applies updates and runs detection
+        ConflatingUpdateQueue update_queue_;
+        std::thread market_thread_;
+        struct TouchedSymbol
+        {
+            std::string symbol;
+            uint64_t latest_ts;
+            uint64_t trace_id; // Newest traced update on the symbol, 0 if none
+        };
+        std::vector<TouchedSymbol> touched_symbols_; // Market thread only
+        std::vector<std::pair<std::string, FastOrderBook *>> touched_books_;
+        std::vector<FastOrderBook *> spread_books_; // BTCUSDT on every venue, for the dashboard spread
+        uint32_t detection_passes_ = metrics_.counter("detection_passes");
+        std::vector<ArbitrageOpportunity> detected_; // Reused by every detection pass
+
+        // Heap allocations per hot-path stage; non-zero only in ARBISIM_ALLOC_TRACKING builds
+        uint32_t allocs_apply_ = metrics_.counter("allocations_apply");
+        uint32_t allocs_detect_ = metrics_.counter("allocations_detect");
+        uint32_t allocs_risk_ = metrics_.counter("allocations_risk");
+        uint32_t allocs_log_ = metrics_.counter("allocations_log");
+
+        // Detection hands opportunities to a single risk worker through a priority queue;
+        // anything older than the latency budget when its turn comes is dropped
+        OpportunityQueue opportunity_queue_{256, 2000000};
+        std::thread risk_thread_;
+
+        // Scenario VaR over current positions, refreshed alongside trading
+        WorkStealingPool compute_pool_;
+        ScenarioEngine scenario_engine_{compute_pool_};
+        std::thread var_thread_;
+        mutable std::mutex var_mutex_;
+        VaRReport last_var_;
+
     public:
         UltraFastArbiSimEngine()
         {
-            // Open log file
-            arbitrage_log_.open("arbitrage_opportunities.csv");
-            arbitrage_log_ << "timestamp,symbol,buy_exchange,sell_exchange,buy_price,sell_price,profit_bps,net_profit_bps,latency_ns,decision\n";
-
-#ifdef HAVE_BOOST
+            // Open log file: batched every 50 ms, rotated at 64 MB
+            AsyncLogConfig log_config;
+            log_config.path = "arbitrage_opportunities.csv";
+            if (opportunity_archive_.open("arbitrage_opportunities.arbcol"))
+            {
+                opportunity_log_.set_batch_sink([this](const std::vector<OpportunityRecord> &batch)
+                                                { opportunity_archive_.append(batch.begin(), batch.end()); });
+            }
+            trade_archive_.open("trades.arbcol");
+            opportunity_log_.set_tracer(&tracer_);
+            if (!opportunity_log_.start(log_config))
+            {
+                std::cerr << "[INIT] Cannot open " << log_config.path << std::endl;
+            }
 
             risk_manager_.set_risk_limits(
                 20.0,      // max_position_size: 20 BTC per exchange (was 10.0)
@@ -267,10 +267,7 @@ namespace arbisim
             std::cout << "[INIT] - Max position: 20 BTC per exchange" << std::endl;
             std::cout << "[INIT] - Max exposure: $5M total" << std::endl;
             std::cout << "[INIT] - Min profit: -5 bps (ALLOWS LOSSES)" << std::endl;
-#else
-            // For simple risk manager, set more liberal limits
-            risk_manager_.set_risk_limits(10.0, -5.0); // 0.5 BTC max, 5 bps min profit
-#endif
+            std::cout << "[INIT] - Risk pipeline: " << RiskManagerType::check_count << " checks" << std::endl;
 
             // Add exchanges
             exchange_manager_.add_exchange(std::make_unique<BinanceFeed>());
@@ -283,9 +280,24 @@ namespace arbisim
             for (const auto &exchange : exchange_names)
             {
                 detector_.add_orderbook("BTCUSDT", exchange);
+                spread_books_.push_back(detector_.get_orderbook("BTCUSDT", exchange));
             }
+
+            // Per-venue taker fees at an assumed $1M trailing 30-day volume;
+            // the detector only emits crosses that clear both legs' fees plus 5 bps
+            FeeSchedule fee_schedule = FeeSchedule::defaults();
+            fee_schedule.set_volume_30d_all(1000000.0);
+            detector_.set_fee_schedule(fee_schedule);
             detector_.set_min_profit_bps(5.0);
 
+            // Order path per venue: send latency, jitter and how fast competitors drain a level
+            exec_sim_.set_venue_model("binance", {3000000, 1000000, 40000000, 0.0});
+            exec_sim_.set_venue_model("coinbase", {8000000, 3000000, 60000000, 0.0});
+            exec_sim_.set_venue_model("kraken", {25000000, 15000000, 80000000, 0.0});
+            exec_sim_.set_venue_model("bybit", {6000000, 2000000, 40000000, 0.0});
+            exec_sim_.set_report_callback([this](const ExecutionReport &report)
+                                          { this->handle_execution_report(report); });
+
             // Set up exchange feeds
             exchange_manager_.set_symbol("BTCUSDT");
             exchange_manager_.set_update_callback([this](const MarketUpdate &update)
@@ -295,8 +307,62 @@ namespace arbisim
         ~UltraFastArbiSimEngine()
         {
             stop();
-            if (arbitrage_log_.is_open())
-                arbitrage_log_.close();
+            opportunity_log_.stop();
+        }
+
+        // Record every market update for offline replay (see tools/backtest.cpp)
+        bool enable_capture(const std::string &path)
+        {
+            if (!capture_.open(path))
+                return false;
+            std::cout << "[INIT] Capturing market data to " << path << std::endl;
+            return true;
+        }
+
+        // Trace one update in sample_every through every stage; spans beginning between
+        // from_sec and to_sec after this call are written to path as Chrome trace JSON on stop
+        void enable_tracing(const std::string &path, uint64_t sample_every, double from_sec, double to_sec)
+        {
+            TraceConfig config;
+            config.enabled = true;
+            config.sample_every = sample_every;
+            tracer_.configure(config);
+            trace_path_ = path;
+            uint64_t now = timestamp_ns();
+            trace_from_ns_ = now + static_cast<uint64_t>(std::max(0.0, from_sec) * 1e9);
+            trace_to_ns_ = to_sec > 0.0 ? now + static_cast<uint64_t>(to_sec * 1e9) : UINT64_MAX;
+            std::cout << "[INIT] Tracing 1 in " << std::max<uint64_t>(1, sample_every) << " updates to " << path << std::endl;
+        }
+
+        // Leave port 8080 to test-server.js (which tails the CSV instead)
+        void disable_dashboard() { dashboard_enabled_ = false; }
+
+        void set_metrics_port(uint16_t port) { metrics_config_.port = port; }
+        void disable_metrics() { metrics_enabled_ = false; }
+
+        // Replace the feeds with an open-loop generator cycling through source; set before
+        // start(), then run_load_test(). Per-opportunity console output is turned off, since
+        // at load-test rates the terminal would be the bottleneck being measured.
+        void enable_load_test(std::vector<MarketUpdate> source)
+        {
+            load_ = std::make_unique<OpenLoopLoadGenerator>(std::move(source), [this](const MarketUpdate &update)
+                                                            { handle_market_update(update); });
+            quiet_ = true;
+            std::cout << "[INIT] Load test: feeds replaced by an open-loop generator" << std::endl;
+        }
+
+        // Ramp the offered rate until the pipeline saturates (see load_generator.h); blocks
+        // on the calling thread, which does the sending
+        std::vector<LoadStepResult> run_load_test(const LoadTestConfig &config, const std::function<bool()> &cancelled)
+        {
+            if (!load_ || !running_.load())
+                return {};
+            std::cout << "[LOAD] Latency from each update's intended send time to the end of its detection pass\n"
+                      << "[LOAD] opp p99: intended send of the triggering update to the log\n"
+                      << std::endl;
+            OpenLoopLoadGenerator::print_header(std::cout);
+            return load_->run(config, cancelled, [](const LoadStepResult &step)
+                              { OpenLoopLoadGenerator::print_step(std::cout, step); });
         }
 
         void start()
@@ -321,11 +387,40 @@ namespace arbisim
             std::cout << "║ Build Time:        ULTRA-FAST                                ║" << std::endl;
             std::cout << "║ Min Profit:        5.0 bps (after fees)                     ║" << std::endl;
             std::cout << "╚══════════════════════════════════════════════════════════════╝" << std::endl;
+
+            if (dashboard_enabled_)
+            {
+                dashboard_.set_metrics_source([this]()
+                                              { return dashboard_metrics(); });
+                if (dashboard_.start())
+                    std::cout << "[INIT] Dashboard stream on ws://127.0.0.1:" << dashboard_.port() << std::endl;
+                else
+                    std::cerr << "[INIT] Port 8080 busy (test-server.js running?) - dashboard stream disabled" << std::endl;
+            }
+
+            started_ns_ = timestamp_ns();
+            if (metrics_enabled_)
+            {
+                metrics_server_.set_source([this]()
+                                           { return prometheus_metrics(); });
+                if (metrics_server_.start(metrics_config_))
+                    std::cout << "[INIT] Prometheus metrics on http://127.0.0.1:" << metrics_server_.port() << "/metrics" << std::endl;
+                else
+                    std::cerr << "[INIT] Port " << metrics_config_.port << " busy - metrics endpoint disabled" << std::endl;
+            }
+
             std::cout << "\nPress Ctrl+C to stop safely...\n"
                       << std::endl;
 
-            // Start exchange feeds
-            exchange_manager_.start_all();
+            // Start market thread, then the feeds that fill its queue
+            market_thread_ = std::thread([this]()
+                                         { market_loop(); });
+            if (!load_)
+                exchange_manager_.start_all();
+
+            // Start risk worker
+            risk_thread_ = std::thread([this]()
+                                       { risk_worker_loop(); });
 
             // Start monitoring thread
             stats_thread_ = std::thread([this]()
@@ -337,6 +432,14 @@ namespace arbisim
                     print_risk_summary();
                 }
             } });
+
+            // Start VaR thread (every 2 seconds)
+            var_thread_ = std::thread([this]()
+                                      {
+            while (running_.load()) {
+                run_var();
+                std::this_thread::sleep_for(std::chrono::seconds(2));
+            } });
         }
 
         void stop()
@@ -348,8 +451,39 @@ namespace arbisim
 
             exchange_manager_.stop_all();
 
+            // Apply and detect on whatever the feeds left queued
+            update_queue_.close();
+            if (market_thread_.joinable())
+                market_thread_.join();
+            capture_.close();
+
+            // Let the risk worker drain what is still within budget, then stop it
+            opportunity_queue_.close();
+            if (risk_thread_.joinable())
+                risk_thread_.join();
+            opportunity_log_.stop();
+            opportunity_archive_.close();
+
+            if (tracer_.enabled())
+            {
+                long spans = tracer_.write_chrome_trace(trace_path_, trace_from_ns_, trace_to_ns_);
+                if (spans < 0)
+                    std::cerr << "[TRACE] Cannot write " << trace_path_ << std::endl;
+                else
+                    std::cout << "[TRACE] " << spans << " stage spans written to " << trace_path_ << std::endl;
+            }
+
+            // Settle orders still in flight against the final books
+            exec_sim_.process_until(UINT64_MAX);
+            dashboard_.stop();
+            metrics_server_.stop();
+
             if (stats_thread_.joinable())
                 stats_thread_.join();
+            if (var_thread_.joinable())
+                var_thread_.join();
+
+            trade_archive_.close();
 
             // Final reports
             perf_tracker_.print_stats();
@@ -359,81 +493,242 @@ namespace arbisim
         }
 
     private:
+        // Feed callback: hand the update to the market thread
         void handle_market_update(const MarketUpdate &update)
         {
-            uint64_t processing_start = timestamp_ns();
-
-            // Update order book
-            auto *book = detector_.get_orderbook(update.symbol, update.exchange);
-            if (!book)
+            uint64_t trace_id = tracer_.begin_trace();
+            if (trace_id == 0)
+            {
+                update_queue_.push(update);
                 return;
+            }
 
-            if (update.type == MarketUpdate::BID_UPDATE)
+            uint64_t entered = timestamp_ns();
+            update_queue_.push(update, trace_id, entered);
+            uint64_t pushed = timestamp_ns();
+            tracer_.name_thread(update.exchange + " feed");
+            tracer_.record(TraceStage::FEED, trace_id, update.timestamp_ns, entered);
+            tracer_.record(TraceStage::ENQUEUE, trace_id, entered, pushed);
+        }
+
+        void market_loop()
+        {
+            tracer_.name_thread("market");
+            MetricsShard &metrics = metrics_.local();
+            std::vector<MarketUpdate> batch;
+            uint64_t idle_since = timestamp_ns();
+            while (update_queue_.drain(batch, std::chrono::milliseconds(100)))
             {
-                book->update_bid(update.price, update.quantity);
+                metrics.set(update_queue_depth_, static_cast<double>(batch.size())); // Waiting when drained
+                if (batch.empty())
+                    continue;
+
+                // Time in the queue, drawn on this thread's idle gap so spans stay nested
+                if (tracer_.enabled())
+                {
+                    uint64_t now = timestamp_ns();
+                    for (const auto &update : batch)
+                        tracer_.record(TraceStage::DEQUEUE, update.trace_id, std::max(update.enqueued_ns, idle_since), now);
+                }
+                process_update_batch(batch);
+                if (tracer_.enabled())
+                    idle_since = timestamp_ns();
             }
-            else if (update.type == MarketUpdate::ASK_UPDATE)
+        }
+
+        // Best bid anywhere against best ask anywhere, in bps of their mid; positive means
+        // the venues cross. Needs quotes from at least two venues.
+        void publish_best_spread()
+        {
+            double max_bid = 0.0, min_ask = 0.0;
+            size_t quoted = 0;
+            for (const auto *book : spread_books_)
             {
-                book->update_ask(update.price, update.quantity);
+                auto [bid, ask] = book->get_best_bid_ask();
+                if (bid <= 0.0 || ask <= 0.0)
+                    continue;
+                max_bid = std::max(max_bid, bid);
+                min_ask = quoted == 0 ? ask : std::min(min_ask, ask);
+                quoted++;
             }
+            if (quoted >= 2)
+                dashboard_.publish_spread((max_bid - min_ask) / ((max_bid + min_ask) / 2.0) * 10000.0);
+        }
 
-            // Check for arbitrage opportunities
-            auto opportunities = detector_.check_arbitrage(update.symbol, update.timestamp_ns);
+        // Apply every delta from one drain cycle, then detect once per touched symbol
+        void process_update_batch(const std::vector<MarketUpdate> &batch)
+        {
+            touched_symbols_.clear();
+            touched_books_.clear();
 
-            uint64_t processing_end = timestamp_ns();
-            uint64_t processing_latency = processing_end - update.timestamp_ns;
+            alloc::AllocScope apply_allocs;
+            for (const auto &update : batch)
+            {
+                if (capture_.is_open())
+                    capture_.record(update);
+
+                // Orders that reached their venue before this update fill against the current books
+                exec_sim_.process_until(update.timestamp_ns);
+
+                // Update order book
+                uint64_t apply_start = update.trace_id ? timestamp_ns() : 0;
+                auto *book = detector_.get_orderbook(update.symbol, update.exchange);
+                if (!book)
+                    continue;
+
+                // Levels carry the venue's stamp, the same clock the execution simulator runs on
+                if (update.type == MarketUpdate::BID_UPDATE)
+                {
+                    book->update_bid(update.price, update.quantity, update.timestamp_ns);
+                }
+                else if (update.type == MarketUpdate::ASK_UPDATE)
+                {
+                    book->update_ask(update.price, update.quantity, update.timestamp_ns);
+                }
+                if (update.trace_id)
+                    tracer_.record(TraceStage::BOOK_APPLY, update.trace_id, apply_start, timestamp_ns());
+                if (std::none_of(touched_books_.begin(), touched_books_.end(), [&](const auto &entry)
+                                 { return entry.second == book; }))
+                    touched_books_.emplace_back(update.exchange, book);
+
+                // Detection sees the latest book state, so it is as fresh as the newest update
+                auto it = std::find_if(touched_symbols_.begin(), touched_symbols_.end(),
+                                       [&](const auto &entry)
+                                       { return entry.symbol == update.symbol; });
+                if (it == touched_symbols_.end())
+                {
+                    touched_symbols_.push_back({update.symbol, update.timestamp_ns, update.trace_id});
+                }
+                else
+                {
+                    it->latest_ts = std::max(it->latest_ts, update.timestamp_ns);
+                    if (update.trace_id)
+                        it->trace_id = update.trace_id;
+                }
+            }
+
+            metrics_.add(allocs_apply_, apply_allocs.allocations());
 
-            // Record performance
-            perf_tracker_.record_update_latency(processing_latency);
+            // Dashboard venue prices: one mid per book per batch, conflated further by the server
+            for (const auto &[exchange, book] : touched_books_)
+                dashboard_.publish_price(exchange, book->get_mid_price());
+            publish_best_spread();
 
-            // Process each opportunity
-            for (const auto &opp : opportunities)
+            uint64_t detect_allocs = 0;
+            for (const auto &[symbol, latest_ts, trace_id] : touched_symbols_)
             {
-                perf_tracker_.record_arbitrage_opportunity();
-                process_arbitrage_opportunity(opp);
+                // Check for arbitrage opportunities
+                uint64_t detect_start = trace_id ? timestamp_ns() : 0;
+                alloc::AllocScope pass_allocs;
+                detector_.check_arbitrage(symbol, latest_ts, detected_);
+                detect_allocs += pass_allocs.allocations();
+                metrics_.add(detection_passes_);
+                if (trace_id)
+                {
+                    tracer_.record(TraceStage::DETECT, trace_id, detect_start, timestamp_ns());
+                    for (auto &opp : detected_)
+                        opp.trace_id = trace_id;
+                }
+
+                // Only OPEN/UPDATE events are tradeable; CLOSE events are logged as they are
+                for (auto &opp : detected_)
+                {
+                    if (opp.event == OpportunityEvent::CLOSE)
+                    {
+                        log_opportunity_close(opp);
+                        continue;
+                    }
+                    alloc::AllocScope push_allocs;
+                    opportunity_queue_.push(std::move(opp), latest_ts);
+                    detect_allocs += push_allocs.allocations();
+                }
+            }
+            metrics_.add(allocs_detect_, detect_allocs);
+
+            // Record performance: each update's latency runs until the detection that covered it
+            uint64_t processing_end = timestamp_ns();
+            for (const auto &update : batch)
+            {
+                perf_tracker_.record_update_latency(processing_end - update.timestamp_ns);
+                if (load_)
+                    load_->record_update(update.timestamp_ns, processing_end);
             }
         }
 
-        void process_arbitrage_opportunity(const ArbitrageOpportunity &opp)
+        void risk_worker_loop()
         {
-            // Risk assessment
-            auto assessment = risk_manager_.assess_opportunity(opp);
+            tracer_.name_thread("risk");
+            MetricsShard &metrics = metrics_.local();
+            OpportunityQueue::Stats last_queue;
+            std::vector<ArbitrageOpportunity> batch;
+            std::vector<RiskAssessment> assessments;
+            batch.reserve(64);
+            assessments.reserve(64);
+
+            while (true)
+            {
+                if (!opportunity_queue_.wait_for_work(std::chrono::milliseconds(100)))
+                {
+                    if (opportunity_queue_.closed())
+                        return;
+                    continue;
+                }
+
+                batch.clear();
+                OpportunityQueue::Stats queue;
+                size_t popped = opportunity_queue_.pop_batch(batch, 64, timestamp_ns(), &queue);
+                metrics.set(opportunity_queue_depth_, static_cast<double>(queue.depth));
+                metrics.add(opportunities_expired_, queue.expired - last_queue.expired);
+                metrics.add(opportunities_evicted_, queue.evicted - last_queue.evicted);
+                if (load_)
+                    load_->record_dropped((queue.expired - last_queue.expired) + (queue.evicted - last_queue.evicted));
+                last_queue = queue;
+                if (popped == 0)
+                    continue;
+
+                // Allocate the whole batch at once so the best crosses get the inventory
+                uint64_t risk_start = tracer_.enabled() ? timestamp_ns() : 0;
+                alloc::AllocScope risk_allocs;
+                risk_manager_.assess_batch(batch, assessments);
+                metrics.add(allocs_risk_, risk_allocs.allocations());
+                if (risk_start)
+                {
+                    uint64_t risk_end = timestamp_ns();
+                    for (const auto &opp : batch)
+                        tracer_.record(TraceStage::RISK, opp.trace_id, risk_start, risk_end);
+                }
+
+                for (size_t i = 0; i < batch.size(); ++i)
+                {
+                    perf_tracker_.record_arbitrage_opportunity();
+                    process_arbitrage_opportunity(batch[i], assessments[i]);
+                }
+            }
+        }
 
+        void process_arbitrage_opportunity(const ArbitrageOpportunity &opp, const RiskAssessment &assessment)
+        {
             // Create decision code for CSV logging
             int decision_code = static_cast<int>(assessment.decision);
 
-            // Log opportunity to CSV file for dashboard bridge
-            arbitrage_log_ << opp.detected_at_ns << ","
-                           << opp.symbol << ","
-                           << opp.buy_exchange << ","
-                           << opp.sell_exchange << ","
-                           << std::fixed << std::setprecision(2) << opp.buy_price << ","
-                           << std::fixed << std::setprecision(2) << opp.sell_price << ","
-                           << std::fixed << std::setprecision(1) << opp.profit_bps << ","
-                           << std::fixed << std::setprecision(1) << assessment.net_profit_bps << ","
-                           << opp.latency_ns << ","
-                           << decision_code << "\n";
-            arbitrage_log_.flush(); // Important: Force write to file for dashboard bridge
+            // Log opportunity (formatted and flushed by the writer thread) and push it to the dashboard
+            log_and_publish(OpportunityRecord(opp, assessment.net_profit_bps, decision_code));
+
+            // Send both legs; positions and P&L update when the fills come back
+            if (assessment.decision == RiskDecision::APPROVED)
+                exec_sim_.submit(opp, assessment.recommended_size, timestamp_ns());
+            if (quiet_)
+                return;
 
             // Display opportunity with better formatting
-#ifdef HAVE_BOOST
-            if (assessment.decision == RiskManager::RiskDecision::APPROVED)
-            {
-#else
-            if (assessment.decision == SimpleRiskManager::Decision::APPROVED)
+            const char *event = opp.event == OpportunityEvent::OPEN ? "OPEN" : "UPDATE";
+            if (assessment.decision == RiskDecision::APPROVED)
             {
-#endif
-                std::cout << "==> APPROVED ARBITRAGE OPPORTUNITY <==" << std::endl;
-                perf_tracker_.record_trade_executed();
-
-                // Execute the trade if approved
-#ifdef HAVE_BOOST
-                risk_manager_.execute_trade(opp, assessment.recommended_size);
-#endif
+                std::cout << "==> APPROVED ARBITRAGE OPPORTUNITY (" << event << ") <==" << std::endl;
             }
             else
             {
-                std::cout << "==> ARBITRAGE OPPORTUNITY (REJECTED) <==" << std::endl;
+                std::cout << "==> ARBITRAGE OPPORTUNITY (" << event << ", REJECTED) <==" << std::endl;
             }
 
             std::cout << "Symbol: " << opp.symbol << " | "
@@ -442,30 +737,181 @@ namespace arbisim
             std::cout << "Gross Profit: " << std::fixed << std::setprecision(1) << opp.profit_bps << " bps | "
                       << "Net Profit: " << std::fixed << std::setprecision(1) << assessment.net_profit_bps << " bps | "
                       << "Latency: " << (opp.latency_ns / 1000) << " us" << std::endl;
+            std::cout << "Depth: " << std::fixed << std::setprecision(4) << opp.max_quantity << " BTC | "
+                      << "VWAP: $" << std::setprecision(2) << opp.buy_vwap << " -> $" << opp.sell_vwap << std::endl;
 
-#ifdef HAVE_BOOST
-            if (assessment.decision != RiskManager::RiskDecision::APPROVED)
-            {
-#else
-            if (assessment.decision != SimpleRiskManager::Decision::APPROVED)
+            if (assessment.decision != RiskDecision::APPROVED)
             {
-#endif
                 std::cout << "X Rejected: " << assessment.reason << std::endl;
             }
             else
             {
                 std::cout << "✓ Trade Size: " << std::fixed << std::setprecision(4) << assessment.recommended_size << " BTC" << std::endl;
 
-                // Calculate and display expected P&L
-                double gross_pnl = (opp.sell_price - opp.buy_price) * assessment.recommended_size;
-                double fees = (assessment.recommended_size * opp.buy_price + assessment.recommended_size * opp.sell_price) * 0.001;
-                double net_pnl = gross_pnl - fees;
+                // Display expected P&L after fees
+                double net_pnl = assessment.expected_pnl - assessment.fees;
 
                 std::cout << "$ Expected P&L: $" << std::fixed << std::setprecision(2) << net_pnl << std::endl;
             }
             std::cout << "----------------------------------------" << std::endl;
         }
 
+        void log_and_publish(const OpportunityRecord &record)
+        {
+            uint64_t log_start = record.trace_id ? timestamp_ns() : 0;
+            alloc::AllocScope log_allocs;
+            opportunity_log_.log(record);
+            if (log_start)
+                tracer_.record(TraceStage::LOG_ENQUEUE, record.trace_id, log_start, timestamp_ns());
+            if (load_)
+                load_->record_opportunity(record.detected_at_ns - record.latency_ns, timestamp_ns());
+            dashboard_.publish(record);
+            metrics_.add(allocs_log_, log_allocs.allocations());
+        }
+
+        // Cross disappeared: one CSV row (decision -1) and one console line
+        void log_opportunity_close(const ArbitrageOpportunity &opp)
+        {
+            log_and_publish(OpportunityRecord(opp, opp.net_profit_bps, -1));
+            if (quiet_)
+                return;
+
+            std::cout << "<== CLOSED " << opp.buy_exchange << " -> " << opp.sell_exchange
+                      << " after " << std::fixed << std::setprecision(1) << (opp.duration_ns / 1e6) << " ms" << std::endl;
+        }
+
+        void handle_execution_report(const ExecutionReport &report)
+        {
+            if (report.matched_qty > 0.0)
+            {
+                // Book the matched quantity at the prices actually achieved
+                ArbitrageOpportunity filled = report.opportunity;
+                filled.buy_price = report.buy_vwap;
+                filled.sell_price = report.sell_vwap;
+                risk_manager_.execute_trade(filled, report.matched_qty);
+                perf_tracker_.record_trade_executed();
+
+                Trade trade(report.execution_id, filled, report.matched_qty);
+                TradeRecord record;
+                record.timestamp_ns = report.completed_ns;
+                record.trade_id = trade.trade_id;
+                record.quantity = trade.quantity;
+                record.buy_price = trade.buy_price;
+                record.sell_price = trade.sell_price;
+                record.fees = trade.fees;
+                record.net_pnl = trade.net_pnl;
+                OpportunityRecord::copy_name(record.symbol, trade.symbol);
+                OpportunityRecord::copy_name(record.buy_exchange, trade.buy_exchange);
+                OpportunityRecord::copy_name(record.sell_exchange, trade.sell_exchange);
+                trade_archive_.append(record);
+            }
+            if (report.unwind_qty > 0.0)
+            {
+                risk_manager_.record_realized_pnl(report.unwind_pnl);
+            }
+        }
+
+        // Pulled by the dashboard server thread once per metrics interval
+        DashboardMetrics dashboard_metrics() const
+        {
+            auto report = risk_manager_.generate_report();
+            DashboardMetrics metrics;
+            metrics.total_opportunities = perf_tracker_.opportunity_count();
+            metrics.avg_latency_us = perf_tracker_.avg_latency_ns() / 1000.0;
+            metrics.daily_pnl = report.daily_pnl;
+            metrics.win_rate_pct = report.win_rate * 100;
+            return metrics;
+        }
+
+        // Body of a /metrics scrape, on the metrics server thread. Reads the registry,
+        // atomics and the book stamps; no engine lock is taken.
+        std::string prometheus_metrics()
+        {
+            MetricsSnapshot snap = metrics_.snapshot();
+            LatencyHistogram latency = perf_tracker_.session_latency();
+            auto log = opportunity_log_.get_stats();
+            uint64_t now = timestamp_ns();
+
+            std::string out;
+            out.reserve(8192);
+            prometheus::gauge(out, "arbisim_uptime_seconds", "Seconds since the engine started", (now - started_ns_) / 1e9);
+            prometheus::counter(out, "arbisim_updates_total", "Market updates applied to the books", snap.counter("updates"));
+            prometheus::counter(out, "arbisim_detection_passes_total", "Arbitrage detection passes (one per touched symbol per batch)",
+                                snap.counter("detection_passes"));
+            prometheus::counter(out, "arbisim_opportunities_total", "Opportunities assessed by risk", snap.counter("opportunities"));
+            prometheus::counter(out, "arbisim_trades_executed_total", "Trades sent to the execution simulator", snap.counter("trades_executed"));
+            prometheus::histogram(out, "arbisim_update_latency_seconds", "Market update stamp to end of the detection pass covering it", latency);
+
+            prometheus::gauge(out, "arbisim_update_queue_depth", "Updates waiting when the market thread last drained",
+                              snap.gauge("update_queue_depth"));
+            prometheus::gauge(out, "arbisim_opportunity_queue_depth", "Opportunities queued for risk after its last pop",
+                              snap.gauge("opportunity_queue_depth"));
+            prometheus::counter(out, "arbisim_opportunities_expired_total", "Opportunities dropped for exceeding the latency budget",
+                                snap.counter("opportunities_expired"));
+            prometheus::counter(out, "arbisim_opportunities_evicted_total", "Opportunities displaced or refused by a full queue",
+                                snap.counter("opportunities_evicted"));
+            prometheus::counter(out, "arbisim_log_dropped_total", "Opportunity log records dropped by a full writer queue", log.dropped);
+            prometheus::counter(out, "arbisim_dashboard_lost_total", "Dashboard events overwritten before they were sent",
+                                dashboard_.lost());
+            if (alloc::TRACKING)
+            {
+                prometheus::family(out, "arbisim_allocations_total", "counter", "Heap allocations made by each hot-path stage");
+                for (const char *stage : {"apply", "detect", "risk", "log"})
+                    prometheus::sample(out, "arbisim_allocations_total", static_cast<double>(snap.counter(std::string("allocations_") + stage)),
+                                       std::string("stage=\"") + stage + "\"");
+            }
+
+            prometheus::family(out, "arbisim_venue_staleness_seconds", "gauge", "Age of the newest BTCUSDT book change per venue");
+            for (const auto *book : spread_books_)
+            {
+                uint64_t last = book->last_update_ns();
+                if (last > 0)
+                    prometheus::sample(out, "arbisim_venue_staleness_seconds", now > last ? (now - last) / 1e9 : 0.0,
+                                       "venue=\"" + book->exchange() + "\"");
+            }
+
+            prometheus::gauge(out, "arbisim_risk_exposure_usd", "Total position exposure", snap.gauge("risk_exposure_usd"));
+            prometheus::gauge(out, "arbisim_risk_daily_pnl_usd", "Realized P&L today", snap.gauge("risk_daily_pnl_usd"));
+            prometheus::gauge(out, "arbisim_risk_drawdown", "Drawdown from the balance high", snap.gauge("risk_drawdown"));
+            prometheus::gauge(out, "arbisim_risk_open_positions", "Positions with non-zero quantity", snap.gauge("risk_open_positions"));
+            prometheus::gauge(out, "arbisim_risk_var99_usd", "1-minute 99% VaR of current positions", snap.gauge("risk_var99_usd"));
+            prometheus::gauge(out, "arbisim_risk_es99_usd", "1-minute 99% expected shortfall", snap.gauge("risk_es99_usd"));
+            return out;
+        }
+
+        void run_var()
+        {
+            std::vector<ScenarioPosition> scenario_positions;
+            for (const auto &pos : risk_manager_.get_positions())
+            {
+                ScenarioPosition sp;
+                sp.exchange = pos.exchange;
+                sp.symbol = pos.symbol;
+                sp.quantity = pos.quantity;
+
+                // Mark at the venue mid when we have one, otherwise at entry
+                auto *book = detector_.get_orderbook(pos.symbol, pos.exchange);
+                double mid = book ? book->get_mid_price() : 0.0;
+                sp.mark_price = mid > 0.0 ? mid : pos.avg_price;
+                scenario_positions.push_back(sp);
+            }
+
+            auto report = scenario_engine_.run(scenario_positions);
+
+            // Risk state for scrapes, at this loop's cadence rather than per scrape
+            auto risk = risk_manager_.generate_report();
+            MetricsShard &metrics = metrics_.local();
+            metrics.set(risk_exposure_, risk.total_exposure);
+            metrics.set(risk_daily_pnl_, risk.daily_pnl);
+            metrics.set(risk_drawdown_, risk.current_drawdown);
+            metrics.set(risk_positions_, static_cast<double>(risk.active_positions));
+            metrics.set(risk_var99_, report.var_99);
+            metrics.set(risk_es99_, report.es_99);
+
+            std::lock_guard<std::mutex> lock(var_mutex_);
+            last_var_ = report;
+        }
+
         void print_risk_summary()
         {
             auto report = risk_manager_.generate_report();
@@ -475,6 +921,20 @@ namespace arbisim
                       << "Exposure: $" << std::fixed << std::setprecision(0) << report.total_exposure << " | "
                       << "Positions: " << report.active_positions << " | "
                       << "Take Rate: " << std::fixed << std::setprecision(1) << (report.take_rate * 100) << "%" << std::endl;
+
+            VaRReport var;
+            {
+                std::lock_guard<std::mutex> lock(var_mutex_);
+                var = last_var_;
+            }
+            if (var.risk_factors > 0)
+            {
+                std::cout << "📉 VaR (1m): "
+                          << "99%: $" << std::fixed << std::setprecision(0) << var.var_99 << " | "
+                          << "ES 99%: $" << var.es_99 << " | "
+                          << "97.5%: $" << var.var_975 << " | "
+                          << var.paths << " paths in " << (var.compute_ns / 1000) << " us" << std::endl;
+            }
         }
 
         void print_final_summary()
@@ -490,6 +950,44 @@ namespace arbisim
             std::cout << "║ Win Rate:             " << std::setw(8) << std::fixed << std::setprecision(1) << (report.win_rate * 100) << "%" << std::setw(26) << "║" << std::endl;
             std::cout << "║ Total P&L:            $" << std::setw(7) << std::fixed << std::setprecision(2) << report.daily_pnl << std::setw(25) << "║" << std::endl;
             std::cout << "║ Total Exposure:       $" << std::setw(7) << std::fixed << std::setprecision(0) << report.total_exposure << std::setw(25) << "║" << std::endl;
+            auto exec = exec_sim_.get_stats();
+            std::cout << "║ Orders Filled:        " << std::setw(8) << exec.fully_filled << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Partially Filled:     " << std::setw(8) << exec.partially_filled << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Missed:               " << std::setw(8) << exec.unfilled << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Leg-Risk Unwinds:     " << std::setw(8) << exec.unwinds << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Expected P&L:         $" << std::setw(7) << std::fixed << std::setprecision(2) << exec.expected_pnl << std::setw(25) << "║" << std::endl;
+            std::cout << "║ Realized P&L:         $" << std::setw(7) << std::fixed << std::setprecision(2) << exec.realized_pnl << std::setw(25) << "║" << std::endl;
+            auto lifecycle = detector_.lifecycle_stats();
+            auto queue = opportunity_queue_.get_stats();
+            auto conflation = update_queue_.get_stats();
+            uint64_t passes = metrics_.counter_value(detection_passes_);
+            double conflation_ratio = passes > 0 ? static_cast<double>(conflation.drained) / passes : 0.0;
+            std::cout << "║ Crosses Opened:       " << std::setw(8) << lifecycle.opened << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Repeats Coalesced:    " << std::setw(8) << lifecycle.coalesced << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Cross Half-Life:      " << std::setw(8) << std::fixed << std::setprecision(1) << (lifecycle.half_life_ns / 1e6) << " ms" << std::setw(24) << "║" << std::endl;
+            std::cout << "║ Updates/Detection:    " << std::setw(8) << std::fixed << std::setprecision(2) << conflation_ratio << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Max Update Burst:     " << std::setw(8) << conflation.max_batch << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Expired in Queue:     " << std::setw(8) << queue.expired << std::setw(27) << "║" << std::endl;
+            std::cout << "║ Evicted (Queue Full): " << std::setw(8) << queue.evicted << std::setw(27) << "║" << std::endl;
+            if (alloc::TRACKING)
+            {
+                // Heap allocations per applied update, by stage; the steady-state goal is zero
+                uint64_t updates = std::max<uint64_t>(1, metrics_.snapshot().counter("updates"));
+                const std::pair<const char *, uint32_t> stages[] = {
+                    {"Apply", allocs_apply_}, {"Detect", allocs_detect_}, {"Risk", allocs_risk_}, {"Log", allocs_log_}};
+                for (const auto &[stage, counter] : stages)
+                {
+                    std::cout << "║ Allocs/Update " << std::left << std::setw(8) << stage << std::right << std::setw(8)
+                              << std::fixed << std::setprecision(3)
+                              << static_cast<double>(metrics_.counter_value(counter)) / updates << std::setw(27) << "║" << std::endl;
+                }
+            }
+            std::cout << "╠══════════════════════════════════════════════════════════════╣" << std::endl;
+            for (size_t i = 0; i < report.check_names.size(); ++i)
+            {
+                std::cout << "║ Rejected by " << std::left << std::setw(15) << report.check_names[i] << std::right
+                          << std::setw(8) << report.check_rejections[i] << std::setw(22) << "║" << std::endl;
+            }
             std::cout << "╚══════════════════════════════════════════════════════════════╝" << std::endl;
 
             // Save final report to file
@@ -503,14 +1001,57 @@ namespace arbisim
             summary_file << "Win Rate: " << (report.win_rate * 100) << "%\n";
             summary_file << "Total P&L: $" << report.daily_pnl << "\n";
             summary_file << "Total Exposure: $" << report.total_exposure << "\n";
+            summary_file << "Orders Filled / Partial / Missed: " << exec.fully_filled << " / "
+                         << exec.partially_filled << " / " << exec.unfilled << "\n";
+            summary_file << "Leg-Risk Unwinds: " << exec.unwinds << " ($" << exec.leg_risk_pnl << ")\n";
+            summary_file << "Expected P&L (instant fills): $" << exec.expected_pnl << "\n";
+            summary_file << "Realized P&L (simulated fills): $" << exec.realized_pnl << "\n";
+            summary_file << "Crosses Opened / Updated / Closed: " << lifecycle.opened << " / "
+                         << lifecycle.updated << " / " << lifecycle.closed << "\n";
+            summary_file << "Repeat Detections Coalesced: " << lifecycle.coalesced << "\n";
+            summary_file << "Update Conflation (updates / detection passes / ratio / max burst): " << conflation.drained << " / "
+                         << passes << " / " << conflation_ratio << " / " << conflation.max_batch << "\n";
+            auto log_stats = opportunity_log_.get_stats();
+            summary_file << "Opportunity Log (rows / batches / dropped / rotations): " << log_stats.written << " / "
+                         << log_stats.batches << " / " << log_stats.dropped << " / " << log_stats.rotations << "\n";
+            auto archive = opportunity_archive_.get_stats();
+            summary_file << "Opportunity Archive (rows / blocks / bytes): " << archive.rows << " / "
+                         << archive.blocks << " / " << archive.bytes << "\n";
+            summary_file << "Opportunity Queue (served / expired / evicted / max depth): " << queue.served << " / "
+                         << queue.expired << " / " << queue.evicted << " / " << queue.max_depth << "\n";
+            summary_file << "Cross Lifetime (half-life / avg / max): " << (lifecycle.half_life_ns / 1e6) << " / "
+                         << (lifecycle.avg_lifetime_ns / 1e6) << " / " << (lifecycle.max_lifetime_ns / 1e6) << " ms\n";
+            auto stream = dashboard_.get_stats();
+            summary_file << "Dashboard Stream (clients / messages / bytes / lost / dropped clients): " << stream.clients_accepted
+                         << " / " << stream.sent_messages << " / " << stream.sent_bytes << " / " << stream.lost << " / "
+                         << stream.clients_dropped << "\n";
+            LatencyHistogram latency = perf_tracker_.session_latency();
+            summary_file << "Update Latency (p50 / p90 / p99 / p99.9 / p99.99 / max): " << (latency.percentile(0.50) / 1e3)
+                         << " / " << (latency.percentile(0.90) / 1e3) << " / " << (latency.percentile(0.99) / 1e3) << " / "
+                         << (latency.percentile(0.999) / 1e3) << " / " << (latency.percentile(0.9999) / 1e3) << " / "
+                         << (latency.max() / 1e3) << " us\n";
+            for (size_t i = 0; i < report.check_names.size(); ++i)
+            {
+                summary_file << "Rejected by " << report.check_names[i] << ": " << report.check_rejections[i] << "\n";
+            }
             summary_file.close();
 
+            // Full distribution, for comparing sessions beyond the headline percentiles
+            std::ofstream histogram_file("latency_histogram.txt");
+            histogram_file << "Update latency, " << latency.count() << " updates\n";
+            latency.print_buckets(histogram_file);
+            histogram_file.close();
+
             std::cout << "\n📄 Session summary saved to: session_summary.txt" << std::endl;
+            std::cout << "📄 Latency histogram saved to: latency_histogram.txt" << std::endl;
         }
     };
 
 } // namespace arbisim
 
+// Counting operator new/delete in ARBISIM_ALLOC_TRACKING builds (see alloc_tracker.h)
+ARBISIM_DEFINE_COUNTING_ALLOCATOR()
+
 // Global variables for signal handling
 std::atomic<bool> g_shutdown{false};
 arbisim::UltraFastArbiSimEngine *g_engine = nullptr;
@@ -525,7 +1066,7 @@ void signal_handler(int signal)
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
 // Fix console encoding on Windows
 #ifdef _WIN32
@@ -550,6 +1091,14 @@ int main()
     std::cout << "⚡ SSL features disabled - Using simplified networking" << std::endl;
 #endif
 
+    // Calibrates on first use; do it here rather than on the first market update
+    arbisim::TscClock &tsc = arbisim::TscClock::instance();
+    if (tsc.uses_tsc())
+        std::cout << "⚡ Clock: invariant TSC, " << std::fixed << std::setprecision(3) << tsc.ghz()
+                  << " GHz, calibrated to system time" << std::defaultfloat << std::setprecision(6) << std::endl;
+    else
+        std::cout << "⚡ Clock: system clock (no invariant TSC)" << std::endl;
+
     std::cout << "⚡ JSON libraries: NONE - Custom ultra-fast parser" << std::endl;
     std::cout << "⚡ Build time: MINIMIZED - Ready for development!\n"
               << std::endl;
@@ -560,10 +1109,106 @@ int main()
         arbisim::UltraFastArbiSimEngine engine;
         g_engine = &engine;
 
+        // --capture <file>: record the feeds for tools/backtest
+        // --no-dashboard:   don't serve ws://127.0.0.1:8080 (use test-server.js instead)
+        // --metrics-port N: Prometheus endpoint port (default 9464); --no-metrics to disable
+        // --trace <file>:   per-stage Chrome trace of sampled updates, written on shutdown
+        //   [--trace-sample N] trace 1 update in N (default 1)
+        //   [--trace-window FROM:TO] only spans FROM..TO seconds after startup
+        // --load-test:      ramp an open-loop load until saturation instead of running the feeds
+        //   [--load-replay <capture>] cycle a --capture file (default: synthetic quotes)
+        //   [--load-rate START[:FACTOR[:MAX]]] updates/s (default 1000:2:10000000)
+        //   [--load-step-sec S] seconds per step (default 2)
+        //   [--load-slo-us N] p99 beyond which a step counts as saturated (default 10000)
+        //   [--load-out <file>] throughput vs latency curve as CSV (default load_curve.csv)
+        std::string trace_path;
+        uint64_t trace_sample = 1;
+        double trace_from = 0.0, trace_to = 0.0;
+        bool load_test = false;
+        std::string load_replay, load_out = "load_curve.csv";
+        arbisim::LoadTestConfig load_config;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--capture" && i + 1 < argc && !engine.enable_capture(argv[i + 1]))
+            {
+                std::cerr << "❌ Cannot open capture file " << argv[i + 1] << std::endl;
+                return 1;
+            }
+            if (arg == "--no-dashboard")
+                engine.disable_dashboard();
+            if (arg == "--no-metrics")
+                engine.disable_metrics();
+            if (arg == "--metrics-port" && i + 1 < argc)
+                engine.set_metrics_port(static_cast<uint16_t>(std::atoi(argv[++i])));
+            if (arg == "--trace" && i + 1 < argc)
+                trace_path = argv[++i];
+            if (arg == "--trace-sample" && i + 1 < argc)
+                trace_sample = std::strtoull(argv[++i], nullptr, 10);
+            if (arg == "--trace-window" && i + 1 < argc)
+            {
+                std::string window = argv[++i];
+                size_t colon = window.find(':');
+                trace_from = std::atof(window.substr(0, colon).c_str());
+                if (colon != std::string::npos)
+                    trace_to = std::atof(window.substr(colon + 1).c_str());
+            }
+            if (arg == "--load-test")
+                load_test = true;
+            if (arg == "--load-replay" && i + 1 < argc)
+                load_replay = argv[++i];
+            if (arg == "--load-rate" && i + 1 < argc)
+            {
+                char *end = nullptr;
+                load_config.start_rate = std::strtod(argv[++i], &end);
+                if (*end == ':')
+                    load_config.rate_factor = std::strtod(end + 1, &end);
+                if (*end == ':')
+                    load_config.max_rate = std::strtod(end + 1, &end);
+            }
+            if (arg == "--load-step-sec" && i + 1 < argc)
+                load_config.step_ns = static_cast<uint64_t>(std::atof(argv[++i]) * 1e9);
+            if (arg == "--load-slo-us" && i + 1 < argc)
+                load_config.slo_p99_ns = std::strtoull(argv[++i], nullptr, 10) * 1000;
+            if (arg == "--load-out" && i + 1 < argc)
+                load_out = argv[++i];
+        }
+        if (!trace_path.empty())
+            engine.enable_tracing(trace_path, trace_sample, trace_from, trace_to);
+
+        if (load_test)
+        {
+            std::vector<arbisim::MarketUpdate> source;
+            if (load_replay.empty())
+                source = arbisim::generate_synthetic_market_data(2000, 42);
+            else if (!arbisim::load_market_data(load_replay, source) || source.empty())
+            {
+                std::cerr << "❌ Cannot read capture " << load_replay << std::endl;
+                return 1;
+            }
+            engine.enable_load_test(std::move(source));
+        }
+
         engine.start();
 
+        if (load_test)
+        {
+            auto steps = engine.run_load_test(load_config, []()
+                                              { return g_shutdown.load(); });
+            double capacity = 0.0;
+            for (const auto &step : steps)
+                if (!step.saturated)
+                    capacity = std::max(capacity, step.throughput);
+            std::cout << "\n[LOAD] Sustained " << std::fixed << std::setprecision(0) << capacity
+                      << " updates/s within the p99 SLO of " << load_config.slo_p99_ns / 1000 << " us" << std::endl;
+            if (arbisim::OpenLoopLoadGenerator::write_csv(load_out, steps))
+                std::cout << "[LOAD] Curve written to " << load_out << std::endl;
+            else
+                std::cerr << "[LOAD] Cannot write " << load_out << std::endl;
+        }
+
         // Wait for shutdown signal
-        while (!g_shutdown.load())
+        while (!load_test && !g_shutdown.load())
         {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
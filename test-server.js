@@ -1,3 +1,5 @@
+// CSV-tailing bridge for the dashboard. The engine now serves ws://127.0.0.1:8080
+// itself; run this only alongside `arbisim --no-dashboard` (both need port 8080).
 console.log("✅ Server ready! Open dashboard.html in your browser"); 
 const WebSocket = require("ws");
 const fs = require("fs");
@@ -14,6 +16,8 @@ console.log(`📄 Watching file: ${CSV_FILE}`);
 
 let connectedClients = [];
 let lastPosition = 0;
+let lastIno = null; // Identity of the file lastPosition belongs to
+let lastBirthtime = null;
 
 // Track latest prices for each exchange
 let exchangePrices = {
@@ -30,6 +34,17 @@ function watchCSVFile() {
   }
 
   const stats = fs.statSync(CSV_FILE);
+  // The engine rotated the log: start over on the fresh file. A new inode or birth
+  // time catches a new file that has already grown past our old offset.
+  const replaced =
+    lastIno !== null &&
+    (stats.ino !== lastIno || stats.birthtimeMs !== lastBirthtime);
+  if (replaced || stats.size < lastPosition) {
+    console.log(`🔄 ${CSV_FILE} rotated, reading from the start`);
+    lastPosition = 0;
+  }
+  lastIno = stats.ino;
+  lastBirthtime = stats.birthtimeMs;
   if (stats.size > lastPosition) {
     const stream = fs.createReadStream(CSV_FILE, { start: lastPosition });
     let buffer = "";
@@ -42,7 +57,9 @@ function watchCSVFile() {
       lines.forEach((line) => {
         if (line.trim() && !line.startsWith("timestamp")) {
           const opportunity = parseCSVLine(line);
-          if (opportunity) {
+          if (opportunity && opportunity.type === "opportunity_close") {
+            broadcastMessage(opportunity);
+          } else if (opportunity) {
             broadcastOpportunity(opportunity);
             updateExchangePrices(opportunity);
           }
@@ -68,9 +85,13 @@ function parseCSVLine(line) {
   const parts = line.split(",");
   if (parts.length < 10) return null;
 
+  // Lifecycle columns: event 0 = OPEN, 1 = UPDATE, 2 = CLOSE
+  const event = parts.length > 10 ? parseInt(parts[10]) : 0;
+  const durationNs = parts.length > 11 ? parseInt(parts[11]) : 0;
+
   try {
     return {
-      type: "opportunity",
+      type: event === 2 ? "opportunity_close" : "opportunity",
       opportunity: {
         symbol: parts[1],
         buy_exchange: parts[2],
@@ -82,6 +103,8 @@ function parseCSVLine(line) {
         latency_ns: parseInt(parts[8]),
         approved: parts[9] === "0", // 0 = APPROVED in your system
         detected_at_ns: parseInt(parts[0]),
+        event: ["open", "update", "close"][event] || "open",
+        duration_ns: durationNs,
       },
     };
   } catch (error) {
@@ -108,6 +131,15 @@ function broadcastOpportunity(opportunity) {
   });
 }
 
+function broadcastMessage(payload) {
+  const message = JSON.stringify(payload);
+  connectedClients.forEach((ws) => {
+    if (ws.readyState === WebSocket.OPEN) {
+      ws.send(message);
+    }
+  });
+}
+
 function broadcastPriceUpdate(exchange, price) {
   const message = JSON.stringify({
     type: "price_update",
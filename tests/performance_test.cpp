@@ -1,8 +1,29 @@
 #include "../include/arbisim_core.h"
+#include "../include/risk_management.h"
+#include "../include/scenario_engine.h"
+#include "../include/execution_simulator.h"
+#include "../include/opportunity_queue.h"
+#include "../include/conflating_queue.h"
+#include "../include/async_log_writer.h"
+#include "../include/columnar_log.h"
+#include "../include/log_analytics.h"
+#include "../include/dashboard_server.h"
+#include "../include/latency_histogram.h"
+#include "../include/pipeline_trace.h"
+#include "../include/metrics_registry.h"
+#include "../include/metrics_server.h"
+#include "../include/microbench.h"
+#include "../include/load_generator.h"
+#include "../include/alloc_tracker.h"
+#include "../include/backtester.h"
 #include <iostream>
 #include <chrono>
 #include <vector>
 #include <random>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
 
 using namespace arbisim;
 
@@ -67,17 +88,20 @@ void test_arbitrage_detection_performance()
     // Set up crossed books to create arbitrage opportunities
     book1->update_bid(50000.0, 100.0);
     book1->update_ask(50002.0, 100.0);
-    book2->update_bid(50001.0, 100.0);
-    book2->update_ask(50003.0, 100.0);
+    book2->update_bid(50150.0, 100.0); // clears 10 bps taker fees per side
+    book2->update_ask(50152.0, 100.0);
 
     const int num_checks = 100000;
     auto start = std::chrono::high_resolution_clock::now();
 
     int total_opportunities = 0;
+    double executable_size = 0.0;
     for (int i = 0; i < num_checks; ++i)
     {
         auto opportunities = detector.check_arbitrage("BTCUSDT", timestamp_ns());
         total_opportunities += opportunities.size();
+        if (!opportunities.empty())
+            executable_size = opportunities.front().max_quantity;
     }
 
     auto end = std::chrono::high_resolution_clock::now();
@@ -87,12 +111,1767 @@ void test_arbitrage_detection_performance()
 
     std::cout << "\n=== Arbitrage Detection Performance ===" << std::endl;
     std::cout << "Arbitrage checks: " << num_checks << std::endl;
-    std::cout << "Total opportunities found: " << total_opportunities << std::endl;
+    auto lifecycle = detector.lifecycle_stats();
+    std::cout << "Lifecycle events: " << total_opportunities << " (" << lifecycle.coalesced << " repeat detections coalesced)" << std::endl;
+    std::cout << "Executable size per opportunity: " << executable_size << std::endl;
     std::cout << "Average latency per check: " << static_cast<int>(avg_latency_ns) << " ns" << std::endl;
     std::cout << "Checks per second: " << static_cast<int>(num_checks / (duration.count() / 1e9)) << std::endl;
     std::cout << "======================================" << std::endl;
 }
 
+bool test_opportunity_lifecycle()
+{
+    ArbitrageDetector detector;
+    detector.add_orderbook("BTCUSDT", "exchange1");
+    detector.add_orderbook("BTCUSDT", "exchange2");
+    detector.set_min_profit_bps(1.0);
+
+    auto *book1 = detector.get_orderbook("BTCUSDT", "exchange1");
+    auto *book2 = detector.get_orderbook("BTCUSDT", "exchange2");
+    book1->update_bid(50000.0, 10.0);
+    book1->update_ask(50002.0, 10.0);
+    book2->update_bid(50150.0, 10.0);
+    book2->update_ask(50152.0, 10.0);
+
+    auto first = detector.check_arbitrage("BTCUSDT", timestamp_ns());
+    auto repeat = detector.check_arbitrage("BTCUSDT", timestamp_ns());
+    book2->update_bid(50170.0, 10.0); // ~4 bps better bid
+    auto moved = detector.check_arbitrage("BTCUSDT", timestamp_ns());
+    book2->update_bid(50170.0, 0.0); // Pull both crossing bids
+    book2->update_bid(50150.0, 0.0);
+    auto gone = detector.check_arbitrage("BTCUSDT", timestamp_ns());
+
+    bool ok = first.size() == 1 && first[0].event == OpportunityEvent::OPEN &&
+              repeat.empty() &&
+              moved.size() == 1 && moved[0].event == OpportunityEvent::UPDATE &&
+              gone.size() == 1 && gone[0].event == OpportunityEvent::CLOSE &&
+              gone[0].sell_price == 50170.0 && gone[0].opened_at_ns == first[0].detected_at_ns;
+
+    auto stats = detector.lifecycle_stats();
+    ok = ok && stats.opened == 1 && stats.updated == 1 && stats.closed == 1 &&
+         stats.coalesced == 1 && stats.open_now == 0;
+
+    std::cout << "\n=== Opportunity Lifecycle ===" << std::endl;
+    std::cout << "OPEN / repeat / UPDATE / CLOSE: " << first.size() << " / " << repeat.size() << " / "
+              << moved.size() << " / " << gone.size() << (ok ? " (ok)" : " (WRONG)") << std::endl;
+    std::cout << "Lifetime: " << (gone.empty() ? 0 : gone[0].duration_ns) << " ns" << std::endl;
+    std::cout << "=============================" << std::endl;
+    return ok;
+}
+
+bool test_update_conflation_performance()
+{
+    const char *venues[] = {"exchange1", "exchange2", "exchange3", "exchange4"};
+    ArbitrageDetector detector;  // Detection after every update
+    ArbitrageDetector conflated; // Detection once per drained batch
+    for (const char *venue : venues)
+    {
+        detector.add_orderbook("BTCUSDT", venue);
+        conflated.add_orderbook("BTCUSDT", venue);
+    }
+
+    // 10x burst: ten quotes per book pending before the market thread gets to them, and
+    // every other round deletes the previous round's bid
+    std::mt19937 gen(7);
+    std::normal_distribution<> price_dist(50000.0, 50.0);
+    std::vector<MarketUpdate> burst;
+    std::vector<double> last_bid(4, 0.0);
+    size_t deletes_per_burst = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        for (int v = 0; v < 4; ++v)
+        {
+            double mid = price_dist(gen);
+            if (i % 2 == 1)
+            {
+                burst.emplace_back(MarketUpdate::BID_UPDATE, "BTCUSDT", venues[v], last_bid[v], 0.0);
+                deletes_per_burst++;
+            }
+            burst.emplace_back(MarketUpdate::BID_UPDATE, "BTCUSDT", venues[v], mid - 0.5, 1.0);
+            burst.emplace_back(MarketUpdate::ASK_UPDATE, "BTCUSDT", venues[v], mid + 0.5, 1.0);
+            last_bid[v] = mid - 0.5;
+        }
+    }
+
+    auto apply = [](ArbitrageDetector &target, const MarketUpdate &update)
+    {
+        auto *book = target.get_orderbook(update.symbol, update.exchange);
+        if (update.type == MarketUpdate::BID_UPDATE)
+            book->update_bid(update.price, update.quantity);
+        else
+            book->update_ask(update.price, update.quantity);
+    };
+
+    const int num_bursts = 2000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int b = 0; b < num_bursts; ++b)
+    {
+        for (const auto &update : burst)
+        {
+            apply(detector, update);
+            detector.check_arbitrage(update.symbol, timestamp_ns());
+        }
+    }
+    auto per_update_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::high_resolution_clock::now() - start)
+                             .count();
+
+    ConflatingUpdateQueue queue;
+    std::vector<MarketUpdate> drained;
+    bool deletes_kept = true;
+    start = std::chrono::high_resolution_clock::now();
+    for (int b = 0; b < num_bursts; ++b)
+    {
+        for (const auto &update : burst)
+            queue.push(update);
+        queue.drain(drained, std::chrono::milliseconds(0));
+        size_t deletes = 0;
+        for (const auto &update : drained)
+            deletes += update.quantity == 0.0;
+        deletes_kept = deletes_kept && deletes == deletes_per_burst;
+        for (const auto &update : drained)
+            apply(conflated, update);
+        conflated.check_arbitrage("BTCUSDT", timestamp_ns());
+    }
+    auto conflated_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::high_resolution_clock::now() - start)
+                            .count();
+
+    // Conflation saves detection passes only: every book ends where the unconflated one
+    // did, and the first round's bids (deleted in the second) are gone from both
+    bool same_books = true;
+    for (int v = 0; v < 4; ++v)
+    {
+        const auto *a = detector.get_orderbook("BTCUSDT", venues[v]);
+        const auto *b = conflated.get_orderbook("BTCUSDT", venues[v]);
+        same_books = same_books && a->bid_depth() == b->bid_depth() && a->ask_depth() == b->ask_depth();
+        for (size_t i = 0; same_books && i < a->bid_depth(); ++i)
+            same_books = a->bid_level(i).price == b->bid_level(i).price && a->bid_level(i).quantity == b->bid_level(i).quantity &&
+                         a->bid_level(i).price != burst[v * 2].price;
+        for (size_t i = 0; same_books && i < a->ask_depth(); ++i)
+            same_books = a->ask_level(i).price == b->ask_level(i).price && a->ask_level(i).quantity == b->ask_level(i).quantity;
+    }
+
+    auto stats = queue.get_stats();
+    double ratio = stats.drain_cycles ? static_cast<double>(stats.drained) / stats.drain_cycles : 0.0;
+    bool conflates = stats.drained == burst.size() * num_bursts && ratio > 1.0;
+
+    std::cout << "\n=== Update Conflation (10x burst) ===" << std::endl;
+    std::cout << "Updates per detection pass: " << ratio << ": " << (conflates ? "ok" : "WRONG") << std::endl;
+    std::cout << "Books match unconflated, deletes kept: " << (same_books && deletes_kept ? "ok" : "WRONG") << std::endl;
+    std::cout << "Time per burst, detect every update: " << (per_update_ns / num_bursts / 1000) << " us" << std::endl;
+    std::cout << "Time per burst, conflated: " << (conflated_ns / num_bursts / 1000) << " us" << std::endl;
+    std::cout << "=====================================" << std::endl;
+    return conflates && same_books && deletes_kept;
+}
+
+bool test_async_log_writer()
+{
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "arbisim_log_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    AsyncLogConfig config;
+    config.path = (dir / "opps.csv").string();
+    config.max_file_bytes = 1024 * 1024; // Force a few rotations
+    config.flush_interval_ms = 10;
+
+    AsyncLogWriter writer;
+    if (!writer.start(config))
+        return false;
+
+    ArbitrageOpportunity opp("BTCUSDT", "binance", "kraken", 50000.0, 50100.0, timestamp_ns());
+    OpportunityRecord record(opp, opp.net_profit_bps, 0);
+
+    const int num_records = 100000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_records; ++i)
+    {
+        record.detected_at_ns++;
+        while (!writer.log(record))
+            std::this_thread::yield(); // Test only: the engine drops instead of waiting
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    writer.stop();
+
+    // Every row lands in exactly one file, each starting with its own header
+    size_t rows = 0, files = 0;
+    for (const auto &entry : fs::directory_iterator(dir))
+    {
+        std::ifstream in(entry.path());
+        std::string line;
+        files++;
+        while (std::getline(in, line))
+            rows++;
+    }
+    auto stats = writer.get_stats();
+    bool ok = stats.written == static_cast<uint64_t>(num_records) &&
+              rows == num_records + files && files == stats.rotations + 1;
+    fs::remove_all(dir);
+
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    std::cout << "\n=== Async Log Writer ===" << std::endl;
+    std::cout << "Records: " << num_records << " in " << stats.batches << " batches, "
+              << stats.rotations << " rotations" << (ok ? " (ok)" : " (WRONG)") << std::endl;
+    std::cout << "Average enqueue latency: " << (duration.count() / num_records) << " ns" << std::endl;
+    std::cout << "========================" << std::endl;
+    return ok;
+}
+
+bool test_columnar_log()
+{
+    namespace fs = std::filesystem;
+    fs::path path = fs::temp_directory_path() / "arbisim_columnar_test.arbcol";
+
+    const char *venues[] = {"binance", "coinbase", "kraken", "bybit"};
+    std::mt19937 gen(11);
+    std::normal_distribution<> price_dist(50000.0, 40.0);
+    std::uniform_int_distribution<> venue_dist(0, 3);
+
+    std::vector<OpportunityRecord> records;
+    uint64_t ts = timestamp_ns();
+    for (int i = 0; i < 50000; ++i)
+    {
+        int buy = venue_dist(gen), sell = (buy + 1 + venue_dist(gen) % 3) % 4;
+        ArbitrageOpportunity opp("BTCUSDT", venues[buy], venues[sell],
+                                 std::round(price_dist(gen) * 100.0) / 100.0,
+                                 std::round(price_dist(gen) * 100.0) / 100.0, ts);
+        ts += 1000 + gen() % 50000000;
+        opp.detected_at_ns = ts;
+        opp.latency_ns = gen() % 100000;
+        opp.event = static_cast<OpportunityEvent>(i % 3);
+        opp.duration_ns = gen() % 1000000000;
+        records.emplace_back(opp, std::round(opp.net_profit_bps * 10.0) / 10.0, i % 10 - 1);
+        records.back().profit_bps = std::round(records.back().profit_bps * 10.0) / 10.0;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        ColumnarLogWriter<OpportunityColumns> writer(4096);
+        if (!writer.open(path.string()))
+            return false;
+        writer.append(records.begin(), records.end());
+    }
+    auto write_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::high_resolution_clock::now() - start)
+                        .count();
+    size_t binary_bytes = fs::file_size(path);
+
+    // Round trip, field by field
+    ColumnarLogReader<OpportunityColumns> reader;
+    std::vector<OpportunityRecord> block, decoded;
+    reader.open(path.string());
+    while (reader.next_block(block))
+        decoded.insert(decoded.end(), block.begin(), block.end());
+    reader.close();
+
+    bool ok = decoded.size() == records.size();
+    size_t csv_bytes = 0;
+    char row[256];
+    for (size_t i = 0; ok && i < records.size(); ++i)
+    {
+        const auto &a = records[i];
+        const auto &b = decoded[i];
+        ok = a.detected_at_ns == b.detected_at_ns && a.latency_ns == b.latency_ns &&
+             a.duration_ns == b.duration_ns && a.buy_price == b.buy_price && a.sell_price == b.sell_price &&
+             a.profit_bps == b.profit_bps && a.net_profit_bps == b.net_profit_bps &&
+             a.decision == b.decision && a.event == b.event &&
+             std::strcmp(a.buy_exchange, b.buy_exchange) == 0 && std::strcmp(a.sell_exchange, b.sell_exchange) == 0 &&
+             std::strcmp(a.symbol, b.symbol) == 0;
+        csv_bytes += csv::format_opportunity_csv(a, row, row + sizeof(row)) - row;
+    }
+
+    // A torn final block is reported, and the blocks before it still read back
+    fs::resize_file(path, binary_bytes - 10);
+    size_t partial = 0;
+    reader.open(path.string());
+    while (reader.next_block(block))
+        partial += block.size();
+    ok = ok && reader.corrupt() && partial > 0 && partial < records.size() && partial % 4096 == 0;
+    reader.close();
+    fs::remove(path);
+
+    std::cout << "\n=== Columnar Log ===" << std::endl;
+    std::cout << "Rows: " << records.size() << ", round trip " << (ok ? "ok" : "WRONG") << std::endl;
+    std::cout << "Size: " << binary_bytes << " bytes vs " << csv_bytes << " bytes as CSV ("
+              << std::fixed << std::setprecision(1) << (static_cast<double>(csv_bytes) / binary_bytes) << "x)" << std::endl;
+    std::cout << "Write: " << (write_ns / records.size()) << " ns per row" << std::endl;
+    std::cout << "====================" << std::endl;
+    return ok;
+}
+
+bool test_log_analytics()
+{
+    const char *venues[] = {"binance", "coinbase", "kraken", "bybit"};
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<> venue_dist(0, 3);
+    std::uniform_int_distribution<> decision_dist(-1, 9);
+    std::exponential_distribution<> profit_dist(0.02);
+
+    const size_t rows = 500000;
+    std::vector<OpportunityRecord> records(rows);
+    uint64_t ts = timestamp_ns();
+    for (auto &r : records)
+    {
+        int buy = venue_dist(gen), sell = (buy + 1 + venue_dist(gen) % 3) % 4;
+        std::strcpy(r.symbol, "BTCUSDT");
+        std::strcpy(r.buy_exchange, venues[buy]);
+        std::strcpy(r.sell_exchange, venues[sell]);
+        r.detected_at_ns = ts += gen() % 20000000;
+        r.latency_ns = 20000 + gen() % 200000;
+        r.profit_bps = profit_dist(gen);
+        r.net_profit_bps = r.profit_bps - 20.0;
+        r.decision = static_cast<int8_t>(decision_dist(gen));
+        r.event = static_cast<uint8_t>(r.decision < 0 ? 2 : gen() % 2);
+    }
+
+    WorkStealingPool pool;
+    OpportunityTable table;
+    table.add_rows(records.data(), records.size(), 0, UINT64_MAX);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto groups = aggregate_opportunities(table, pool, analytics::BY_PAIR | analytics::BY_DECISION);
+    auto query_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::high_resolution_clock::now() - start)
+                        .count();
+
+    // Reference: the same aggregates row by row
+    struct Expected
+    {
+        uint64_t count = 0, approved = 0;
+        double profit = 0.0;
+        std::vector<double> profits;
+        std::vector<uint64_t> latencies;
+    };
+    std::map<std::pair<std::string, int>, Expected> expected;
+    std::string key;
+    for (const auto &r : records)
+    {
+        if (r.event == 2)
+            continue;
+        analytics::pair_key(r, key);
+        Expected &e = expected[{key, r.decision}];
+        e.count++;
+        e.approved += r.decision == 0;
+        e.profit += r.profit_bps;
+        e.profits.push_back(r.profit_bps);
+        e.latencies.push_back(r.latency_ns);
+    }
+
+    bool ok = groups.size() == expected.size();
+    for (const auto &g : groups)
+    {
+        auto it = expected.find({table.pairs.names[g.pair], g.decision});
+        if (it == expected.end())
+        {
+            ok = false;
+            break;
+        }
+        Expected &e = it->second;
+        std::sort(e.profits.begin(), e.profits.end());
+        std::sort(e.latencies.begin(), e.latencies.end());
+        size_t p99 = std::min(e.count - 1, static_cast<uint64_t>(0.99 * e.count));
+        size_t p50 = std::min(e.count - 1, static_cast<uint64_t>(0.50 * e.count));
+        ok = ok && g.count == e.count &&
+             std::abs(g.mean_profit_bps - e.profit / e.count) < 1e-9 &&
+             g.approval_rate == static_cast<double>(e.approved) / e.count &&
+             g.p99_profit_bps == e.profits[p99] &&
+             g.p50_latency_ns == e.latencies[p50] && g.p99_latency_ns == e.latencies[p99];
+    }
+
+    std::cout << "\n=== Log Analytics ===" << std::endl;
+    std::cout << "Rows: " << rows << ", groups: " << groups.size() << ", matches reference: " << (ok ? "yes" : "NO") << std::endl;
+    std::cout << "Group-by query: " << std::fixed << std::setprecision(2) << (query_ns / 1e6) << " ms ("
+              << std::setprecision(1) << (static_cast<double>(query_ns) / rows) << " ns per row, "
+              << pool.thread_count() << " threads)" << std::endl;
+    std::cout << "=====================" << std::endl;
+    return ok;
+}
+
+bool test_dashboard_server()
+{
+    DashboardServerConfig config;
+    config.port = 0; // Any free port, so the test never collides with a running engine
+    DashboardServer server;
+    if (!server.start(config))
+        return false;
+
+    net::socket_t client = net::connect_tcp("127.0.0.1", server.port());
+    if (client == net::INVALID_SOCKET_VALUE)
+        return false;
+
+    // Read until pred(received) holds or a second passes
+    std::string received;
+    auto read_until = [&](auto pred)
+    {
+        char buffer[4096];
+        uint64_t deadline = timestamp_ns() + 1000000000ULL;
+        while (!pred(received) && timestamp_ns() < deadline)
+        {
+            net::PollFd fd{};
+            fd.fd = client;
+            fd.events = POLLIN;
+            if (net::poll_sockets(&fd, 1, 10) <= 0)
+                continue;
+            long n = net::recv_some(client, buffer, sizeof(buffer));
+            if (n < 0)
+                break;
+            received.append(buffer, static_cast<size_t>(n));
+        }
+        return pred(received);
+    };
+
+    // Handshake example from RFC 6455 section 1.3
+    std::string request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    net::send_some(client, request.data(), request.size());
+    bool ok = read_until([](const std::string &r)
+                         { return r.find("\r\n\r\n") != std::string::npos; }) &&
+              received.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") != std::string::npos;
+
+    // Publish to first byte on the client, repeated
+    ArbitrageOpportunity opp("BTCUSDT", "binance", "kraken", 50000.0, 50100.0, timestamp_ns());
+    std::vector<uint64_t> latencies;
+    for (int i = 0; ok && i < 50; ++i)
+    {
+        received.clear();
+        uint64_t start = timestamp_ns();
+        server.publish(OpportunityRecord(opp, 12.5, 0));
+        ok = read_until([](const std::string &r)
+                        { return r.find("\"type\":\"opportunity\"") != std::string::npos && r.back() == '}'; });
+        latencies.push_back(timestamp_ns() - start);
+    }
+    ok = ok && received.find("\"approved\":true") != std::string::npos &&
+         received.find("\"net_profit_bps\":12.5") != std::string::npos;
+
+    net::close_socket(client);
+    auto stats = server.get_stats();
+    server.stop();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "\n=== Dashboard Stream ===" << std::endl;
+    std::cout << "Handshake and frames: " << (ok ? "ok" : "WRONG") << std::endl;
+    if (!latencies.empty())
+    {
+        std::cout << "Publish to client: p50 " << std::fixed << std::setprecision(2)
+                  << (latencies[latencies.size() / 2] / 1e6) << " ms, max " << (latencies.back() / 1e6)
+                  << " ms (poll interval " << config.poll_interval_ms << " ms)" << std::endl;
+    }
+    std::cout << "Messages: " << stats.sent_messages << ", bytes: " << stats.sent_bytes << std::endl;
+    std::cout << "========================" << std::endl;
+    return ok;
+}
+
+bool test_dashboard_aggregation()
+{
+    // Bars from synthetic times: two 100 ms intervals, the second quiet
+    DashboardAggregator aggregator;
+    uint64_t t0 = 1000000000000ULL; // On a 1 m boundary
+    ArbitrageOpportunity opp("BTCUSDT", "binance", "kraken", 50000.0, 50100.0, t0);
+    ArbitrageOpportunity other("BTCUSDT", "bybit", "coinbase", 50000.0, 50050.0, t0);
+    for (int i = 0; i < 100; ++i)
+    {
+        OpportunityRecord record(i % 4 == 0 ? other : opp, 10.0, i % 2 == 0 ? 0 : 1);
+        record.latency_ns = (i + 1) * 1000; // 1..100 us
+        aggregator.add_opportunity(record, t0 + i * 10000);
+    }
+    aggregator.add_opportunity(OpportunityRecord(opp, 10.0, -1), t0 + 2000000);
+    OhlcBar spread;
+    for (double bps : {-3.0, 1.5, -6.0, -2.0})
+        spread.add(bps);
+    aggregator.add_spread(spread, t0 + 3000000);
+
+    std::vector<std::pair<size_t, DashboardBar>> bars;
+    auto collect = [&](size_t resolution, const DashboardBar &bar)
+    { bars.emplace_back(resolution, bar); };
+    aggregator.advance(t0 + 50000000, collect); // Nothing due yet
+    bool ok = bars.empty();
+    aggregator.advance(t0 + 100000000, collect);
+    ok = ok && bars.size() == 1 && bars[0].first == 0;
+    if (ok)
+    {
+        const DashboardBar &bar = bars[0].second;
+        uint64_t p50 = bar.latency_ns.percentile(0.50), p99 = bar.latency_ns.percentile(0.99);
+        ok = bar.start_ns == t0 && bar.opportunities == 100 && bar.closed == 1 && bar.approved == 50 &&
+             bar.spread_bps.open == -3.0 && bar.spread_bps.high == 1.5 && bar.spread_bps.low == -6.0 &&
+             bar.spread_bps.close == -2.0 && bar.pair_count == 2 && bar.pairs[0].count + bar.pairs[1].count == 100 &&
+             p50 >= 45000 && p50 <= 58000 && p99 >= 95000 && p99 <= 100000 && bar.latency_ns.max() == 100000;
+    }
+    bars.clear();
+    aggregator.advance(t0 + 200000000, collect); // Quiet interval carries the last close
+    ok = ok && bars.size() == 1 && bars[0].second.opportunities == 0 && bars[0].second.spread_bps.open == -2.0 &&
+         bars[0].second.spread_bps.close == -2.0;
+
+    // Sampled stream: the best event per pair, once per 100 ms
+    size_t samples = 0;
+    aggregator.take_samples(t0 + 200000000, [&](const OpportunityRecord &)
+                            { samples++; });
+    ok = ok && samples == 2;
+
+    // Over the wire: a bars-only subscriber receives no raw events during a burst
+    DashboardServerConfig config;
+    config.port = 0;
+    config.ring_capacity = 1 << 16;
+    DashboardServer server;
+    if (!server.start(config))
+        return false;
+    net::socket_t client = net::connect_tcp("127.0.0.1", server.port());
+    if (client == net::INVALID_SOCKET_VALUE)
+        return false;
+
+    std::string received;
+    auto read_until = [&](auto pred, uint64_t timeout_ns)
+    {
+        char buffer[16384];
+        uint64_t deadline = timestamp_ns() + timeout_ns;
+        while (!pred(received) && timestamp_ns() < deadline)
+        {
+            net::PollFd fd{};
+            fd.fd = client;
+            fd.events = POLLIN;
+            if (net::poll_sockets(&fd, 1, 10) <= 0)
+                continue;
+            long n = net::recv_some(client, buffer, sizeof(buffer));
+            if (n < 0)
+                break;
+            received.append(buffer, static_cast<size_t>(n));
+        }
+        return pred(received);
+    };
+    auto count = [](const std::string &r, const char *needle)
+    {
+        size_t n = 0;
+        for (size_t at = r.find(needle); at != std::string::npos; at = r.find(needle, at + 1))
+            n++;
+        return n;
+    };
+
+    std::string request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    net::send_some(client, request.data(), request.size());
+
+    // Client frames are masked; an all-zero mask leaves the payload as is
+    std::string subscribe = "{\"type\":\"subscribe\",\"events\":\"none\",\"bars\":[\"100ms\"]}";
+    std::string frame;
+    frame += static_cast<char>(0x81);
+    frame += static_cast<char>(0x80 | subscribe.size());
+    frame.append(4, '\0');
+    frame += subscribe;
+    net::send_some(client, frame.data(), frame.size());
+    ok = ok && read_until([](const std::string &r)
+                          { return r.find("\"type\":\"subscribed\",\"events\":\"none\",\"bars\":[\"100ms\"]") != std::string::npos; },
+                          1000000000ULL);
+
+    const int burst = 20000;
+    uint64_t start = timestamp_ns();
+    for (int i = 0; i < burst; ++i)
+        server.publish(OpportunityRecord(opp, 10.0, 0));
+    server.publish_spread(4.0);
+    uint64_t publish_ns = timestamp_ns() - start;
+
+    // Every event is accounted for in the bars' counts
+    auto bar_total = [](const std::string &r)
+    {
+        uint64_t total = 0;
+        const char key[] = "\"opportunities\":";
+        for (size_t at = r.find(key); at != std::string::npos; at = r.find(key, at + 1))
+            total += std::strtoull(r.c_str() + at + sizeof(key) - 1, nullptr, 10);
+        return total;
+    };
+    received.clear();
+    ok = ok && read_until([&](const std::string &r)
+                          { return bar_total(r) >= static_cast<uint64_t>(burst) && r.back() == '}'; },
+                          2000000000ULL);
+    size_t bar_messages = count(received, "\"type\":\"bar\"");
+    ok = ok && bar_total(received) == static_cast<uint64_t>(burst) &&
+         count(received, "\"type\":\"opportunity\"") == 0 && bar_messages <= 4 &&
+         received.find("\"high\":4.00") != std::string::npos;
+
+    net::close_socket(client);
+    auto stats = server.get_stats();
+    server.stop();
+
+    std::cout << "\n=== Dashboard Aggregation ===" << std::endl;
+    std::cout << "Bars, carry-over and sampling: " << (ok ? "ok" : "WRONG") << std::endl;
+    std::cout << "Burst of " << burst << " events: " << bar_messages << " bar messages, " << received.size()
+              << " bytes to a bars-only client (publish " << std::fixed << std::setprecision(1)
+              << (static_cast<double>(publish_ns) / burst) << " ns/event, lost " << stats.lost << ")" << std::endl;
+    std::cout << "=============================" << std::endl;
+    return ok;
+}
+
+bool test_latency_histogram()
+{
+    // Heavy-tailed latencies from 10 ns to 10 s, recorded from four threads
+    const int threads = 4, per_thread = 250000;
+    std::vector<std::vector<uint64_t>> samples(threads);
+    for (int t = 0; t < threads; ++t)
+    {
+        std::mt19937_64 gen(t + 1);
+        std::lognormal_distribution<> dist(9.0, 2.0); // Median ~8 us
+        for (int i = 0; i < per_thread; ++i)
+            samples[t].push_back(std::clamp<uint64_t>(static_cast<uint64_t>(dist(gen)), 10, 10000000000ULL));
+    }
+
+    ConcurrentLatencyHistogram shared;
+    std::vector<LatencyHistogram> local(threads);
+    std::vector<std::thread> writers;
+    uint64_t start = timestamp_ns();
+    for (int t = 0; t < threads; ++t)
+    {
+        writers.emplace_back([&, t]()
+                             {
+            for (uint64_t v : samples[t])
+            {
+                shared.record(v);
+                local[t].record(v);
+            } });
+    }
+    for (auto &w : writers)
+        w.join();
+    uint64_t record_ns = timestamp_ns() - start;
+
+    LatencyHistogram merged, drained;
+    for (const auto &h : local)
+        merged.merge(h);
+    shared.drain_into(drained);
+
+    std::vector<uint64_t> all;
+    for (const auto &s : samples)
+        all.insert(all.end(), s.begin(), s.end());
+    std::sort(all.begin(), all.end());
+
+    // Every percentile within one bucket (1/64) of the exact value, from either path
+    bool ok = merged.count() == all.size() && drained.count() == all.size() && merged.max() == all.back() &&
+              drained.min() == all.front();
+    double worst_error = 0.0;
+    for (double q : {0.5, 0.9, 0.99, 0.999, 0.9999})
+    {
+        uint64_t exact = all[std::min(all.size() - 1, static_cast<size_t>(q * all.size()))];
+        for (const LatencyHistogram *h : {&merged, &drained})
+        {
+            double error = std::abs(static_cast<double>(h->percentile(q)) - exact) / exact;
+            worst_error = std::max(worst_error, error);
+        }
+    }
+    ok = ok && worst_error <= 1.0 / 64;
+
+    // Draining starts a new interval
+    LatencyHistogram empty;
+    shared.drain_into(empty);
+    shared.record(500);
+    LatencyHistogram interval;
+    shared.drain_into(interval);
+    ok = ok && empty.count() == 0 && interval.count() == 1 && interval.percentile(0.99) == 500 && interval.max() == 500;
+
+    std::cout << "\n=== Latency Histogram ===" << std::endl;
+    std::cout << "Percentiles, merge and interval reset: " << (ok ? "ok" : "WRONG") << " (worst error "
+              << std::fixed << std::setprecision(2) << worst_error * 100 << "%)" << std::endl;
+    std::cout << "p50 / p99 / p99.99: " << merged.percentile(0.5) / 1000.0 << " / " << merged.percentile(0.99) / 1000.0
+              << " / " << merged.percentile(0.9999) / 1000.0 << " us" << std::endl;
+    std::cout << "Record (shared + per-thread): " << std::setprecision(1)
+              << (static_cast<double>(record_ns) / all.size()) << " ns per value (" << threads << " threads)" << std::endl;
+    std::cout << "=========================" << std::endl;
+    return ok;
+}
+
+bool test_pipeline_trace()
+{
+    // Disabled: begin_trace hands out 0 and nothing is recorded
+    PipelineTracer off;
+    const int calls = 1000000;
+    uint64_t start = timestamp_ns();
+    uint64_t ids = 0;
+    for (int i = 0; i < calls; ++i)
+    {
+        uint64_t id = off.begin_trace();
+        off.record(TraceStage::FEED, id, 0, 0);
+        ids += id;
+    }
+    uint64_t disabled_ns = timestamp_ns() - start;
+
+    // Two producer threads, one update in four sampled, each traced update leaves a
+    // feed span on its producer and a book_apply span on a consumer thread
+    PipelineTracer tracer;
+    TraceConfig config;
+    config.enabled = true;
+    config.sample_every = 4;
+    config.events_per_thread = 1024;
+    tracer.configure(config);
+
+    std::mutex handoff_mutex;
+    std::vector<uint64_t> handoff;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 2; ++t)
+    {
+        producers.emplace_back([&, t]()
+                               {
+            tracer.name_thread("producer " + std::to_string(t));
+            for (int i = 0; i < 200; ++i)
+            {
+                uint64_t begin = timestamp_ns();
+                uint64_t id = tracer.begin_trace();
+                tracer.record(TraceStage::FEED, id, begin, timestamp_ns());
+                if (id)
+                {
+                    std::lock_guard<std::mutex> lock(handoff_mutex);
+                    handoff.push_back(id);
+                }
+            } });
+    }
+    for (auto &p : producers)
+        p.join();
+    std::thread consumer([&]()
+                         {
+        tracer.name_thread("consumer");
+        for (uint64_t id : handoff)
+        {
+            uint64_t begin = timestamp_ns();
+            tracer.record(TraceStage::BOOK_APPLY, id, begin, timestamp_ns());
+        } });
+    consumer.join();
+
+    std::vector<TraceEvent> events;
+    std::vector<uint32_t> tids;
+    tracer.collect(events, tids);
+    size_t feeds = std::count_if(events.begin(), events.end(), [](const TraceEvent &e)
+                                 { return e.stage == TraceStage::FEED; });
+    bool ok = ids == 0 && handoff.size() == 100 && feeds == 100 && events.size() == 200 &&
+              std::is_sorted(events.begin(), events.end(), [](const TraceEvent &a, const TraceEvent &b)
+                             { return a.begin_ns < b.begin_ns; });
+
+    // Window: only the consumer's spans started after the producers finished
+    uint64_t cutoff = events[99].begin_ns + 1;
+    std::vector<TraceEvent> late;
+    tracer.collect(late, tids, cutoff);
+    ok = ok && !late.empty() && std::all_of(late.begin(), late.end(), [](const TraceEvent &e)
+                                           { return e.stage == TraceStage::BOOK_APPLY; });
+
+    // Export: every span, a flow arrow per trace from feed to book_apply, thread names
+    std::string path = (std::filesystem::temp_directory_path() / "arbisim_trace_test.json").string();
+    long written = tracer.write_chrome_trace(path);
+    std::ifstream in(path);
+    std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto count = [&](const std::string &needle)
+    {
+        size_t n = 0;
+        for (size_t at = json.find(needle); at != std::string::npos; at = json.find(needle, at + 1))
+            n++;
+        return n;
+    };
+    ok = ok && written == 200 && count("\"ph\":\"X\"") == 200 && count("\"ph\":\"f\"") == 100 &&
+         count("\"name\":\"consumer\"") == 1 && count("\"name\":\"producer 1\"") == 1 &&
+         json.rfind("\n]}\n") == json.size() - 4;
+    std::filesystem::remove(path);
+
+    std::cout << "\n=== Pipeline Trace ===" << std::endl;
+    std::cout << "Sampling, per-thread rings, window and export: " << (ok ? "ok" : "WRONG") << std::endl;
+    std::cout << "Disabled cost: " << std::fixed << std::setprecision(2)
+              << (static_cast<double>(disabled_ns) / calls) << " ns per begin_trace + record" << std::endl;
+    std::cout << "======================" << std::endl;
+    return ok;
+}
+
+bool test_tsc_clock()
+{
+    TscClock &clock = TscClock::instance();
+
+    // Agrees with the system clock and never steps back, across at least one re-anchor
+    bool ok = true;
+    int64_t worst_offset = 0;
+    uint64_t last = 0;
+    uint64_t until = wall_clock_ns() + TscClock::RECALIBRATE_NS + 200000000ULL;
+    while (wall_clock_ns() < until)
+    {
+        uint64_t before = wall_clock_ns();
+        uint64_t ours = clock.now_ns();
+        uint64_t after = wall_clock_ns();
+        int64_t offset = static_cast<int64_t>(ours) - static_cast<int64_t>(before + (after - before) / 2);
+        worst_offset = std::max(worst_offset, std::abs(offset));
+        ok = ok && ours >= last;
+        last = ours;
+        for (int i = 0; i < 10000; ++i)
+        {
+            uint64_t t = clock.now_ns();
+            ok = ok && t >= last;
+            last = t;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ok = ok && worst_offset < 1000000 && (!clock.uses_tsc() || clock.recalibrations() >= 1);
+
+    const int calls = 1000000;
+    uint64_t sink = 0;
+    uint64_t start = wall_clock_ns();
+    for (int i = 0; i < calls; ++i)
+        sink += timestamp_ns();
+    uint64_t tsc_ns = wall_clock_ns() - start;
+    start = wall_clock_ns();
+    for (int i = 0; i < calls; ++i)
+        sink += wall_clock_ns();
+    uint64_t system_ns = wall_clock_ns() - start;
+
+    // Stamps passed down are used as given: levels carry the update's time, and every
+    // event from one detection pass shares one detection time
+    ArbitrageDetector detector;
+    for (const char *exchange : {"exchange1", "exchange2", "exchange3"})
+        detector.add_orderbook("BTCUSDT", exchange);
+    detector.set_min_profit_bps(1.0);
+    auto *book1 = detector.get_orderbook("BTCUSDT", "exchange1");
+    auto *book2 = detector.get_orderbook("BTCUSDT", "exchange2");
+    auto *book3 = detector.get_orderbook("BTCUSDT", "exchange3");
+    book1->update_ask(50000.0, 1.0, 1000);
+    book2->update_bid(50200.0, 1.0, 2000);
+    book3->update_bid(50300.0, 1.0, 3000);
+    auto events = detector.check_arbitrage("BTCUSDT", 3000);
+    ok = ok && book1->ask_level(0).timestamp_ns == 1000 && book3->bid_level(0).timestamp_ns == 3000 &&
+         events.size() == 2 && events[0].detected_at_ns == events[1].detected_at_ns &&
+         events[0].latency_ns == events[0].detected_at_ns - 3000 && sink != 0;
+
+    std::cout << "\n=== Clock ===" << std::endl;
+    std::cout << "Source: " << (clock.uses_tsc() ? "invariant TSC" : "system clock");
+    if (clock.uses_tsc())
+        std::cout << " (" << std::fixed << std::setprecision(3) << clock.ghz() << " GHz, "
+                  << clock.recalibrations() << " re-anchors)";
+    std::cout << std::endl;
+    std::cout << "Tracking, monotonicity and stamp passing: " << (ok ? "ok" : "WRONG") << " (worst offset "
+              << std::fixed << std::setprecision(1) << worst_offset / 1000.0 << " us)" << std::endl;
+    std::cout << "timestamp_ns(): " << std::setprecision(2) << (static_cast<double>(tsc_ns) / calls)
+              << " ns per call vs " << (static_cast<double>(system_ns) / calls) << " ns for the system clock" << std::endl;
+    std::cout << "=============" << std::endl;
+    return ok;
+}
+
+bool test_metrics_registry()
+{
+    MetricsRegistry metrics;
+    uint32_t events = metrics.counter("events");
+    uint32_t depth = metrics.gauge("depth");
+    uint32_t latency = metrics.histogram("latency_ns");
+    bool ok = metrics.counter("events") == events;
+
+    // Four writers on their own shards against four on one shared atomic
+    const int threads = 4, per_thread = 1000000;
+    std::vector<std::thread> writers;
+    uint64_t start = timestamp_ns();
+    for (int t = 0; t < threads; ++t)
+    {
+        writers.emplace_back([&, t]()
+                             {
+            MetricsShard &shard = metrics.local();
+            for (int i = 0; i < per_thread; ++i)
+                shard.add(events);
+            for (int i = 1; i <= 1000; ++i)
+                shard.record(latency, static_cast<uint64_t>(i) * 1000);
+            shard.set(depth, t + 1); });
+    }
+    for (auto &w : writers)
+        w.join();
+    uint64_t sharded_ns = timestamp_ns() - start;
+
+    std::atomic<uint64_t> shared{0};
+    writers.clear();
+    start = timestamp_ns();
+    for (int t = 0; t < threads; ++t)
+    {
+        writers.emplace_back([&]()
+                             {
+            for (int i = 0; i < per_thread; ++i)
+                shared.fetch_add(1, std::memory_order_relaxed); });
+    }
+    for (auto &w : writers)
+        w.join();
+    uint64_t shared_ns = timestamp_ns() - start;
+
+    // Totals survive the writers; draining leaves the counters alone
+    MetricsSnapshot snap = metrics.snapshot();
+    const LatencyHistogram *h = snap.histogram("latency_ns");
+    ok = ok && metrics.shard_count() == threads && snap.counter("events") == uint64_t(threads) * per_thread &&
+         metrics.counter_value(events) == snap.counter("events") && snap.gauge("depth") == 1 + 2 + 3 + 4 &&
+         h && h->count() == uint64_t(threads) * 1000 && h->max() == 1000000;
+
+    LatencyHistogram drained;
+    metrics.drain_histogram(latency, drained);
+    metrics.add(events);
+    snap = metrics.snapshot();
+    ok = ok && drained.count() == uint64_t(threads) * 1000 && snap.histogram("latency_ns")->count() == 0 &&
+         snap.counter("events") == uint64_t(threads) * per_thread + 1 && metrics.shard_count() == threads + 1;
+
+    // A full registry hands out INVALID, and writes to it go nowhere
+    for (size_t i = 0; i < MetricsShard::MAX_GAUGES; ++i)
+        metrics.gauge("g" + std::to_string(i));
+    ok = ok && metrics.gauge("overflow") == MetricsRegistry::INVALID;
+    metrics.set(MetricsRegistry::INVALID, 1);
+
+    std::cout << "\n=== Metrics Registry ===" << std::endl;
+    std::cout << "Sharded totals, gauges, drain and capacity: " << (ok ? "ok" : "WRONG") << std::endl;
+    std::cout << "Counter add (" << threads << " threads): " << std::fixed << std::setprecision(2)
+              << (static_cast<double>(sharded_ns) / (threads * per_thread)) << " ns sharded vs "
+              << (static_cast<double>(shared_ns) / (threads * per_thread)) << " ns on one shared atomic" << std::endl;
+    std::cout << "========================" << std::endl;
+    return ok;
+}
+
+bool test_metrics_server()
+{
+    // Source: a registry being written by another thread while we scrape
+    MetricsRegistry metrics;
+    uint32_t updates = metrics.counter("updates");
+    uint32_t latency = metrics.histogram("latency_ns");
+    std::atomic<bool> writing{true};
+    std::thread writer([&]()
+                       {
+        MetricsShard &shard = metrics.local();
+        uint64_t v = 0;
+        while (writing.load(std::memory_order_relaxed))
+        {
+            shard.add(updates);
+            shard.record(latency, 1000 + (v++ % 100000));
+        } });
+
+    MetricsServerConfig config;
+    config.port = 0; // Any free port, so the test never collides with a running engine
+    MetricsServer server;
+    server.set_source([&]()
+                      {
+        MetricsSnapshot snap = metrics.snapshot();
+        std::string out;
+        prometheus::counter(out, "test_updates_total", "Updates", static_cast<double>(snap.counter("updates")));
+        prometheus::histogram(out, "test_latency_seconds", "Latency", *snap.histogram("latency_ns"));
+        return out; });
+    if (!server.start(config))
+        return false;
+
+    // One request per connection; the server closes after answering
+    auto fetch = [&](const std::string &request)
+    {
+        std::string received;
+        net::socket_t client = net::connect_tcp("127.0.0.1", server.port());
+        if (client == net::INVALID_SOCKET_VALUE)
+            return received;
+        net::send_some(client, request.data(), request.size());
+        char buffer[4096];
+        uint64_t deadline = timestamp_ns() + 1000000000ULL;
+        while (timestamp_ns() < deadline)
+        {
+            net::PollFd fd{};
+            fd.fd = client;
+            fd.events = POLLIN;
+            if (net::poll_sockets(&fd, 1, 10) <= 0)
+                continue;
+            long n = net::recv_some(client, buffer, sizeof(buffer));
+            if (n < 0)
+                break;
+            received.append(buffer, static_cast<size_t>(n));
+        }
+        net::close_socket(client);
+        return received;
+    };
+
+    std::vector<uint64_t> scrape_ns;
+    std::string body;
+    bool ok = true;
+    for (int i = 0; i < 20 && ok; ++i)
+    {
+        uint64_t start = timestamp_ns();
+        std::string response = fetch("GET /metrics HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+        scrape_ns.push_back(timestamp_ns() - start);
+        ok = response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0 &&
+             response.find("Content-Type: text/plain; version=0.0.4") != std::string::npos;
+        body = response.substr(std::min(response.size(), response.find("\r\n\r\n") + 4));
+    }
+    writing.store(false);
+    writer.join();
+
+    // Histogram buckets are cumulative and end at the count (prefixes start at a sample
+    // line, not the HELP line)
+    auto value_of = [&](const std::string &prefix)
+    {
+        size_t at = body.find(prefix);
+        return at == std::string::npos ? -1.0 : std::atof(body.c_str() + at + prefix.size());
+    };
+    double le_10us = value_of("test_latency_seconds_bucket{le=\"1e-05\"} ");
+    double le_100us = value_of("test_latency_seconds_bucket{le=\"0.0001\"} ");
+    double le_inf = value_of("test_latency_seconds_bucket{le=\"+Inf\"} ");
+    ok = ok && body.find("# TYPE test_updates_total counter\n") != std::string::npos &&
+         body.find("# TYPE test_latency_seconds histogram\n") != std::string::npos && value_of("\ntest_updates_total ") > 0 &&
+         le_10us > 0 && le_10us <= le_100us && le_100us <= le_inf && le_inf == value_of("test_latency_seconds_count ");
+
+    ok = ok && fetch("GET /other HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 404", 0) == 0 &&
+         fetch("POST /metrics HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 405", 0) == 0;
+    auto stats = server.get_stats();
+    server.stop();
+    ok = ok && stats.scrapes == 20 && stats.rejected == 2;
+
+    std::sort(scrape_ns.begin(), scrape_ns.end());
+    std::cout << "\n=== Metrics Endpoint ===" << std::endl;
+    std::cout << "Scrapes, exposition format and errors: " << (ok ? "ok" : "WRONG") << std::endl;
+    std::cout << "Scrape round trip p50: " << std::fixed << std::setprecision(1) << scrape_ns[scrape_ns.size() / 2] / 1000.0
+              << " us (" << body.size() << " byte body, concurrent writer)" << std::endl;
+    std::cout << "========================" << std::endl;
+    return ok;
+}
+
+bool test_microbench()
+{
+    bench::Summary s = bench::Summary::of({5.0, 1.0, 3.0, 2.0, 4.0});
+    bool ok = s.min == 1.0 && s.max == 5.0 && s.median == 3.0 && s.mean == 3.0 && s.p90 == 5.0 &&
+              std::fabs(s.stddev - std::sqrt(2.5)) < 1e-9;
+
+    bench::BenchConfig config;
+    config.warmup_ns = 1000000;
+    config.repetitions = 4;
+    config.min_rep_ns = 1000000;
+    bench::BenchRunner runner(config);
+    runner.set_filter("sum");
+
+    // A body's untimed part must not show up in the numbers
+    uint64_t calls = 0;
+    const bench::BenchResult *r = runner.run("sum", {{"n", 256}}, 256, [&]()
+                                             {
+        ++calls;
+        volatile uint64_t untimed = 0;
+        for (int i = 0; i < 20000; ++i)
+            untimed = untimed + i;
+        return bench::timed([&]()
+                            {
+            uint64_t sum = 0;
+            for (uint64_t i = 0; i < 256; ++i)
+                sum += i * i;
+            bench::do_not_optimize(sum); }); });
+    ok = ok && r && r->id() == "sum/n=256" && r->samples.size() == 4 && r->summary.median > 0.0 &&
+         r->summary.median < 50.0 && r->ops_per_rep % 256 == 0 && calls > 4;
+    double median = r ? r->summary.median : 0.0;
+
+    ok = ok && !runner.run("skipped", {}, 1, []()
+                           { return uint64_t(1); }) &&
+         runner.results().size() == 1;
+
+    // Medians read back from the JSON match by id
+    std::string path = (std::filesystem::temp_directory_path() / "arbisim_microbench_test.json").string();
+    std::vector<std::pair<std::string, double>> medians;
+    ok = ok && runner.write_json(path) && bench::read_json_medians(path, medians) && medians.size() == 1 &&
+         medians[0].first == "sum/n=256" && std::fabs(medians[0].second - median) < 0.001;
+    std::filesystem::remove(path);
+
+    std::cout << "\n=== Microbenchmark Harness ===" << std::endl;
+    std::cout << "Summary, filter, timed regions and JSON: " << (ok ? "ok" : "WRONG") << std::endl;
+    std::cout << "Sum loop: " << std::fixed << std::setprecision(2) << median << " ns/op over "
+              << (r ? r->ops_per_rep : 0) << " ops per repetition" << std::endl;
+    std::cout << "==============================" << std::endl;
+    return ok;
+}
+
+bool test_open_loop_load()
+{
+    // A simulated consumer serving one update per 250 us of intended time (4000/s): completions
+    // follow from the schedule alone, so wall-clock noise cannot move the latencies
+    const uint64_t service_ns = 250000;
+    uint64_t server_free_ns = 0;
+    std::vector<MarketUpdate> source(16);
+    for (size_t i = 0; i < source.size(); ++i)
+        source[i] = MarketUpdate(MarketUpdate::BID_UPDATE, "BTCUSDT", "binance", 50000.0 + i, 1.0, i, 0);
+
+    OpenLoopLoadGenerator *generator = nullptr;
+    OpenLoopLoadGenerator load(source, [&](const MarketUpdate &update)
+                               {
+        server_free_ns = std::max(server_free_ns, update.timestamp_ns) + service_ns;
+        generator->record_update(update.timestamp_ns, server_free_ns); });
+    generator = &load;
+
+    LoadTestConfig config;
+    config.start_rate = 500.0;
+    config.rate_factor = 4.0;
+    config.step_ns = 200000000;
+    config.drain_timeout_ns = 3000000000ULL;
+    config.slo_p99_ns = 50000000;
+    auto steps = load.run(config, []()
+                          { return false; });
+
+    // 500/s and 2000/s keep up; 8000/s queues behind the consumer, and its latency counts
+    // the queueing from each update's intended send time
+    bool ok = steps.size() == 3 && !steps.front().saturated && !steps[1].saturated &&
+              steps.front().sent == 100 && steps.front().completed == 100 &&
+              steps.back().saturated && steps.back().throughput < steps.back().offered_rate * 0.95 &&
+              steps.back().latency.percentile(0.99) > steps.front().latency.percentile(0.99);
+
+    std::string path = (std::filesystem::temp_directory_path() / "arbisim_load_curve.csv").string();
+    ok = ok && OpenLoopLoadGenerator::write_csv(path, steps);
+    std::ifstream curve(path);
+    std::string line;
+    size_t rows = 0;
+    while (std::getline(curve, line))
+        rows++;
+    curve.close();
+    std::filesystem::remove(path);
+    ok = ok && rows == steps.size() + 1;
+
+    std::cout << "\n=== Open-Loop Load ===" << std::endl;
+    std::cout << "Ramp, saturation and intended-time latency: " << (ok ? "ok" : "WRONG") << std::endl;
+    OpenLoopLoadGenerator::print_header(std::cout);
+    for (const auto &step : steps)
+        OpenLoopLoadGenerator::print_step(std::cout, step);
+    std::cout << "======================" << std::endl;
+    return ok;
+}
+
+bool test_steady_state_allocations()
+{
+    // The market and risk stages of the engine, run inline on one thread: queue, apply,
+    // detect into a reused vector, hand off, and assess into a reused vector
+    ArbitrageDetector detector;
+    const std::vector<std::string> venues = {"binance", "coinbase", "kraken"};
+    for (const auto &venue : venues)
+    {
+        detector.add_orderbook("BTCUSDT", venue);
+        auto *book = detector.get_orderbook("BTCUSDT", venue);
+        for (int i = 0; i < 5; ++i)
+        {
+            book->update_bid(50000.0 - i, 1.0);
+            book->update_ask(50002.0 + i, 1.0);
+        }
+    }
+    detector.set_min_profit_bps(1.0);
+    ConflatingUpdateQueue updates;
+    OpportunityQueue opportunities(256, 1000000000);
+    RiskManager risk;
+
+    // Each cycle opens a cross on kraken's bid, moves it, pulls it (CLOSE) and churns levels
+    // that never cross; the 16-character "coinbase_BTCUSDT" position key is past the SSO
+    const MarketUpdate::Type BID = MarketUpdate::BID_UPDATE, ASK = MarketUpdate::ASK_UPDATE;
+    const std::vector<MarketUpdate> cycle = {
+        MarketUpdate(BID, "BTCUSDT", "kraken", 50150.0, 0.5), MarketUpdate(BID, "BTCUSDT", "kraken", 50170.0, 0.5),
+        MarketUpdate(ASK, "BTCUSDT", "coinbase", 50003.5, 2.0), MarketUpdate(BID, "BTCUSDT", "binance", 49999.5, 2.0),
+        MarketUpdate(BID, "BTCUSDT", "kraken", 50170.0, 0.0), MarketUpdate(BID, "BTCUSDT", "kraken", 50150.0, 0.0),
+        MarketUpdate(ASK, "BTCUSDT", "coinbase", 50003.5, 0.0), MarketUpdate(BID, "BTCUSDT", "binance", 49999.5, 0.0)};
+
+    std::vector<MarketUpdate> batch;
+    std::vector<ArbitrageOpportunity> events, popped;
+    std::vector<RiskAssessment> assessments;
+    uint64_t processed = 0, assessed = 0;
+    auto run_cycles = [&](int n)
+    {
+        for (int c = 0; c < n; ++c)
+        {
+            for (const auto &update : cycle)
+            {
+                updates.push(update);
+                updates.drain(batch, std::chrono::milliseconds(0));
+                uint64_t now = timestamp_ns();
+                for (const auto &u : batch)
+                {
+                    auto *book = detector.get_orderbook(u.symbol, u.exchange);
+                    if (u.type == MarketUpdate::BID_UPDATE)
+                        book->update_bid(u.price, u.quantity, now);
+                    else
+                        book->update_ask(u.price, u.quantity, now);
+                    processed++;
+                }
+                detector.check_arbitrage("BTCUSDT", now, events);
+                for (auto &opp : events)
+                    if (opp.event != OpportunityEvent::CLOSE)
+                        opportunities.push(std::move(opp), now);
+                popped.clear();
+                if (opportunities.pop_batch(popped, 64, timestamp_ns()) > 0)
+                {
+                    risk.assess_batch(popped, assessments);
+                    assessed += assessments.size();
+                }
+            }
+        }
+    };
+
+    run_cycles(50); // Containers reach their working capacity
+    processed = assessed = 0;
+    alloc::AllocScope steady;
+    run_cycles(500);
+    uint64_t allocations = steady.allocations();
+
+    // The counting allocator must be live, or zero would prove nothing
+    alloc::AllocScope probe;
+    auto sentinel = std::make_unique<int>(1);
+    bench::do_not_optimize(sentinel);
+    bool counting = probe.allocations() == 1;
+
+    bool ok = counting && allocations == 0 && assessed > 0 && detector.lifecycle_stats().closed >= 500;
+
+    std::cout << "\n=== Steady-State Allocations ===" << std::endl;
+    std::cout << "Updates: " << processed << " | Opportunities assessed: " << assessed << std::endl;
+    std::cout << "Allocations: " << allocations << " (" << std::fixed << std::setprecision(3)
+              << static_cast<double>(allocations) / std::max<uint64_t>(1, processed) << " per update): "
+              << (ok ? "ok" : (counting ? "WRONG" : "WRONG (allocator not counting)")) << std::endl;
+    std::cout << "================================" << std::endl;
+    return ok;
+}
+
+bool test_simd_book_levels()
+{
+    // Every SIMD path the CPU has must build the same books as the scalar one from the
+    // same inserts, modifies and deletes (cumulative depth to rounding)
+    const simd::Level detected = simd::detect_level();
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<int> tick(0, 24);
+    std::uniform_int_distribution<int> action(0, 3);
+    std::uniform_real_distribution<double> qty(0.01, 3.0);
+    struct Op
+    {
+        bool bid;
+        double price;
+        double quantity;
+    };
+    std::vector<Op> ops(20000);
+    for (auto &op : ops)
+    {
+        op.bid = rng() & 1;
+        op.price = op.bid ? 50000.0 - tick(rng) : 50001.0 + tick(rng);
+        op.quantity = action(rng) == 0 ? 0.0 : qty(rng); // A quarter are deletes
+    }
+
+    auto replay = [&](simd::Level level)
+    {
+        simd::set_level(level);
+        auto book = std::make_unique<FastOrderBook>("BTCUSDT", "binance");
+        std::vector<std::vector<double>> snapshots;
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            if (ops[i].bid)
+                book->update_bid(ops[i].price, ops[i].quantity, i + 1);
+            else
+                book->update_ask(ops[i].price, ops[i].quantity, i + 1);
+            if (i % 97 != 0)
+                continue;
+            std::vector<double> snap = {static_cast<double>(book->bid_depth()), static_cast<double>(book->ask_depth())};
+            for (size_t l = 0; l < book->bid_depth(); ++l)
+                snap.insert(snap.end(), {book->bid_level(l).price, book->bid_level(l).quantity,
+                                         static_cast<double>(book->bid_level(l).timestamp_ns), book->bid_cum_qty(l)});
+            for (size_t l = 0; l < book->ask_depth(); ++l)
+                snap.insert(snap.end(), {book->ask_level(l).price, book->ask_level(l).quantity,
+                                         static_cast<double>(book->ask_level(l).timestamp_ns), book->ask_cum_qty(l)});
+            snapshots.push_back(std::move(snap));
+        }
+        return snapshots;
+    };
+
+    auto reference = replay(simd::Level::SCALAR);
+    bool sorted = true;
+    {
+        auto book = std::make_unique<FastOrderBook>("BTCUSDT", "binance");
+        for (const auto &op : ops)
+        {
+            if (op.bid)
+                book->update_bid(op.price, op.quantity, 1);
+            else
+                book->update_ask(op.price, op.quantity, 1);
+        }
+        for (size_t l = 1; l < book->bid_depth(); ++l)
+            sorted = sorted && book->bid_price(l) < book->bid_price(l - 1);
+        for (size_t l = 1; l < book->ask_depth(); ++l)
+            sorted = sorted && book->ask_price(l) > book->ask_price(l - 1);
+        sorted = sorted && book->bid_depth() > 0 && book->ask_depth() > 0;
+    }
+
+    bool ok = sorted;
+    std::cout << "\n=== SIMD Book Levels ===" << std::endl;
+    std::cout << "CPU supports: " << simd::level_name(detected) << std::endl;
+    for (simd::Level level : {simd::Level::SSE2, simd::Level::AVX2})
+    {
+        if (level > detected)
+            continue;
+        auto snapshots = replay(level);
+        bool same = snapshots.size() == reference.size();
+        for (size_t i = 0; same && i < snapshots.size(); ++i)
+        {
+            same = snapshots[i].size() == reference[i].size();
+            for (size_t v = 0; same && v < snapshots[i].size(); ++v)
+            {
+                bool cum = v >= 2 && (v - 2) % 4 == 3;
+                same = cum ? std::abs(snapshots[i][v] - reference[i][v]) <= 1e-9 * std::max(1.0, reference[i][v])
+                           : snapshots[i][v] == reference[i][v];
+            }
+        }
+        ok = ok && same;
+        std::cout << simd::level_name(level) << " vs scalar over " << ops.size() << " updates: " << (same ? "ok" : "WRONG") << std::endl;
+    }
+    simd::set_level(detected);
+    std::cout << "Levels sorted: " << (sorted ? "ok" : "WRONG") << std::endl;
+    std::cout << "========================" << std::endl;
+    return ok;
+}
+
+bool test_backtester()
+{
+    namespace fs = std::filesystem;
+    fs::path path = fs::temp_directory_path() / "arbisim_backtest_capture.csv";
+    {
+        std::ofstream out(path);
+        out << "timestamp_ns,exchange,symbol,side,price,quantity\n"
+            << "1000,binance,BTCUSDT,B,50000.50,1.250000\n"
+            << "not,a,capture,line\n"
+            << "2000,kraken,ETHUSDT,A,3000.25,0.000000\n";
+    }
+    std::vector<MarketUpdate> loaded;
+    bool parsed = load_market_data(path.string(), loaded) && loaded.size() == 2 &&
+                  loaded[0].timestamp_ns == 1000 && loaded[0].exchange == "binance" &&
+                  loaded[0].type == MarketUpdate::BID_UPDATE && loaded[0].price == 50000.50 &&
+                  loaded[0].quantity == 1.25 && loaded[1].symbol == "ETHUSDT" &&
+                  loaded[1].type == MarketUpdate::ASK_UPDATE && loaded[1].quantity == 0.0 &&
+                  loaded[1].sequence_id == 1;
+    fs::remove(path);
+
+    // Same capture and grid, run twice: every grid point must replay to the same trades and P&L
+    auto updates = generate_synthetic_market_data(300, 42);
+    std::vector<BacktestConfig> grid(2);
+    for (auto &config : grid)
+    {
+        config.limits.max_position_size = 20.0;
+        config.limits.max_total_exposure = 5000000.0;
+        config.limits.max_single_trade_size = 0.5;
+        config.limits.max_daily_loss = 50000.0;
+        config.limits.max_drawdown = 0.5;
+    }
+    grid[1].min_profit_bps = 10.0;
+
+    WorkStealingPool pool;
+    Backtester<> backtester(pool);
+    auto first = backtester.run(updates, grid);
+    auto second = backtester.run(updates, grid);
+    bool repeatable = first.size() == grid.size() && second.size() == grid.size();
+    for (size_t i = 0; repeatable && i < grid.size(); ++i)
+    {
+        repeatable = first[i].updates == updates.size() && first[i].executions > 0 &&
+                     first[i].opportunities == second[i].opportunities && first[i].executions == second[i].executions &&
+                     first[i].trades == second[i].trades && first[i].total_pnl == second[i].total_pnl &&
+                     first[i].leg_risk_pnl == second[i].leg_risk_pnl;
+    }
+
+    std::cout << "\n=== Backtester ===" << std::endl;
+    std::cout << "Capture parsing: " << (parsed ? "ok" : "WRONG") << std::endl;
+    std::cout << "Replay of " << updates.size() << " updates: " << first[0].executions << " executions, "
+              << first[0].trades << " trades, P&L $" << first[0].total_pnl << ", repeatable: "
+              << (repeatable ? "ok" : "WRONG") << std::endl;
+    std::cout << "==================" << std::endl;
+    return parsed && repeatable;
+}
+
+bool test_opportunity_queue()
+{
+    OpportunityQueue queue(2, 1000000); // Two slots, 1 ms budget
+    uint64_t now = timestamp_ns();
+
+    auto make = [&](double sell_px)
+    {
+        ArbitrageOpportunity opp("BTCUSDT", "exchange1", "exchange2", 50000.0, sell_px, now);
+        opp.max_quantity = 1.0;
+        return opp;
+    };
+
+    queue.push(make(50200.0), now);
+    queue.push(make(50100.0), now - 5000000); // Already stale
+    bool refused = !queue.push(make(50050.0), now); // Worse than everything queued, queue full
+    queue.push(make(50400.0), now);                 // Displaces the worst entry
+
+    std::vector<ArbitrageOpportunity> served;
+    queue.pop_batch(served, 8, now + 1000);
+    auto stats = queue.get_stats();
+
+    bool ok = refused && served.size() == 2 && served[0].sell_price == 50400.0 &&
+              served[1].sell_price == 50200.0 && stats.evicted == 2 && stats.depth == 0;
+
+    // Deadline: whatever is left past the budget is dropped, not served
+    queue.push(make(50300.0), now);
+    served.clear();
+    queue.pop_batch(served, 8, now + 2000000);
+    ok = ok && served.empty() && queue.get_stats().expired == 1;
+
+    std::cout << "\n=== Opportunity Queue ===" << std::endl;
+    std::cout << "Best-first with eviction and expiry: " << (ok ? "ok" : "WRONG") << std::endl;
+    std::cout << "=========================" << std::endl;
+    return ok;
+}
+
+bool test_cross_sizing()
+{
+    // 10 bps taker on both legs, no extra margin: a level pair crosses while
+    // bid >= ask * 1.001 / 0.999
+    ArbitrageDetector detector;
+    detector.set_min_profit_bps(0.0);
+    for (const char *symbol : {"BTCUSDT", "ETHUSDT"})
+    {
+        detector.add_orderbook(symbol, "exchange1");
+        detector.add_orderbook(symbol, "exchange2");
+        detector.get_orderbook(symbol, "exchange1")->update_bid(49000.0, 10.0);
+        detector.get_orderbook(symbol, "exchange2")->update_ask(51000.0, 10.0);
+    }
+    auto near = [](double a, double b)
+    { return std::abs(a - b) < 1e-6; };
+
+    // Edge runs out: 1 @ 50000/50200, 0.5 @ 50020/50200, 0.5 @ 50020/50150, then
+    // 50060 needs a bid of 50160.2 and the next one is 50150
+    auto *asks = detector.get_orderbook("BTCUSDT", "exchange1");
+    auto *bids = detector.get_orderbook("BTCUSDT", "exchange2");
+    asks->update_ask(50000.0, 1.0);
+    asks->update_ask(50020.0, 1.0);
+    asks->update_ask(50060.0, 2.0);
+    bids->update_bid(50200.0, 1.5);
+    bids->update_bid(50150.0, 1.0);
+    bids->update_bid(50100.0, 5.0);
+    auto edge = detector.check_arbitrage("BTCUSDT", timestamp_ns());
+    bool edge_stops = edge.size() == 1 && near(edge[0].max_quantity, 2.0) &&
+                      near(edge[0].buy_vwap, 100020.0 / 2.0) && near(edge[0].sell_vwap, 100375.0 / 2.0);
+
+    // Depth runs out: every ask level still clears the 50200 bid, but there are only 0.8 of them
+    asks = detector.get_orderbook("ETHUSDT", "exchange1");
+    bids = detector.get_orderbook("ETHUSDT", "exchange2");
+    asks->update_ask(50000.0, 0.5);
+    asks->update_ask(50010.0, 0.3);
+    bids->update_bid(50200.0, 2.0);
+    auto depth = detector.check_arbitrage("ETHUSDT", timestamp_ns());
+    bool depth_stops = depth.size() == 1 && near(depth[0].max_quantity, 0.8) &&
+                       near(depth[0].buy_vwap, 40003.0 / 0.8) && near(depth[0].sell_vwap, 50200.0);
+
+    std::cout << "\n=== Cross Sizing ===" << std::endl;
+    std::cout << "Walk stops at the marginal edge: " << (edge_stops ? "ok" : "WRONG") << std::endl;
+    std::cout << "Walk stops when one side runs out: " << (depth_stops ? "ok" : "WRONG") << std::endl;
+    std::cout << "====================" << std::endl;
+    return edge_stops && depth_stops;
+}
+
+bool test_fee_schedule()
+{
+    // Tiers switch exactly at their volume requirement
+    FeeSchedule schedule = FeeSchedule::defaults();
+    auto taker_at = [&](const char *exchange, double volume)
+    {
+        schedule.set_volume_30d(exchange, volume);
+        return schedule.taker_bps(exchange);
+    };
+    auto maker_at = [&](const char *exchange, double volume)
+    {
+        schedule.set_volume_30d(exchange, volume);
+        return schedule.maker_bps(exchange);
+    };
+    bool tiers = maker_at("binance", 0.0) == 10.0 && maker_at("binance", 999999.99) == 10.0 &&
+                 maker_at("binance", 1000000.0) == 9.0 && maker_at("binance", 4999999.99) == 9.0 &&
+                 maker_at("binance", 5000000.0) == 8.0 && taker_at("binance", 19999999.99) == 10.0 &&
+                 taker_at("binance", 20000000.0) == 6.0 && taker_at("binance", 1e12) == 6.0 &&
+                 taker_at("coinbase", 9999.99) == 60.0 && taker_at("coinbase", 10000.0) == 40.0 &&
+                 taker_at("unlisted", 1e12) == 10.0; // No table: the default tier
+
+    // 15 bps raw cross: short of 10 + 10 bps taker fees at the base tiers, clear of
+    // 6 + 7.75 bps once both venues reach their top tier
+    schedule = FeeSchedule::defaults();
+    ArbitrageDetector detector;
+    detector.set_min_profit_bps(0.0);
+    detector.set_fee_schedule(schedule);
+    detector.add_orderbook("BTCUSDT", "binance");
+    detector.add_orderbook("BTCUSDT", "bybit");
+    auto *buy_book = detector.get_orderbook("BTCUSDT", "binance");
+    auto *sell_book = detector.get_orderbook("BTCUSDT", "bybit");
+    buy_book->update_bid(49990.0, 1.0);
+    buy_book->update_ask(50000.0, 1.0);
+    sell_book->update_bid(50075.0, 1.0);
+    sell_book->update_ask(50085.0, 1.0);
+    bool below_fees = detector.check_arbitrage("BTCUSDT", timestamp_ns()).empty();
+
+    schedule.set_volume_30d_all(25000000.0);
+    detector.set_fee_schedule(schedule);
+    auto events = detector.check_arbitrage("BTCUSDT", timestamp_ns());
+    bool cheaper_tier = schedule.volume_30d("unlisted") == 0.0 && events.size() == 1 &&
+                        events[0].event == OpportunityEvent::OPEN && events[0].buy_exchange == "binance" &&
+                        events[0].sell_exchange == "bybit" && events[0].buy_fee_bps == 6.0 &&
+                        events[0].sell_fee_bps == 7.75 && events[0].net_profit_bps > 0.0;
+
+    std::cout << "\n=== Fee Schedule ===" << std::endl;
+    std::cout << "Tier boundaries: " << (tiers ? "ok" : "WRONG") << std::endl;
+    std::cout << "Cross under taker fees ignored: " << (below_fees ? "ok" : "WRONG") << std::endl;
+    std::cout << "Same cross reported at a cheaper tier: " << (cheaper_tier ? "ok" : "WRONG") << std::endl;
+    std::cout << "====================" << std::endl;
+    return tiers && below_fees && cheaper_tier;
+}
+
+bool test_risk_pipeline()
+{
+    RiskLimits limits;
+    limits.max_position_size = 2.0;
+    limits.max_total_exposure = 10000000.0;
+    limits.max_single_trade_size = 1.0;
+    limits.min_profit_after_fees = 5.0;
+    limits.max_daily_loss = 1000.0;
+    limits.max_drawdown = 0.5;
+
+    ArbitrageOpportunity good("BTCUSDT", "exchange1", "exchange2", 50000.0, 50250.0, timestamp_ns()); // 30 bps net
+    ArbitrageOpportunity thin("BTCUSDT", "exchange1", "exchange2", 50000.0, 50100.0, timestamp_ns()); // 0 bps net
+    good.max_quantity = thin.max_quantity = 10.0;
+
+    // Full pipeline order: min_profit, daily_loss, drawdown, trade_size, liquidity, exchange_limit, exposure.
+    // A failing check reports its own code and reason and counts once; the fold stops
+    // there, so no later check counts anything.
+    RiskManager full;
+    full.set_risk_limits(limits);
+    auto rejected = full.assess_opportunity(thin);
+    auto counts = full.generate_report().check_rejections;
+    bool first_fails = rejected.decision == RiskDecision::REJECTED_PROFIT_TOO_LOW &&
+                       rejected.reason == MinProfitCheck::reason && counts[0] == 1 &&
+                       std::all_of(counts.begin() + 1, counts.end(), [](uint64_t c)
+                                   { return c == 0; });
+
+    full.record_realized_pnl(-1500.0); // Past the daily loss limit, inside the drawdown limit
+    rejected = full.assess_opportunity(good);
+    counts = full.generate_report().check_rejections;
+    bool second_fails = rejected.decision == RiskDecision::REJECTED_DAILY_LOSS &&
+                        rejected.reason == DailyLossCheck::reason && counts[0] == 1 && counts[1] == 1 &&
+                        std::all_of(counts.begin() + 2, counts.end(), [](uint64_t c)
+                                    { return c == 0; });
+
+    RiskLimits tight = limits;
+    tight.max_total_exposure = 50.0; // Room for 0.0005 BTC across both legs
+    RiskManager exposed;
+    exposed.set_risk_limits(tight);
+    rejected = exposed.assess_opportunity(good);
+    counts = exposed.generate_report().check_rejections;
+    bool last_fails = rejected.decision == RiskDecision::REJECTED_EXPOSURE_LIMIT &&
+                      rejected.reason == ExposureCheck::reason && counts[6] == 1 &&
+                      std::all_of(counts.begin(), counts.begin() + 6, [](uint64_t c)
+                                  { return c == 0; });
+
+    // Fast pipeline: daily loss, drawdown, exchange and exposure limits are not in the
+    // type, so breaching all of them still approves at the trade size limit
+    static_assert(SimpleRiskManager::check_count == 3, "fast pipeline is profit, size and depth only");
+    static_assert(!FastRiskPipeline::has<DailyLossCheck> && !FastRiskPipeline::has<DrawdownCheck> &&
+                      !FastRiskPipeline::has<ExchangeLimitCheck> && !FastRiskPipeline::has<ExposureCheck>,
+                  "fast pipeline must skip the account checks");
+    tight.max_position_size = 0.0005;
+    tight.max_drawdown = 0.01;
+    SimpleRiskManager fast;
+    fast.set_risk_limits(tight);
+    fast.record_realized_pnl(-1500.0);
+    auto approved = fast.assess_opportunity(good);
+    auto fast_report = fast.generate_report();
+    bool fast_skips = approved.decision == RiskDecision::APPROVED && approved.recommended_size == 1.0 &&
+                      fast_report.check_rejections == std::array<uint64_t, 3>{} &&
+                      fast.assess_opportunity(thin).decision == RiskDecision::REJECTED_PROFIT_TOO_LOW;
+
+    bool ok = first_fails && second_fails && last_fails && fast_skips;
+    std::cout << "\n=== Risk Pipeline ===" << std::endl;
+    std::cout << "Failing check records its code and counter: " << (first_fails && last_fails ? "ok" : "WRONG") << std::endl;
+    std::cout << "Short-circuits after the first failure: " << (first_fails && second_fails ? "ok" : "WRONG") << std::endl;
+    std::cout << "Fast pipeline skips account checks: " << (fast_skips ? "ok" : "WRONG") << std::endl;
+    std::cout << "=====================" << std::endl;
+    return ok;
+}
+
+bool test_batch_allocation()
+{
+    RiskManager risk;
+    // 1 BTC per exchange, 1 BTC max trade, liberal everything else
+    risk.set_risk_limits(1.0, 10000000.0, 1.0, 0.0, 1000000.0, 1.0);
+
+    // Both crosses buy on exchange1; the second one is the better trade
+    std::vector<ArbitrageOpportunity> batch;
+    batch.emplace_back("BTCUSDT", "exchange1", "exchange2", 50000.0, 50250.0, timestamp_ns());
+    batch.emplace_back("BTCUSDT", "exchange1", "exchange3", 50000.0, 50400.0, timestamp_ns());
+    for (auto &opp : batch)
+    {
+        opp.max_quantity = 100.0; // Deep books: inventory, not liquidity, is the constraint
+    }
+
+    auto assessments = risk.assess_batch(batch);
+    bool ok = assessments[0].decision == RiskDecision::REJECTED_EXCHANGE_LIMIT &&
+              assessments[1].decision == RiskDecision::APPROVED &&
+              assessments[1].recommended_size == 1.0;
+
+    // Ranked by expected P&L, not edge: a thin 40 bps cross loses the headroom to a
+    // deep 20 bps one worth far more
+    std::vector<ArbitrageOpportunity> ranked;
+    ranked.emplace_back("BTCUSDT", "exchange1", "exchange4", 50000.0, 50300.0, timestamp_ns());
+    ranked.emplace_back("BTCUSDT", "exchange1", "exchange5", 50000.0, 50200.0, timestamp_ns());
+    ranked[0].max_quantity = 0.8;
+    ranked[1].max_quantity = 100.0;
+    auto by_pnl = risk.assess_batch(ranked);
+    ok = ok && by_pnl[0].decision == RiskDecision::REJECTED_EXCHANGE_LIMIT &&
+         by_pnl[1].decision == RiskDecision::APPROVED && by_pnl[1].recommended_size == 1.0;
+
+    // Reservations are per (exchange, symbol): BTC taken on exchange1 leaves ETH's limit alone
+    std::vector<ArbitrageOpportunity> two_symbols;
+    two_symbols.emplace_back("BTCUSDT", "exchange1", "exchange2", 50000.0, 50250.0, timestamp_ns());
+    two_symbols.emplace_back("ETHUSDT", "exchange1", "exchange2", 3000.0, 3015.0, timestamp_ns());
+    for (auto &opp : two_symbols)
+    {
+        opp.max_quantity = 100.0;
+    }
+    auto per_symbol = risk.assess_batch(two_symbols);
+    ok = ok && per_symbol[0].decision == RiskDecision::APPROVED && per_symbol[0].recommended_size == 1.0 &&
+         per_symbol[1].decision == RiskDecision::APPROVED && per_symbol[1].recommended_size == 1.0;
+
+    // Timing: a wide batch across many venue pairs
+    std::vector<ArbitrageOpportunity> wide;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> edge_dist(0.0, 100.0);
+    for (int i = 0; i < 64; ++i)
+    {
+        wide.emplace_back("BTCUSDT", "exchange" + std::to_string(i % 8), "exchange" + std::to_string(8 + i % 7),
+                          50000.0, 50000.0 + edge_dist(gen) * 5.0, timestamp_ns());
+        wide.back().max_quantity = 100.0;
+    }
+
+    const int num_batches = 10000;
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t approved = 0;
+    for (int i = 0; i < num_batches; ++i)
+    {
+        for (const auto &assessment : risk.assess_batch(wide))
+        {
+            approved += assessment.decision == RiskDecision::APPROVED;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    std::cout << "\n=== Batch Allocation Performance ===" << std::endl;
+    std::cout << "Best expected P&L allocated first, per-symbol headroom: " << (ok ? "yes" : "NO") << std::endl;
+    std::cout << "Batches of " << wide.size() << " assessed: " << num_batches << std::endl;
+    std::cout << "Approved per batch: " << (approved / num_batches) << std::endl;
+    std::cout << "Average latency per batch: " << static_cast<int>(duration.count() / num_batches) << " ns" << std::endl;
+    std::cout << "====================================" << std::endl;
+
+    return ok;
+}
+
+bool test_scenario_var_performance()
+{
+    WorkStealingPool pool;
+    ScenarioEngine engine(pool);
+    engine.set_paths(10000);
+
+    // Long one venue, short another: the basis book the engine actually carries
+    std::vector<ScenarioPosition> positions;
+    const char *venues[] = {"binance", "coinbase", "kraken", "bybit"};
+    for (int i = 0; i < 4; ++i)
+    {
+        positions.push_back({venues[i], "BTCUSDT", (i % 2 == 0) ? 2.0 : -2.0, 50000.0});
+        positions.push_back({venues[i], "ETHUSDT", (i % 2 == 0) ? -10.0 : 10.0, 3000.0});
+    }
+
+    auto report = engine.run(positions);
+    bool sane = report.paths == 10000 && report.risk_factors == positions.size() && std::isfinite(report.var_99) &&
+                std::isfinite(report.es_99) && report.var_99 > 0.0 && report.es_99 >= report.var_99;
+
+    // One factor: the 1% quantile of a lognormal move, exposure * -expm1(drift + z * sigma)
+    auto single = engine.run({{"binance", "BTCUSDT", 2.0, 50000.0}});
+    const double sigma = 0.60 * std::sqrt(60.0 / (365.0 * 24.0 * 3600.0));
+    const double analytic = -100000.0 * std::expm1(-0.5 * sigma * sigma - 2.3263478740 * sigma);
+    bool matches = std::abs(single.var_99 - analytic) < 0.05 * analytic;
+
+    // Same gross, one leg flipped: the basis hedge must cut the tail
+    auto hedged = engine.run({{"binance", "BTCUSDT", 2.0, 50000.0}, {"coinbase", "BTCUSDT", -2.0, 50000.0}});
+    auto unhedged = engine.run({{"binance", "BTCUSDT", 2.0, 50000.0}, {"coinbase", "BTCUSDT", 2.0, 50000.0}});
+    bool hedges = hedged.var_99 > 0.0 && hedged.var_99 < unhedged.var_99;
+
+    std::cout << "\n=== Scenario VaR Performance ===" << std::endl;
+    std::cout << "Paths: " << report.paths << ", risk factors: " << report.risk_factors
+              << ", threads: " << pool.thread_count() << std::endl;
+    std::cout << "VaR 99%: $" << report.var_99 << ", ES 99%: $" << report.es_99 << ": " << (sane ? "ok" : "WRONG") << std::endl;
+    std::cout << "Single factor VaR 99%: $" << single.var_99 << " vs analytic $" << analytic << ": "
+              << (matches ? "ok" : "WRONG") << std::endl;
+    std::cout << "Hedged VaR 99%: $" << hedged.var_99 << " vs unhedged $" << unhedged.var_99 << ": "
+              << (hedges ? "ok" : "WRONG") << std::endl;
+    std::cout << "Compute time: " << (report.compute_ns / 1000) << " us" << std::endl;
+    std::cout << "================================" << std::endl;
+    return sane && matches && hedges;
+}
+
+bool test_execution_simulator_performance()
+{
+    ArbitrageDetector detector;
+    detector.add_orderbook("BTCUSDT", "exchange1");
+    detector.add_orderbook("BTCUSDT", "exchange2");
+
+    // Levels are stamped on the simulated clock, so every order meets a level it can
+    // see in full: refreshed ones at its arrival, the rest from the start
+    uint64_t sim_time = 1000000000;
+    auto *book1 = detector.get_orderbook("BTCUSDT", "exchange1");
+    auto *book2 = detector.get_orderbook("BTCUSDT", "exchange2");
+    book1->update_ask(50000.0, 5.0, sim_time);
+    book2->update_bid(50200.0, 3.0, sim_time); // Thinner sell side: every execution leaves leg risk
+    book2->update_bid(50100.0, 50.0, sim_time);
+    book2->update_ask(50300.0, 50.0, sim_time);
+
+    // Exactly 1 ms each way, no jitter: each step's arrivals are the submission from 100 steps back
+    ExecutionSimulator sim(detector);
+    sim.set_default_venue_model({1000000, 0, 1000000000, 0.0});
+
+    ArbitrageOpportunity opp("BTCUSDT", "exchange1", "exchange2", 50000.0, 50200.0, sim_time);
+
+    const int num_executions = 100000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_executions || sim.in_flight() > 0; ++i) // Books keep refreshing while the tail drains
+    {
+        sim_time += 10000; // 100k submissions per simulated second
+        book1->update_ask(50000.0, 5.0, sim_time); // Refreshed levels restore the liquidity we took
+        book2->update_bid(50200.0, 3.0, sim_time);
+        if (i < num_executions)
+            sim.submit(opp, 4.0, sim_time);
+        sim.process_until(sim_time);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    // Buy fills all 4, the 50200 bid only 3: every execution is partial and unwinds 1
+    auto stats = sim.get_stats();
+    bool fills = stats.completed == static_cast<uint64_t>(num_executions) && stats.fully_filled == 0 &&
+                 stats.partially_filled == stats.completed && stats.unfilled == 0 && stats.in_flight == 0;
+    bool unwinds = stats.unwinds == stats.completed && stats.leg_risk_pnl < 0.0;
+    // About 100 executions are ever in flight, so the first pool chunk is never outgrown
+    bool pooled = stats.pool_capacity == 1024;
+
+    // Two orders on one live level, 300 other levels consumed in between: the second
+    // must only get what the first left, however many records were evicted meanwhile
+    ArbitrageDetector depth_detector;
+    for (const char *venue : {"exchange1", "exchange2", "exchange3"})
+        depth_detector.add_orderbook("BTCUSDT", venue);
+    auto *shared = depth_detector.get_orderbook("BTCUSDT", "exchange1");
+    auto *filler = depth_detector.get_orderbook("BTCUSDT", "exchange3");
+    uint64_t t = 1000;
+    shared->update_ask(50000.0, 1.0, t);
+    depth_detector.get_orderbook("BTCUSDT", "exchange2")->update_bid(50100.0, 1000000.0, t);
+
+    ExecutionSimulator depth_sim(depth_detector);
+    depth_sim.set_default_venue_model({0, 0, UINT64_MAX / 2, 0.0}); // Instant, nothing decays
+    std::vector<double> shared_fills;
+    depth_sim.set_report_callback([&](const ExecutionReport &report)
+                                  {
+        if (report.opportunity.buy_exchange == "exchange1")
+            shared_fills.push_back(report.buy_filled); });
+
+    ArbitrageOpportunity on_shared("BTCUSDT", "exchange1", "exchange2", 50000.0, 50100.0, t);
+    depth_sim.submit(on_shared, 0.6, t);
+    depth_sim.process_until(t);
+    for (int k = 0; k < 300; ++k)
+    {
+        double price = 40000.0 + k;
+        filler->update_ask(price - 1.0, 0.0, ++t); // Previous level leaves the book
+        filler->update_ask(price, 1.0, t);
+        depth_sim.submit(ArbitrageOpportunity("BTCUSDT", "exchange3", "exchange2", price, 50100.0, t), 1.0, t);
+        depth_sim.process_until(t);
+    }
+    depth_sim.submit(on_shared, 0.6, ++t);
+    depth_sim.process_until(t);
+    bool remembers = shared_fills.size() == 2 && std::abs(shared_fills[0] - 0.6) < 1e-9 &&
+                     std::abs(shared_fills[1] - 0.4) < 1e-9;
+
+    std::cout << "\n=== Execution Simulator Performance ===" << std::endl;
+    std::cout << "Executions: " << stats.completed << " (full " << stats.fully_filled
+              << ", partial " << stats.partially_filled << ", missed " << stats.unfilled << "): "
+              << (fills ? "ok" : "WRONG") << std::endl;
+    std::cout << "Leg-risk unwinds: " << stats.unwinds << ": " << (unwinds ? "ok" : "WRONG") << std::endl;
+    std::cout << "Pooled orders: " << stats.pool_capacity << ": " << (pooled ? "ok" : "WRONG") << std::endl;
+    std::cout << "Consumed level remembered across eviction: " << (remembers ? "ok" : "WRONG") << std::endl;
+    std::cout << "Average latency per execution: " << static_cast<int>(duration.count() / num_executions) << " ns" << std::endl;
+    std::cout << "=======================================" << std::endl;
+    return fills && unwinds && pooled && remembers;
+}
+
 int main()
 {
     std::cout << "ArbiSim Performance Tests\n"
@@ -101,6 +1880,153 @@ int main()
     test_orderbook_performance();
     test_arbitrage_detection_performance();
 
+    if (!test_update_conflation_performance())
+    {
+        std::cout << "\nUpdate conflation test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_scenario_var_performance())
+    {
+        std::cout << "\nScenario VaR test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_execution_simulator_performance())
+    {
+        std::cout << "\nExecution simulator test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_opportunity_lifecycle())
+    {
+        std::cout << "\nOpportunity lifecycle test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_async_log_writer())
+    {
+        std::cout << "\nAsync log writer test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_columnar_log())
+    {
+        std::cout << "\nColumnar log test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_log_analytics())
+    {
+        std::cout << "\nLog analytics test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_dashboard_server())
+    {
+        std::cout << "\nDashboard server test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_dashboard_aggregation())
+    {
+        std::cout << "\nDashboard aggregation test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_latency_histogram())
+    {
+        std::cout << "\nLatency histogram test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_pipeline_trace())
+    {
+        std::cout << "\nPipeline trace test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_tsc_clock())
+    {
+        std::cout << "\nClock test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_metrics_registry())
+    {
+        std::cout << "\nMetrics registry test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_metrics_server())
+    {
+        std::cout << "\nMetrics endpoint test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_microbench())
+    {
+        std::cout << "\nMicrobenchmark harness test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_open_loop_load())
+    {
+        std::cout << "\nOpen-loop load test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_steady_state_allocations())
+    {
+        std::cout << "\nSteady-state allocation test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_simd_book_levels())
+    {
+        std::cout << "\nSIMD book levels test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_backtester())
+    {
+        std::cout << "\nBacktester test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_opportunity_queue())
+    {
+        std::cout << "\nOpportunity queue test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_cross_sizing())
+    {
+        std::cout << "\nCross sizing test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_fee_schedule())
+    {
+        std::cout << "\nFee schedule test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_risk_pipeline())
+    {
+        std::cout << "\nRisk pipeline test FAILED" << std::endl;
+        return 1;
+    }
+
+    if (!test_batch_allocation())
+    {
+        std::cout << "\nBatch allocation test FAILED" << std::endl;
+        return 1;
+    }
+
     std::cout << "\nAll performance tests completed!" << std::endl;
     return 0;
-}
\ No newline at end of file
+}
+
+// Counting operator new/delete (perf_test always builds with ARBISIM_ALLOC_TRACKING)
+ARBISIM_DEFINE_COUNTING_ALLOCATOR()
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "columnar_log.h"
+
+// Convert an .arbcol opportunity or trade log to CSV:
+//   arbcol_to_csv <log.arbcol> [out.csv]        (stdout when no output file is given)
+
+using namespace arbisim;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: arbcol_to_csv <log.arbcol> [out.csv]" << std::endl;
+        return 1;
+    }
+
+    std::string in_path = argv[1];
+    std::FILE *out = stdout;
+    if (argc > 2)
+    {
+        out = std::fopen(argv[2], "wb");
+        if (!out)
+        {
+            std::cerr << "Cannot open " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+
+    long long rows = -1;
+    switch (columnar_schema_id(in_path))
+    {
+    case OpportunityColumns::schema_id:
+        rows = columnar_to_csv<OpportunityColumns>(in_path, out);
+        break;
+    case TradeColumns::schema_id:
+        rows = columnar_to_csv<TradeColumns>(in_path, out);
+        break;
+    default:
+        std::cerr << in_path << " is not an .arbcol log" << std::endl;
+        break;
+    }
+
+    if (out != stdout)
+        std::fclose(out);
+    if (rows < 0)
+        return 1;
+
+    std::cerr << rows << " rows" << std::endl;
+    return 0;
+}
@@ -0,0 +1,245 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "log_analytics.h"
+
+// Group-by statistics over the engine's logs:
+//   log_analytics <log> [--by pair,hour,decision] [--events open,update,close]
+//                 [--from ns] [--to ns] [--threads N] [--csv out.csv]
+// <log> is arbitrage_opportunities.csv, arbitrage_opportunities.arbcol or trades.arbcol.
+// Opportunity rows report count, mean/p99 profit_bps, approval rate and latency
+// percentiles; trade rows report fills, volume, fees and P&L. --events only applies to
+// opportunity logs (default open,update); hours are UTC hours of day.
+
+using namespace arbisim;
+
+namespace
+{
+    unsigned parse_group_by(const std::string &list)
+    {
+        unsigned group_by = 0;
+        std::stringstream ss(list);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            if (item == "pair")
+                group_by |= analytics::BY_PAIR;
+            else if (item == "hour")
+                group_by |= analytics::BY_HOUR;
+            else if (item == "decision")
+                group_by |= analytics::BY_DECISION;
+            else if (!item.empty())
+                std::cerr << "Ignoring unknown group key '" << item << "'" << std::endl;
+        }
+        return group_by;
+    }
+
+    unsigned parse_events(const std::string &list)
+    {
+        unsigned mask = 0;
+        std::stringstream ss(list);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            if (item == "open")
+                mask |= 1u << static_cast<unsigned>(OpportunityEvent::OPEN);
+            else if (item == "update")
+                mask |= 1u << static_cast<unsigned>(OpportunityEvent::UPDATE);
+            else if (item == "close")
+                mask |= 1u << static_cast<unsigned>(OpportunityEvent::CLOSE);
+            else if (item == "all")
+                mask = 0x7;
+        }
+        return mask;
+    }
+
+    std::string group_label(const std::vector<std::string> &pairs, int pair, int hour, int decision)
+    {
+        std::string label;
+        if (pair >= 0)
+            label = pairs[pair];
+        if (hour >= 0)
+        {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "%02d:00", hour);
+            label += label.empty() ? buf : std::string(" ") + buf;
+        }
+        if (decision >= -1)
+            label += (label.empty() ? "" : " ") + std::string(analytics::decision_label(decision));
+        return label.empty() ? "all" : label;
+    }
+
+    void report_opportunities(const OpportunityTable &table, WorkStealingPool &pool, unsigned group_by,
+                              unsigned event_mask, const std::string &csv_path)
+    {
+        uint64_t start = timestamp_ns();
+        auto groups = aggregate_opportunities(table, pool, group_by, event_mask);
+        double query_ms = (timestamp_ns() - start) / 1e6;
+
+        std::cout << "\n"
+                  << std::left << std::setw(40) << "group" << std::right
+                  << std::setw(10) << "count" << std::setw(10) << "mean_bps" << std::setw(10) << "p99_bps"
+                  << std::setw(10) << "net_bps" << std::setw(10) << "approve%"
+                  << std::setw(10) << "p50_us" << std::setw(10) << "p99_us" << std::endl;
+
+        std::ofstream csv;
+        if (!csv_path.empty())
+        {
+            csv.open(csv_path);
+            csv << "group,count,mean_profit_bps,p99_profit_bps,mean_net_profit_bps,approval_rate,p50_latency_ns,p99_latency_ns\n";
+        }
+
+        for (const auto &g : groups)
+        {
+            std::string label = group_label(table.pairs.names, g.pair, g.hour, g.decision);
+            std::cout << std::left << std::setw(40) << label << std::right << std::fixed
+                      << std::setw(10) << g.count
+                      << std::setw(10) << std::setprecision(1) << g.mean_profit_bps
+                      << std::setw(10) << g.p99_profit_bps
+                      << std::setw(10) << g.mean_net_profit_bps
+                      << std::setw(10) << (g.approval_rate * 100)
+                      << std::setw(10) << std::setprecision(2) << (g.p50_latency_ns / 1000.0)
+                      << std::setw(10) << (g.p99_latency_ns / 1000.0) << std::endl;
+            if (csv.is_open())
+            {
+                csv << label << "," << g.count << "," << g.mean_profit_bps << "," << g.p99_profit_bps << ","
+                    << g.mean_net_profit_bps << "," << g.approval_rate << "," << g.p50_latency_ns << ","
+                    << g.p99_latency_ns << "\n";
+            }
+        }
+
+        std::cout << "\n"
+                  << groups.size() << " groups over " << table.size() << " rows in "
+                  << std::setprecision(2) << query_ms << " ms" << std::endl;
+    }
+
+    void report_trades(const TradeTable &table, WorkStealingPool &pool, unsigned group_by, const std::string &csv_path)
+    {
+        uint64_t start = timestamp_ns();
+        auto groups = aggregate_trades(table, pool, group_by);
+        double query_ms = (timestamp_ns() - start) / 1e6;
+
+        std::cout << "\n"
+                  << std::left << std::setw(40) << "group" << std::right
+                  << std::setw(10) << "fills" << std::setw(12) << "quantity" << std::setw(12) << "fees"
+                  << std::setw(14) << "pnl" << std::setw(12) << "mean_pnl" << std::setw(12) << "p01_pnl"
+                  << std::setw(8) << "win%" << std::endl;
+
+        std::ofstream csv;
+        if (!csv_path.empty())
+        {
+            csv.open(csv_path);
+            csv << "group,fills,quantity,fees,total_pnl,mean_pnl,p01_pnl,win_rate\n";
+        }
+
+        for (const auto &g : groups)
+        {
+            std::string label = group_label(table.pairs.names, g.pair, g.hour, -2);
+            std::cout << std::left << std::setw(40) << label << std::right << std::fixed
+                      << std::setw(10) << g.count
+                      << std::setw(12) << std::setprecision(4) << g.quantity
+                      << std::setw(12) << std::setprecision(2) << g.fees
+                      << std::setw(14) << g.total_pnl
+                      << std::setw(12) << g.mean_pnl
+                      << std::setw(12) << g.p01_pnl
+                      << std::setw(8) << std::setprecision(1) << (g.win_rate * 100) << std::endl;
+            if (csv.is_open())
+            {
+                csv << label << "," << g.count << "," << g.quantity << "," << g.fees << "," << g.total_pnl << ","
+                    << g.mean_pnl << "," << g.p01_pnl << "," << g.win_rate << "\n";
+            }
+        }
+
+        std::cout << "\n"
+                  << groups.size() << " groups over " << table.size() << " fills in "
+                  << std::setprecision(2) << query_ms << " ms" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string in_path;
+    std::string csv_path;
+    unsigned group_by = analytics::BY_PAIR;
+    unsigned event_mask = 0x3;
+    uint64_t from_ns = 0, to_ns = UINT64_MAX;
+    size_t threads = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--by" && i + 1 < argc)
+            group_by = parse_group_by(argv[++i]);
+        else if (arg == "--events" && i + 1 < argc)
+            event_mask = parse_events(argv[++i]);
+        else if (arg == "--from" && i + 1 < argc)
+            from_ns = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--to" && i + 1 < argc)
+            to_ns = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--csv" && i + 1 < argc)
+            csv_path = argv[++i];
+        else
+            in_path = arg;
+    }
+
+    if (in_path.empty())
+    {
+        std::cerr << "usage: log_analytics <log> [--by pair,hour,decision] [--events open,update,close]"
+                  << " [--from ns] [--to ns] [--threads N] [--csv out.csv]" << std::endl;
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    uint64_t start = timestamp_ns();
+    bool damaged = false;
+    uint64_t bad_rows = 0;
+
+    switch (columnar_schema_id(in_path))
+    {
+    case OpportunityColumns::schema_id:
+    case 0:
+    {
+        OpportunityTable table;
+        bool loaded = columnar_schema_id(in_path) == OpportunityColumns::schema_id
+                          ? analytics::load_columnar<OpportunityColumns>(in_path, pool, table, from_ns, to_ns, damaged)
+                          : analytics::load_opportunity_csv(in_path, pool, table, from_ns, to_ns, bad_rows);
+        if (!loaded)
+        {
+            std::cerr << "Cannot read " << in_path << std::endl;
+            return 1;
+        }
+        std::cout << "Loaded " << table.size() << " opportunities from " << in_path << " in "
+                  << std::fixed << std::setprecision(1) << (timestamp_ns() - start) / 1e6 << " ms on "
+                  << pool.thread_count() << " threads" << std::endl;
+        report_opportunities(table, pool, group_by, event_mask, csv_path);
+        break;
+    }
+    case TradeColumns::schema_id:
+    {
+        TradeTable table;
+        analytics::load_columnar<TradeColumns>(in_path, pool, table, from_ns, to_ns, damaged);
+        std::cout << "Loaded " << table.size() << " fills from " << in_path << " in "
+                  << std::fixed << std::setprecision(1) << (timestamp_ns() - start) / 1e6 << " ms on "
+                  << pool.thread_count() << " threads" << std::endl;
+        report_trades(table, pool, group_by, csv_path);
+        break;
+    }
+    default:
+        std::cerr << in_path << " has an unknown schema" << std::endl;
+        return 1;
+    }
+
+    if (damaged)
+        std::cerr << "warning: " << in_path << " ends in a damaged block; later rows were not read" << std::endl;
+    if (bad_rows > 0)
+        std::cerr << "warning: skipped " << bad_rows << " malformed rows" << std::endl;
+    if (!csv_path.empty())
+        std::cout << "Results written to " << csv_path << std::endl;
+    return 0;
+}
@@ -0,0 +1,665 @@
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arbisim_core.h"
+#include "async_log_writer.h"
+#include "columnar_log.h"
+#include "log_analytics.h"
+#include "microbench.h"
+#include "multi_exchange_feeds.h"
+#include "risk_management.h"
+
+// Component microbenchmarks over synthetic books, swept over book depth, venue count
+// and symbol count:
+//   microbench [--depth 1,5,10] [--venues 2,8,64] [--symbols 1,100,1000]
+//              [--filter book_,detect] [--reps N] [--warmup-ms N] [--rep-ms N]
+//              [--json out.json] [--compare baseline.json] [--simd scalar|sse2|avx2]
+// Every (venues, symbols) pair is one universe: symbols x venues books under one
+// detector, seeded around a shared mid with per-venue skew. Operations are drawn up
+// front from a fixed seed and spread uniformly over the universe, so larger universes
+// pay the cache misses a real engine would. Depth is the number of levels each side
+// holds (at most FastOrderBook::MAX_LEVELS). The xcore_* cases run once, outside the
+// sweep, and need a second core. Results are ns per operation; --json writes every
+// sample, and --compare prints median deltas against an earlier run. --simd narrows the
+// book kernels below the widest the CPU supports, for comparing paths on one machine.
+
+using namespace arbisim;
+
+namespace
+{
+    constexpr double MID = 30000.0;
+    constexpr double TICK = 1.0;
+    constexpr size_t CHUNK = 256;  // Operations per timed region
+    constexpr size_t STREAM = 8192; // Pre-drawn operations, cycled
+
+    struct BookOp
+    {
+        uint32_t book;
+        bool bid;
+        double price;
+        double quantity;
+    };
+
+    // symbols x venues books at a fixed depth, book index = symbol * venues + venue
+    struct Universe
+    {
+        size_t venues;
+        size_t symbols;
+        size_t depth;
+        std::vector<std::string> venue_names;
+        std::vector<std::string> symbol_names;
+        std::unique_ptr<ArbitrageDetector> detector;
+        std::vector<FastOrderBook *> books;
+        std::vector<double> best_bid; // Level 0 of each book as seeded
+        std::vector<double> best_ask;
+
+        Universe(size_t v, size_t s, size_t d, std::mt19937_64 &rng)
+            : venues(v), symbols(s), depth(d), detector(std::make_unique<ArbitrageDetector>())
+        {
+            for (size_t i = 0; i < venues; ++i)
+                venue_names.push_back("venue" + std::to_string(i));
+            for (size_t i = 0; i < symbols; ++i)
+                symbol_names.push_back("SYM" + std::to_string(i));
+            for (const auto &symbol : symbol_names)
+                for (const auto &venue : venue_names)
+                    detector->add_orderbook(symbol, venue);
+
+            // Venues quote a few ticks either side of the mid: no cross until a stream moves one
+            std::uniform_int_distribution<int> skew(-3, 3);
+            std::uniform_real_distribution<double> qty(0.1, 2.0);
+            uint64_t now = timestamp_ns();
+            for (const auto &symbol : symbol_names)
+                for (const auto &venue : venue_names)
+                {
+                    FastOrderBook *book = detector->get_orderbook(symbol, venue);
+                    double bid = MID - TICK * (2 + skew(rng));
+                    double ask = MID + TICK * (2 + skew(rng));
+                    for (size_t level = 0; level < depth; ++level)
+                    {
+                        book->update_bid(bid - level * TICK, qty(rng), now);
+                        book->update_ask(ask + level * TICK, qty(rng), now);
+                    }
+                    books.push_back(book);
+                    best_bid.push_back(bid);
+                    best_ask.push_back(ask);
+                }
+        }
+
+        size_t size() const { return books.size(); }
+
+        double level_price(uint32_t book, bool bid, double level) const
+        {
+            return bid ? best_bid[book] - level * TICK : best_ask[book] + level * TICK;
+        }
+
+        void apply(const BookOp &op, uint64_t now) const
+        {
+            if (op.bid)
+                books[op.book]->update_bid(op.price, op.quantity, now);
+            else
+                books[op.book]->update_ask(op.price, op.quantity, now);
+        }
+
+        // Put a side's worst seeded level back if an insert pushed it off the book
+        void restore_tail(uint32_t book, bool bid, uint64_t now) const
+        {
+            BookOp op{book, bid, level_price(book, bid, static_cast<double>(depth - 1)), 1.0};
+            apply(op, now);
+        }
+    };
+
+    // Chunks of inserts into the gaps between seeded levels. Each book takes at most
+    // as many inserts per chunk as it has free levels (one when full), so deleting the
+    // same chunk returns it to its seeded depth.
+    std::vector<std::vector<BookOp>> draw_insert_chunks(const Universe &u, std::mt19937_64 &rng)
+    {
+        size_t per_book = std::min(std::max<size_t>(1, FastOrderBook::MAX_LEVELS - u.depth), 2 * u.depth);
+        size_t chunk_size = std::min(CHUNK, u.size() * per_book);
+        std::uniform_int_distribution<uint32_t> book(0, static_cast<uint32_t>(u.size() - 1));
+        std::uniform_int_distribution<size_t> gap(0, u.depth - 1);
+        std::uniform_real_distribution<double> qty(0.1, 2.0);
+
+        std::vector<std::vector<BookOp>> chunks(std::max<size_t>(1, STREAM / chunk_size));
+        std::vector<size_t> taken(u.size());
+        for (auto &chunk : chunks)
+        {
+            std::fill(taken.begin(), taken.end(), 0);
+            while (chunk.size() < chunk_size)
+            {
+                uint32_t b = book(rng);
+                if (taken[b] == per_book)
+                    continue;
+                bool bid = rng() & 1;
+                double price = u.level_price(b, bid, static_cast<double>(gap(rng)) + 0.5);
+                bool duplicate = false;
+                for (const auto &op : chunk)
+                    duplicate |= op.book == b && op.bid == bid && op.price == price;
+                if (duplicate)
+                    continue;
+                taken[b]++;
+                chunk.push_back({b, bid, price, qty(rng)});
+            }
+        }
+        return chunks;
+    }
+
+    void bench_book(bench::BenchRunner &runner, const Universe &u, std::mt19937_64 &rng)
+    {
+        bench::Params params = {{"depth", static_cast<long long>(u.depth)},
+                                {"venues", static_cast<long long>(u.venues)},
+                                {"symbols", static_cast<long long>(u.symbols)}};
+        uint64_t now = timestamp_ns();
+
+        std::vector<std::vector<BookOp>> inserts = draw_insert_chunks(u, rng);
+        bool full = u.depth == FastOrderBook::MAX_LEVELS;
+        auto remove = [&](const std::vector<BookOp> &chunk)
+        {
+            for (BookOp op : chunk)
+            {
+                op.quantity = 0.0;
+                u.apply(op, now);
+            }
+        };
+        auto repair = [&](const std::vector<BookOp> &chunk)
+        {
+            if (full)
+                for (const auto &op : chunk)
+                    u.restore_tail(op.book, op.bid, now);
+        };
+
+        size_t next = 0;
+        runner.run("book_insert", params, inserts[0].size(), [&]()
+                   {
+            const auto &chunk = inserts[next++ % inserts.size()];
+            uint64_t ns = bench::timed([&]()
+                                       {
+                for (const auto &op : chunk)
+                    u.apply(op, now); });
+            remove(chunk);
+            repair(chunk);
+            return ns; });
+
+        runner.run("book_delete", params, inserts[0].size(), [&]()
+                   {
+            const auto &chunk = inserts[next++ % inserts.size()];
+            for (const auto &op : chunk)
+                u.apply(op, now);
+            uint64_t ns = bench::timed([&]()
+                                       { remove(chunk); });
+            repair(chunk);
+            return ns; });
+
+        // Quantity changes at a random seeded level
+        std::vector<BookOp> modifies(STREAM);
+        {
+            std::uniform_int_distribution<uint32_t> book(0, static_cast<uint32_t>(u.size() - 1));
+            std::uniform_int_distribution<size_t> level(0, u.depth - 1);
+            std::uniform_real_distribution<double> qty(0.1, 2.0);
+            for (auto &op : modifies)
+            {
+                op.book = book(rng);
+                op.bid = rng() & 1;
+                op.price = u.level_price(op.book, op.bid, static_cast<double>(level(rng)));
+                op.quantity = qty(rng);
+            }
+        }
+        runner.run("book_modify", params, CHUNK, [&]()
+                   {
+            const BookOp *ops = &modifies[(next++ * CHUNK) % STREAM];
+            return bench::timed([&]()
+                                {
+                for (size_t i = 0; i < CHUNK; ++i)
+                    u.apply(ops[i], now); }); });
+
+        std::vector<uint32_t> reads(STREAM);
+        {
+            std::uniform_int_distribution<uint32_t> book(0, static_cast<uint32_t>(u.size() - 1));
+            for (auto &b : reads)
+                b = book(rng);
+        }
+        runner.run("bbo_read", params, CHUNK, [&]()
+                   {
+            const uint32_t *books = &reads[(next++ * CHUNK) % STREAM];
+            return bench::timed([&]()
+                                {
+                double sum = 0.0;
+                for (size_t i = 0; i < CHUNK; ++i)
+                {
+                    auto [bid, ask] = u.books[books[i]]->get_best_bid_ask();
+                    sum += bid + ask;
+                }
+                bench::do_not_optimize(sum); }); });
+    }
+
+    // Book update then a detection pass over its symbol, as the market thread runs
+    // them. Most updates change a level's quantity; a few lift one venue's bid through
+    // the others' asks, opening crosses that the paired delete closes again.
+    void bench_detect(bench::BenchRunner &runner, const Universe &u, std::mt19937_64 &rng)
+    {
+        bench::Params params = {{"depth", static_cast<long long>(u.depth)},
+                                {"venues", static_cast<long long>(u.venues)},
+                                {"symbols", static_cast<long long>(u.symbols)}};
+        constexpr size_t DETECT_CHUNK = 64;
+
+        std::vector<BookOp> stream;
+        std::vector<int64_t> crossed(u.symbols, -1); // Book holding the lifted bid, per symbol
+        std::uniform_int_distribution<size_t> symbol(0, u.symbols - 1);
+        std::uniform_int_distribution<size_t> venue(0, u.venues - 1);
+        std::uniform_int_distribution<size_t> level(0, u.depth - 1);
+        std::uniform_real_distribution<double> qty(0.1, 2.0);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const double lifted = MID * 1.003; // ~30 bps through the other venues' asks
+        auto modify = [&](uint32_t b)
+        {
+            bool bid = rng() & 1;
+            stream.push_back({b, bid, u.level_price(b, bid, static_cast<double>(level(rng))), qty(rng)});
+        };
+        while (stream.size() < STREAM)
+        {
+            size_t s = symbol(rng);
+            uint32_t b = static_cast<uint32_t>(s * u.venues + venue(rng));
+            if (crossed[s] >= 0 && unit(rng) < 0.5)
+            {
+                stream.push_back({static_cast<uint32_t>(crossed[s]), true, lifted, 0.0});
+                crossed[s] = -1;
+            }
+            else if (crossed[s] < 0 && unit(rng) < 0.05)
+            {
+                stream.push_back({b, true, lifted, qty(rng)});
+                crossed[s] = b;
+            }
+            else
+            {
+                modify(b);
+            }
+        }
+        // Close what is still open so the stream can be replayed from the start
+        for (size_t s = 0; s < u.symbols; ++s)
+            if (crossed[s] >= 0)
+                stream.push_back({static_cast<uint32_t>(crossed[s]), true, lifted, 0.0});
+        while (stream.size() % DETECT_CHUNK)
+            modify(static_cast<uint32_t>(symbol(rng) * u.venues + venue(rng)));
+
+        size_t next = 0;
+        size_t events = 0;
+        runner.run("detect", params, DETECT_CHUNK, [&]()
+                   {
+            const BookOp *ops = &stream[(next++ * DETECT_CHUNK) % stream.size()];
+            return bench::timed([&]()
+                                {
+                for (size_t i = 0; i < DETECT_CHUNK; ++i)
+                {
+                    uint64_t now = timestamp_ns();
+                    u.apply(ops[i], now);
+                    events += u.detector->check_arbitrage(u.symbol_names[ops[i].book / u.venues], now).size();
+                }
+                bench::do_not_optimize(events); }); });
+    }
+
+    // Opportunities over random symbol and venue pairs, with net profit around the
+    // threshold so the pipeline both approves and rejects
+    std::vector<ArbitrageOpportunity> draw_opportunities(size_t venues, size_t symbols, std::mt19937_64 &rng)
+    {
+        std::uniform_int_distribution<size_t> symbol(0, symbols - 1);
+        std::uniform_int_distribution<size_t> venue(0, venues - 1);
+        std::uniform_real_distribution<double> edge_bps(20.0, 45.0);
+        std::uniform_real_distribution<double> qty(0.01, 1.0);
+        uint64_t now = timestamp_ns();
+
+        std::vector<ArbitrageOpportunity> opps;
+        while (opps.size() < STREAM)
+        {
+            size_t buy = venue(rng), sell = venue(rng);
+            if (buy == sell)
+                continue;
+            double ask = MID + TICK * (rng() % 5);
+            ArbitrageOpportunity opp("SYM" + std::to_string(symbol(rng)), "venue" + std::to_string(buy),
+                                     "venue" + std::to_string(sell), ask, ask * (1.0 + edge_bps(rng) / 10000.0),
+                                     now, 10.0, 10.0, now + opps.size());
+            opp.max_quantity = qty(rng);
+            opps.push_back(std::move(opp));
+        }
+        return opps;
+    }
+
+    void bench_risk(bench::BenchRunner &runner, size_t venues, size_t symbols, std::mt19937_64 &rng)
+    {
+        bench::Params params = {{"venues", static_cast<long long>(venues)},
+                                {"symbols", static_cast<long long>(symbols)}};
+        std::vector<ArbitrageOpportunity> opps = draw_opportunities(venues, symbols, rng);
+
+#ifdef HAVE_BOOST
+        RiskManager risk;
+#else
+        SimpleRiskManager risk;
+#endif
+        // Open small positions across the universe so position lookups hit a full map
+        RiskLimits limits;
+        limits.max_total_exposure = 1e9;
+        risk.set_risk_limits(limits);
+        for (size_t i = 0; i < opps.size(); i += 4)
+            risk.execute_trade(opps[i], 0.001);
+
+        size_t next = 0;
+        runner.run("risk_check", params, CHUNK, [&]()
+                   {
+            const ArbitrageOpportunity *batch = &opps[(next++ * CHUNK) % STREAM];
+            return bench::timed([&]()
+                                {
+                for (size_t i = 0; i < CHUNK; ++i)
+                    bench::do_not_optimize(risk.assess_opportunity(batch[i]).decision); }); });
+
+        // One detection pass's worth of opportunities per batch
+        constexpr size_t BATCH = 16;
+        std::vector<std::vector<ArbitrageOpportunity>> batches;
+        for (size_t i = 0; i + BATCH <= opps.size(); i += BATCH)
+            batches.emplace_back(opps.begin() + i, opps.begin() + i + BATCH);
+        runner.run("risk_batch", params, BATCH, [&]()
+                   {
+            const auto &batch = batches[next++ % batches.size()];
+            return bench::timed([&]()
+                                { bench::do_not_optimize(risk.assess_batch(batch).size()); }); });
+    }
+
+    void bench_logs(bench::BenchRunner &runner, size_t venues, size_t symbols, std::mt19937_64 &rng)
+    {
+        bench::Params params = {{"venues", static_cast<long long>(venues)},
+                                {"symbols", static_cast<long long>(symbols)}};
+        std::vector<ArbitrageOpportunity> opps = draw_opportunities(venues, symbols, rng);
+        std::vector<OpportunityRecord> records;
+        for (const auto &opp : opps)
+            records.emplace_back(opp, opp.net_profit_bps, static_cast<int>(rng() % 4));
+
+        std::vector<char> buffer(CHUNK * 256);
+        size_t next = 0;
+        runner.run("encode_csv", params, CHUNK, [&]()
+                   {
+            const OpportunityRecord *batch = &records[(next++ * CHUNK) % STREAM];
+            return bench::timed([&]()
+                                {
+                char *p = buffer.data(), *end = p + buffer.size();
+                for (size_t i = 0; i < CHUNK; ++i)
+                    p = csv::format_opportunity_csv(batch[i], p, end);
+                bench::do_not_optimize(p); }); });
+
+        // Blocks of the writer's default row count
+        constexpr size_t BLOCK = 1024;
+        std::vector<std::vector<OpportunityRecord>> blocks;
+        for (size_t i = 0; i + BLOCK <= records.size(); i += BLOCK)
+            blocks.emplace_back(records.begin() + i, records.begin() + i + BLOCK);
+        columnar::BlockEncoder encoder;
+        runner.run("encode_columnar", params, BLOCK, [&]()
+                   {
+            const auto &block = blocks[next++ % blocks.size()];
+            return bench::timed([&]()
+                                {
+                encoder.reset();
+                OpportunityColumns::encode(block, encoder);
+                bench::do_not_optimize(encoder.body().size()); }); });
+
+        std::vector<std::string> rows;
+        for (const auto &r : records)
+        {
+            char *end = csv::format_opportunity_csv(r, buffer.data(), buffer.data() + buffer.size());
+            rows.emplace_back(buffer.data(), end - 1); // Without the newline
+        }
+        runner.run("parse_log_row", params, CHUNK, [&]()
+                   {
+            const std::string *batch = &rows[(next++ * CHUNK) % STREAM];
+            return bench::timed([&]()
+                                {
+                OpportunityRecord r;
+                for (size_t i = 0; i < CHUNK; ++i)
+                    bench::do_not_optimize(analytics::parse_opportunity_csv(batch[i].data(), batch[i].data() + batch[i].size(), r));
+                bench::do_not_optimize(r.detected_at_ns); }); });
+
+        // Ticker messages in the key=value form the feed parser reads
+        std::vector<std::string> messages;
+        for (const auto &opp : opps)
+        {
+            std::ostringstream msg;
+            msg << std::fixed << std::setprecision(2) << "symbol=" << opp.symbol << ",exchange=" << opp.buy_exchange
+                << ",bid=" << opp.buy_price - TICK << ",ask=" << opp.buy_price << ",bid_qty=" << opp.max_quantity
+                << ",ask_qty=" << opp.max_quantity << ",ts=" << opp.detected_at_ns;
+            messages.push_back(msg.str());
+        }
+        constexpr size_t MESSAGES = 64;
+        runner.run("parse_feed_message", params, MESSAGES, [&]()
+                   {
+            const std::string *batch = &messages[(next++ * MESSAGES) % STREAM];
+            return bench::timed([&]()
+                                {
+                for (size_t i = 0; i < MESSAGES; ++i)
+                {
+                    SimpleDataParser parser;
+                    parser.parse_key_value_pairs(batch[i]);
+                    bench::do_not_optimize(parser.get_double("bid"));
+                } }); });
+    }
+
+    std::vector<size_t> parse_list(const std::string &list, size_t lo, size_t hi)
+    {
+        std::vector<size_t> values;
+        std::stringstream ss(list);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            size_t v = std::strtoul(item.c_str(), nullptr, 10);
+            if (v >= lo && v <= hi)
+                values.push_back(v);
+            else if (!item.empty())
+                std::cerr << "Ignoring " << item << " (range " << lo << ".." << hi << ")" << std::endl;
+        }
+        return values;
+    }
+
+    // One thread reads or writes a book's ask side while another (writer=1) keeps
+    // rewriting its bid side, as two cores would if the sides had different writers.
+    // No data is shared between the two, so any slowdown against writer=0 is the layout
+    // putting both on one cache line.
+    void bench_cross_core(bench::BenchRunner &runner)
+    {
+        bool wanted = false;
+        for (const char *id : {"xcore_ask_read/writer=0", "xcore_ask_read/writer=1",
+                               "xcore_ask_write/writer=0", "xcore_ask_write/writer=1"})
+            wanted |= runner.selected(id);
+        if (!wanted)
+            return;
+        if (std::thread::hardware_concurrency() < 2)
+        {
+            std::cout << "xcore_*: skipped, needs at least two cores" << std::endl;
+            return;
+        }
+
+        FastOrderBook book("BTCUSDT", "binance");
+        for (size_t i = 0; i < FastOrderBook::MAX_LEVELS; ++i)
+        {
+            book.update_bid(MID - TICK * (i + 1), 1.0, 1);
+            book.update_ask(MID + TICK * (i + 1), 1.0, 1);
+        }
+
+        uint64_t next = 0;
+        for (long long writer : {0LL, 1LL})
+        {
+            std::atomic<bool> stop{false};
+            std::thread bid_writer;
+            if (writer)
+            {
+                bid_writer = std::thread([&]()
+                                         {
+                    for (uint64_t n = 1; !stop.load(std::memory_order_relaxed); ++n)
+                        book.update_bid(MID - TICK * (1 + n % FastOrderBook::MAX_LEVELS), 1.0 + (n & 7), n); });
+            }
+
+            runner.run("xcore_ask_read", {{"writer", writer}}, CHUNK, [&]()
+                       { return bench::timed([&]()
+                                             {
+                double sum = 0.0;
+                for (size_t i = 0; i < CHUNK; ++i)
+                    sum += book.ask_depth() + book.ask_level(i & 1).price + book.exchange().size();
+                bench::do_not_optimize(sum); }); });
+            runner.run("xcore_ask_write", {{"writer", writer}}, CHUNK, [&]()
+                       { return bench::timed([&]()
+                                             {
+                for (size_t i = 0; i < CHUNK; ++i, ++next)
+                    book.update_ask(MID + TICK * (1 + next % FastOrderBook::MAX_LEVELS), 1.0 + (next & 7), next); }); });
+
+            stop.store(true);
+            if (bid_writer.joinable())
+                bid_writer.join();
+        }
+    }
+
+    void compare(const std::vector<bench::BenchResult> &results, const std::string &path)
+    {
+        std::vector<std::pair<std::string, double>> baseline;
+        if (!bench::read_json_medians(path, baseline))
+        {
+            std::cerr << "Cannot read " << path << std::endl;
+            return;
+        }
+        std::cout << "\nMedian vs " << path << ":\n"
+                  << std::left << std::setw(52) << "benchmark (ns/op)" << std::right << std::setw(10) << "baseline"
+                  << std::setw(10) << "now" << std::setw(9) << "change" << std::endl;
+        for (const auto &r : results)
+            for (const auto &[id, median] : baseline)
+                if (id == r.id() && median > 0.0)
+                {
+                    double change = (r.summary.median - median) / median * 100.0;
+                    std::cout << std::left << std::setw(52) << id << std::right << std::fixed << std::setprecision(1)
+                              << std::setw(10) << median << std::setw(10) << r.summary.median
+                              << std::setw(8) << std::showpos << change << std::noshowpos << "%" << std::endl;
+                }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string depths = "1,5,10", venues = "2,8,64", symbols = "1,100,1000";
+    std::string json_path, compare_path, filter, simd_level;
+    bench::BenchConfig config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--depth" && i + 1 < argc)
+            depths = argv[++i];
+        else if (arg == "--venues" && i + 1 < argc)
+            venues = argv[++i];
+        else if (arg == "--symbols" && i + 1 < argc)
+            symbols = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--reps" && i + 1 < argc)
+            config.repetitions = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--warmup-ms" && i + 1 < argc)
+            config.warmup_ns = std::strtoull(argv[++i], nullptr, 10) * 1000000ULL;
+        else if (arg == "--rep-ms" && i + 1 < argc)
+            config.min_rep_ns = std::strtoull(argv[++i], nullptr, 10) * 1000000ULL;
+        else if (arg == "--json" && i + 1 < argc)
+            json_path = argv[++i];
+        else if (arg == "--compare" && i + 1 < argc)
+            compare_path = argv[++i];
+        else if (arg == "--simd" && i + 1 < argc)
+            simd_level = argv[++i];
+        else
+        {
+            std::cerr << "usage: microbench [--depth 1,5,10] [--venues 2,8,64] [--symbols 1,100,1000]"
+                      << " [--filter book_,detect] [--reps N] [--warmup-ms N] [--rep-ms N]"
+                      << " [--json out.json] [--compare baseline.json] [--simd scalar|sse2|avx2]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!simd_level.empty())
+    {
+        simd::Level wanted = simd_level == "avx2"   ? simd::Level::AVX2
+                             : simd_level == "sse2" ? simd::Level::SSE2
+                                                    : simd::Level::SCALAR;
+        if (simd_level != simd::level_name(wanted))
+        {
+            std::cerr << "Unknown --simd level " << simd_level << std::endl;
+            return 1;
+        }
+        simd::set_level(wanted);
+    }
+
+    std::vector<size_t> depth_list = parse_list(depths, 1, FastOrderBook::MAX_LEVELS);
+    std::vector<size_t> venue_list = parse_list(venues, 2, 64);
+    std::vector<size_t> symbol_list = parse_list(symbols, 1, 1000);
+    if (depth_list.empty() || venue_list.empty() || symbol_list.empty())
+    {
+        std::cerr << "Nothing to run" << std::endl;
+        return 1;
+    }
+
+    bench::BenchRunner runner(config);
+    runner.set_filter(filter);
+#ifndef ARBISIM_OPTIMIZED_BUILD
+    std::cout << "warning: unoptimized build; numbers are not representative of a release build\n";
+#endif
+    std::cout << "Clock: " << (TscClock::instance().uses_tsc() ? "TSC" : "system") << ", read overhead "
+              << bench::clock_overhead_ns() << " ns subtracted per timed region, book kernels "
+              << simd::level_name(simd::active_level()) << "\n"
+              << std::endl;
+    runner.print_header();
+
+    std::mt19937_64 rng(42);
+    auto print_new = [&](size_t &printed)
+    {
+        for (; printed < runner.results().size(); ++printed)
+            runner.print(runner.results()[printed]);
+    };
+    size_t printed = 0;
+    for (size_t v : venue_list)
+        for (size_t s : symbol_list)
+        {
+            for (size_t d : depth_list)
+            {
+                // Building the books is the slow part; skip it when the filter leaves nothing
+                bench::BenchResult probe;
+                probe.params = {{"depth", static_cast<long long>(d)},
+                                {"venues", static_cast<long long>(v)},
+                                {"symbols", static_cast<long long>(s)}};
+                bool wanted = false;
+                for (const char *name : {"book_insert", "book_delete", "book_modify", "bbo_read", "detect"})
+                {
+                    probe.name = name;
+                    wanted |= runner.selected(probe.id());
+                }
+                if (wanted)
+                {
+                    Universe universe(v, s, d, rng);
+                    bench_book(runner, universe, rng);
+                    bench_detect(runner, universe, rng);
+                    print_new(printed);
+                }
+            }
+            bench_risk(runner, v, s, rng);
+            bench_logs(runner, v, s, rng);
+            print_new(printed);
+        }
+    bench_cross_core(runner);
+    print_new(printed);
+
+    if (!json_path.empty())
+    {
+        if (!runner.write_json(json_path))
+        {
+            std::cerr << "Cannot write " << json_path << std::endl;
+            return 1;
+        }
+        std::cout << "\n"
+                  << runner.results().size() << " results written to " << json_path << std::endl;
+    }
+    if (!compare_path.empty())
+        compare(runner.results(), compare_path);
+    return 0;
+}